@@ -0,0 +1,582 @@
+// Runs the benchmark executables registered with `add_sandbox_benchmark` (see
+// the root CMakeLists.txt) and checks the results against a baseline.
+//
+// Every benchmark is started `warmup` times without being measured and then
+// `runs` times, optionally pinned to one CPU: that steadies single-threaded
+// numbers but serializes the multithreaded benchmarks. For every run the
+// runner records the wall time; the allocation count and the peak RSS are
+// reported by the benchmark itself (common/bench-harness.cpp) through the file
+// named by SANDBOX_BENCH_STATS. Each metric is the best (lowest) of the runs.
+//
+// Usage: bench-runner --manifest <file> --output <json>
+//                     [--baseline <json>] [--update-baseline]
+//                     [--cpu <n>, -1 (default) to not pin] [--warmup <n>]
+//                     [--runs <n>]
+//                     [--time-tolerance <ratio>] [--rss-tolerance <ratio>]
+//                     [--alloc-tolerance <ratio>]
+//                     [--log-dir <dir>] [--filter <substring>]
+//
+// The manifest has a benchmark per line: name, executable and arguments,
+// separated by tabs.
+//
+// Exit code: 0 - ok, 1 - a regression or a benchmark failed, 2 - bad usage or
+// an I/O error.
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::string manifest;
+    std::string output;
+    std::string baseline;
+    std::string log_dir;
+    std::string filter;
+    bool update_baseline{false};
+    int cpu{-1};
+    int warmup{1};
+    int runs{3};
+    double time_tolerance{0.15};
+    double rss_tolerance{0.10};
+    double alloc_tolerance{0.05};
+};
+
+// Differences below these are noise whatever the ratio is
+constexpr double kTimeFloorMs{5.0};
+constexpr double kRssFloorKb{1024.0};
+constexpr double kAllocFloor{16.0};
+
+struct Benchmark {
+    std::string name;
+    std::vector<std::string> argv; // The executable and its arguments
+};
+
+struct Result {
+    std::string name;
+    std::string command;
+    double wall_ms{0};
+    double peak_rss_kb{0};
+    double allocations{0};
+    bool failed{false};
+};
+
+[[noreturn]] void usage(const char *message) {
+    std::fprintf(stderr, "bench-runner: %s\n", message);
+    std::fprintf(stderr,
+                 "usage: bench-runner --manifest <file> --output <json> "
+                 "[--baseline <json>] [--update-baseline] [--cpu <n>] "
+                 "[--warmup <n>] [--runs <n>] [--time-tolerance <ratio>] "
+                 "[--rss-tolerance <ratio>] [--alloc-tolerance <ratio>] "
+                 "[--log-dir <dir>] [--filter <substring>]\n");
+    std::exit(2);
+}
+
+// The whole of `text`, or usage()
+template <class T> T parse_number(std::string_view text) {
+    T value{};
+    const auto [end, error] =
+        std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc{} || end != text.data() + text.size()) {
+        usage("bad number");
+    }
+    return value;
+}
+
+Options parse_options(int argc, char **argv) {
+    Options options;
+    for (int k = 1; k < argc; ++k) {
+        const std::string_view arg{argv[k]};
+        auto value = [&]() -> std::string {
+            if (k + 1 >= argc) {
+                usage("missing option value");
+            }
+            return argv[++k];
+        };
+        if (arg == "--manifest") {
+            options.manifest = value();
+        } else if (arg == "--output") {
+            options.output = value();
+        } else if (arg == "--baseline") {
+            options.baseline = value();
+        } else if (arg == "--update-baseline") {
+            options.update_baseline = true;
+        } else if (arg == "--log-dir") {
+            options.log_dir = value();
+        } else if (arg == "--filter") {
+            options.filter = value();
+        } else if (arg == "--cpu") {
+            options.cpu = parse_number<int>(value());
+        } else if (arg == "--warmup") {
+            options.warmup = std::max(0, parse_number<int>(value()));
+        } else if (arg == "--runs") {
+            options.runs = std::max(1, parse_number<int>(value()));
+        } else if (arg == "--time-tolerance") {
+            options.time_tolerance = parse_number<double>(value());
+        } else if (arg == "--rss-tolerance") {
+            options.rss_tolerance = parse_number<double>(value());
+        } else if (arg == "--alloc-tolerance") {
+            options.alloc_tolerance = parse_number<double>(value());
+        } else {
+            usage("unknown option");
+        }
+    }
+    if (options.manifest.empty() || options.output.empty()) {
+        usage("--manifest and --output are required");
+    }
+    if (options.update_baseline && options.baseline.empty()) {
+        usage("--update-baseline requires --baseline");
+    }
+    return options;
+}
+
+std::vector<Benchmark> read_manifest(const std::string &path,
+                                     const std::string &filter) {
+    std::ifstream in{path};
+    if (!in) {
+        throw std::runtime_error{"can't read the manifest " + path};
+    }
+    std::vector<Benchmark> benchmarks;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::vector<std::string> fields;
+        std::istringstream fields_in{line};
+        for (std::string field; std::getline(fields_in, field, '\t');) {
+            if (!field.empty()) {
+                fields.push_back(std::move(field));
+            }
+        }
+        if (fields.size() < 2) {
+            continue;
+        }
+        if (fields[0].find(filter) == std::string::npos) {
+            continue;
+        }
+        Benchmark benchmark;
+        benchmark.name = std::move(fields[0]);
+        benchmark.argv.assign(std::make_move_iterator(fields.begin() + 1),
+                              std::make_move_iterator(fields.end()));
+        benchmarks.push_back(std::move(benchmark));
+    }
+    return benchmarks;
+}
+
+// Just enough JSON to read back what `write_results` produces
+class JsonReader {
+  public:
+    explicit JsonReader(std::string text) : text_(std::move(text)) {}
+
+    std::map<std::string, Result> ReadResults(void) {
+        std::map<std::string, Result> results;
+        _expect('{');
+        if (_consume('}')) {
+            return results;
+        }
+        do {
+            const auto key = _string();
+            _expect(':');
+            if (key != "benchmarks") {
+                _skip_value();
+                continue;
+            }
+            _expect('[');
+            if (_consume(']')) {
+                continue;
+            }
+            do {
+                auto result = ReadResult();
+                results[result.name] = std::move(result);
+            } while (_consume(','));
+            _expect(']');
+        } while (_consume(','));
+        _expect('}');
+        return results;
+    }
+
+    // An object with the fields of `Result`, the others are ignored
+    Result ReadResult(void) {
+        Result result;
+        _expect('{');
+        if (_consume('}')) {
+            return result;
+        }
+        do {
+            const auto key = _string();
+            _expect(':');
+            if (key == "name") {
+                result.name = _string();
+            } else if (key == "command") {
+                result.command = _string();
+            } else if (key == "wall_ms") {
+                result.wall_ms = _number();
+            } else if (key == "peak_rss_kb") {
+                result.peak_rss_kb = _number();
+            } else if (key == "allocations") {
+                result.allocations = _number();
+            } else {
+                _skip_value();
+            }
+        } while (_consume(','));
+        _expect('}');
+        return result;
+    }
+
+  private:
+    void _skip_ws(void) {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(
+                                          text_[pos_]))) {
+            ++pos_;
+        }
+    }
+
+    bool _consume(char ch) {
+        _skip_ws();
+        if (pos_ < text_.size() && text_[pos_] == ch) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    void _expect(char ch) {
+        if (!_consume(ch)) {
+            throw std::runtime_error{std::string{"JSON: expected '"} + ch +
+                                     "' at offset " + std::to_string(pos_)};
+        }
+    }
+
+    std::string _string(void) {
+        _expect('"');
+        std::string result;
+        while (pos_ < text_.size() && text_[pos_] != '"') {
+            if (text_[pos_] == '\\' && pos_ + 1 < text_.size()) {
+                ++pos_;
+            }
+            result += text_[pos_++];
+        }
+        _expect('"');
+        return result;
+    }
+
+    double _number(void) {
+        _skip_ws();
+        const char *begin = text_.c_str() + pos_;
+        char *end = nullptr;
+        const double value = std::strtod(begin, &end);
+        if (end == begin) {
+            throw std::runtime_error{"JSON: expected a number at offset " +
+                                     std::to_string(pos_)};
+        }
+        pos_ += static_cast<std::size_t>(end - begin);
+        return value;
+    }
+
+    void _skip_value(void) {
+        _skip_ws();
+        if (pos_ >= text_.size()) {
+            throw std::runtime_error{"JSON: unexpected end"};
+        }
+        const char ch = text_[pos_];
+        if (ch == '"') {
+            _string();
+        } else if (ch == '{' || ch == '[') {
+            const char close = ch == '{' ? '}' : ']';
+            ++pos_;
+            if (_consume(close)) {
+                return;
+            }
+            do {
+                if (ch == '{') {
+                    _string();
+                    _expect(':');
+                }
+                _skip_value();
+            } while (_consume(','));
+            _expect(close);
+        } else {
+            // A number, true, false or null
+            while (pos_ < text_.size() && !std::strchr(",}] \t\r\n", text_[pos_])) {
+                ++pos_;
+            }
+        }
+    }
+
+    std::string text_;
+    std::size_t pos_{0};
+};
+
+std::map<std::string, Result> read_results(const std::string &path) {
+    std::ifstream in{path};
+    if (!in) {
+        return {};
+    }
+    std::ostringstream text;
+    text << in.rdbuf();
+    return JsonReader{text.str()}.ReadResults();
+}
+
+std::string json_escape(std::string_view str) {
+    std::string result;
+    for (const char ch : str) {
+        if (ch == '"' || ch == '\\') {
+            result += '\\';
+        }
+        result += ch;
+    }
+    return result;
+}
+
+void write_results(const std::string &path, const Options &options,
+                   const std::vector<Result> &results) {
+    FILE *out = std::fopen(path.c_str(), "w");
+    if (out == nullptr) {
+        throw std::runtime_error{"can't write " + path};
+    }
+    std::fprintf(out, "{\n  \"cpu\": %d,\n  \"warmup\": %d,\n  \"runs\": %d,\n",
+                 options.cpu, options.warmup, options.runs);
+    std::fprintf(out, "  \"benchmarks\": [");
+    for (std::size_t k = 0; k < results.size(); ++k) {
+        const auto &result = results[k];
+        std::fprintf(out,
+                     "%s\n    {\"name\": \"%s\", \"command\": \"%s\", "
+                     "\"wall_ms\": %.3f, \"peak_rss_kb\": %.0f, "
+                     "\"allocations\": %.0f}",
+                     k == 0 ? "" : ",", json_escape(result.name).c_str(),
+                     json_escape(result.command).c_str(), result.wall_ms,
+                     result.peak_rss_kb, result.allocations);
+    }
+    std::fprintf(out, "\n  ]\n}\n");
+    std::fclose(out);
+}
+
+void pin_to_cpu(int cpu) {
+    if (cpu < 0) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    // Children inherit the affinity
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        std::fprintf(stderr, "bench-runner: can't pin to CPU %d: %s\n", cpu,
+                     std::strerror(errno));
+    }
+}
+
+// Returns false if the benchmark failed
+bool run_once(const Benchmark &benchmark, const std::string &stats_path,
+              const std::string &log_path, Result &best) {
+    std::remove(stats_path.c_str());
+
+    std::vector<char *> argv;
+    for (const auto &arg : benchmark.argv) {
+        argv.push_back(const_cast<char *>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    const auto start = std::chrono::steady_clock::now();
+    const pid_t pid = fork();
+    if (pid < 0) {
+        throw std::runtime_error{std::string{"fork: "} + std::strerror(errno)};
+    }
+    if (pid == 0) {
+        const int log = open(log_path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (log >= 0) {
+            dup2(log, STDOUT_FILENO);
+            dup2(log, STDERR_FILENO);
+            close(log);
+        }
+        setenv("SANDBOX_BENCH_STATS", stats_path.c_str(), 1);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+
+    int status{0};
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            throw std::runtime_error{std::string{"waitpid: "} +
+                                     std::strerror(errno)};
+        }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return false;
+    }
+
+    best.wall_ms = std::min(
+        best.wall_ms,
+        std::chrono::duration<double, std::milli>(elapsed).count());
+    std::ifstream stats_in{stats_path};
+    if (stats_in) {
+        std::ostringstream text;
+        text << stats_in.rdbuf();
+        const auto stats = JsonReader{text.str()}.ReadResult();
+        best.allocations = std::min(best.allocations, stats.allocations);
+        best.peak_rss_kb = std::min(best.peak_rss_kb, stats.peak_rss_kb);
+    }
+    return true;
+}
+
+Result run(const Benchmark &benchmark, const Options &options) {
+    Result result;
+    result.name = benchmark.name;
+    for (std::size_t k = 1; k < benchmark.argv.size(); ++k) {
+        result.command += (k == 1 ? "" : " ") + benchmark.argv[k];
+    }
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    result.wall_ms = result.peak_rss_kb = result.allocations = inf;
+
+    const std::string dir = options.log_dir.empty() ? "." : options.log_dir;
+    const std::string stats_path = dir + "/" + benchmark.name + ".stats.json";
+    const std::string log_path = dir + "/" + benchmark.name + ".log";
+    std::remove(log_path.c_str());
+
+    Result ignored = result;
+    for (int k = 0; k < options.warmup && !result.failed; ++k) {
+        result.failed = !run_once(benchmark, stats_path, log_path, ignored);
+    }
+    for (int k = 0; k < options.runs && !result.failed; ++k) {
+        result.failed = !run_once(benchmark, stats_path, log_path, result);
+    }
+    std::remove(stats_path.c_str());
+
+    // Not reported (e.g. the harness isn't linked in)
+    for (double *value : {&result.peak_rss_kb, &result.allocations}) {
+        if (std::isinf(*value)) {
+            *value = 0;
+        }
+    }
+    if (result.failed) {
+        result.wall_ms = 0;
+    }
+    return result;
+}
+
+// Prints a verdict per metric, returns true if anything regressed
+bool compare(const Result &result, const Result &base, const Options &options) {
+    bool regressed{false};
+    auto check = [&](const char *metric, double value, double base_value,
+                     double tolerance, double floor) {
+        const double delta = value - base_value;
+        const double ratio = base_value > 0 ? delta / base_value : 0.0;
+        const bool bad = delta > floor && ratio > tolerance;
+        regressed |= bad;
+        std::printf("    %-12s %14.1f %14.1f %+8.1f%%%s\n", metric, base_value,
+                    value, ratio * 100.0,
+                    bad ? "  REGRESSION" : "");
+    };
+    check("wall_ms", result.wall_ms, base.wall_ms, options.time_tolerance,
+          kTimeFloorMs);
+    check("peak_rss_kb", result.peak_rss_kb, base.peak_rss_kb,
+          options.rss_tolerance, kRssFloorKb);
+    check("allocations", result.allocations, base.allocations,
+          options.alloc_tolerance, kAllocFloor);
+    return regressed;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const auto options = parse_options(argc, argv);
+
+    try {
+        const auto benchmarks = read_manifest(options.manifest, options.filter);
+        const auto baseline = options.baseline.empty()
+                                  ? std::map<std::string, Result>{}
+                                  : read_results(options.baseline);
+
+        pin_to_cpu(options.cpu);
+
+        std::vector<Result> results;
+        bool failed{false};
+        bool regressed{false};
+        for (const auto &benchmark : benchmarks) {
+            results.push_back(run(benchmark, options));
+            const auto &result = results.back();
+            std::printf("%s %s\n", result.name.c_str(), result.command.c_str());
+
+            if (result.failed) {
+                std::printf("    FAILED, see %s.log\n", result.name.c_str());
+                failed = true;
+                continue;
+            }
+            // Numbers of other arguments aren't comparable
+            const auto base = baseline.find(result.name);
+            const bool comparable = base != baseline.end() &&
+                                    base->second.command == result.command;
+            if (!comparable || options.update_baseline) {
+                if (base != baseline.end() && !comparable) {
+                    std::printf(
+                        "    command changed, no comparison (was: %s)\n",
+                        base->second.command.c_str());
+                }
+                std::printf("    %-12s %14s %14.1f\n", "wall_ms", "-",
+                            result.wall_ms);
+                std::printf("    %-12s %14s %14.1f\n", "peak_rss_kb", "-",
+                            result.peak_rss_kb);
+                std::printf("    %-12s %14s %14.1f\n", "allocations", "-",
+                            result.allocations);
+                continue;
+            }
+            regressed |= compare(result, base->second, options);
+        }
+
+        write_results(options.output, options, results);
+        std::printf("\nresults: %s\n", options.output.c_str());
+        if (options.update_baseline) {
+            // Benchmarks which failed or were skipped by --filter keep their
+            // old numbers
+            std::vector<Result> merged;
+            std::copy_if(results.cbegin(), results.cend(),
+                         std::back_inserter(merged),
+                         [](const Result &result) { return !result.failed; });
+            for (const auto &[name, base] : baseline) {
+                if (std::none_of(merged.cbegin(), merged.cend(),
+                                 [&name](const Result &result) {
+                                     return result.name == name;
+                                 })) {
+                    merged.push_back(base);
+                }
+            }
+            // In a stable order, so the file's diffs show only what changed
+            std::sort(merged.begin(), merged.end(),
+                      [](const Result &a, const Result &b) {
+                          return a.name < b.name;
+                      });
+            write_results(options.baseline, options, merged);
+            std::printf("baseline updated: %s\n", options.baseline.c_str());
+        }
+
+        if (failed || regressed) {
+            std::printf("%s\n", failed ? "FAILED" : "REGRESSED");
+            return 1;
+        }
+    } catch (const std::exception &error) {
+        std::fprintf(stderr, "bench-runner: %s\n", error.what());
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+// Linked into every benchmark executable (see `add_sandbox_benchmark` in
+// the root CMakeLists.txt).
+//
+// Counts heap allocations by replacing the global allocation functions. When
+// the process exits and the `SANDBOX_BENCH_STATS` environment variable names a
+// file, the counters and the peak RSS are written there as JSON for the
+// bench runner:
+//
+//   {"allocations": 12345, "peak_rss_kb": 6789}
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> allocations{0};
+
+void *counted_alloc(std::size_t size) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void *counted_aligned_alloc(std::size_t size, std::align_val_t align) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    const auto alignment = static_cast<std::size_t>(align);
+    // aligned_alloc wants the size to be a multiple of the alignment
+    size = (size + alignment - 1) / alignment * alignment;
+    return std::aligned_alloc(alignment, size == 0 ? alignment : size);
+}
+
+// VmHWM from /proc/self/status, 0 if unavailable
+uint64_t peak_rss_kb(void) noexcept {
+    FILE *status = std::fopen("/proc/self/status", "r");
+    if (status == nullptr) {
+        return 0;
+    }
+    char line[256];
+    uint64_t result{0};
+    while (std::fgets(line, sizeof(line), status)) {
+        if (std::strncmp(line, "VmHWM:", 6) == 0) {
+            result = std::strtoull(line + 6, nullptr, 10);
+            break;
+        }
+    }
+    std::fclose(status);
+    return result;
+}
+
+// Written from a static destructor: runs after `main` returns or `exit()`
+struct StatsWriter {
+    ~StatsWriter() {
+        const char *path = std::getenv("SANDBOX_BENCH_STATS");
+        if (path == nullptr || *path == '\0') {
+            return;
+        }
+        FILE *out = std::fopen(path, "w");
+        if (out == nullptr) {
+            return;
+        }
+        std::fprintf(out, "{\"allocations\": %llu, \"peak_rss_kb\": %llu}\n",
+                     static_cast<unsigned long long>(
+                         allocations.load(std::memory_order_relaxed)),
+                     static_cast<unsigned long long>(peak_rss_kb()));
+        std::fclose(out);
+    }
+} stats_writer;
+
+} // namespace
+
+void *operator new(std::size_t size) {
+    if (void *ptr = counted_alloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void *operator new[](std::size_t size) { return ::operator new(size); }
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return counted_alloc(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return counted_alloc(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t align) {
+    if (void *ptr = counted_aligned_alloc(size, align)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void *operator new[](std::size_t size, std::align_val_t align) {
+    return ::operator new(size, align);
+}
+
+void *operator new(std::size_t size, std::align_val_t align,
+                   const std::nothrow_t &) noexcept {
+    return counted_aligned_alloc(size, align);
+}
+
+void *operator new[](std::size_t size, std::align_val_t align,
+                     const std::nothrow_t &) noexcept {
+    return counted_aligned_alloc(size, align);
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+    std::free(ptr);
+}
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+    std::free(ptr);
+}
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+void operator delete(void *ptr, std::align_val_t,
+                     const std::nothrow_t &) noexcept {
+    std::free(ptr);
+}
+void operator delete[](void *ptr, std::align_val_t,
+                       const std::nothrow_t &) noexcept {
+    std::free(ptr);
+}
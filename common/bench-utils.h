@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+namespace cpp_core_sandbox::bench {
+
+// Tell the optimizer that `value` is read and may be modified, so the
+// computation producing it can't be dropped or hoisted out of a loop.
+template <class T> inline void do_not_optimize(T &value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : "+r,m"(value) : : "memory");
+#else
+    static volatile T *sink;
+    sink = &value;
+#endif
+}
+
+// Force all pending memory writes to be treated as observable
+inline void clobber_memory() noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#endif
+}
+
+// Wall clock stopwatch started at construction
+class Stopwatch {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    void restart() noexcept { start_ = clock::now(); }
+
+    [[nodiscard]] double elapsed_ns() const noexcept {
+        return std::chrono::duration<double, std::nano>(clock::now() - start_)
+            .count();
+    }
+
+    [[nodiscard]] double elapsed_ms() const noexcept {
+        return elapsed_ns() / 1e6;
+    }
+
+  private:
+    clock::time_point start_{clock::now()};
+};
+
+// Read a positional size argument such as an iteration count. Accepts plain
+// integers as well as `1e9`-like notation. Anything else, zero included,
+// is a usage error: the program exits with 2.
+inline uint64_t size_arg(int argc, char **argv, int index,
+                         uint64_t default_value) {
+    if (index >= argc) {
+        return default_value;
+    }
+    const char *arg = argv[index];
+    char *end = nullptr;
+    errno = 0;
+    const double value = std::strtod(arg, &end);
+    // 2^64 is exact as a double, the largest valid value is below it
+    if (end == arg || *end != '\0' || errno == ERANGE || !(value >= 1.0) ||
+        value >= 18446744073709551616.0 || value != std::floor(value)) {
+        std::fprintf(stderr,
+                     "%s: argument %d must be a positive integer, not '%s'\n",
+                     argv[0], index, arg);
+        std::exit(2);
+    }
+    return static_cast<uint64_t>(value);
+}
+
+} // namespace cpp_core_sandbox::bench
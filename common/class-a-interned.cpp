@@ -0,0 +1,10 @@
+#include "class-a-interned.h"
+
+namespace cpp_core_sandbox {
+
+InternedA::InternedA(void)
+    : raw_string_{StringPool::Global().Intern("1234")},
+      pstr_{StringPool::Global().Intern("unique_pointer")},
+      regular_string_{StringPool::Global().Intern("some value123")} {}
+
+} // namespace cpp_core_sandbox
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string_view>
+
+#include "sequence-id.h"
+#include "string-pool.h"
+
+namespace cpp_core_sandbox {
+
+// The payload of A with interned strings.
+//
+// Every A owns three copies of the same strings (two of them on the heap).
+// Here the strings are kept once in `StringPool::Global()`, and an instance
+// holds only their 4-byte handles. No tracing, no copy-move logic: the class
+// exists to compare the footprint and construction time with A.
+class InternedA final {
+  public:
+    InternedA(void);
+
+    std::string_view RawString(void) const noexcept {
+        return StringPool::Global().View(raw_string_);
+    }
+    std::string_view PString(void) const noexcept {
+        return StringPool::Global().View(pstr_);
+    }
+    std::string_view RegularString(void) const noexcept {
+        return StringPool::Global().View(regular_string_);
+    }
+
+  private:
+    int seq_no_{sequence_ids<InternedA>::next()};
+
+    // Some payload
+    StringPool::Handle raw_string_;
+    StringPool::Handle pstr_;
+    StringPool::Handle regular_string_;
+};
+
+} // namespace cpp_core_sandbox
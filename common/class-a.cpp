@@ -1,11 +1,47 @@
 #include "class-a.h"
+#include <atomic>
 #include <cstring>
 
 namespace cpp_core_sandbox {
 
-int A::unique_seq_no_{1};
-int A::throw_in_ctor_for_seq_no_{-2}; // note: `-1` is for moved instance with
-                                      // its undefined state
+std::atomic<int> A::throw_in_ctor_for_seq_no_{-2}; // note: `-1` is for moved
+                                                   // instance with its
+                                                   // undefined state
+thread_local A::Counters A::counters_;
+
+namespace {
+std::atomic<bool> trace_enabled{true};
+} // namespace
+
+void A::SetTraceEnabled(bool enabled) noexcept {
+    trace_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+std::ostream &A::_trace(void) noexcept {
+    // A stream without a buffer is in the `bad` state, so every output
+    // operation returns immediately. One per thread since the failing
+    // operations still update the stream state
+    thread_local std::ostream null_stream{nullptr};
+    return trace_enabled.load(std::memory_order_relaxed) ? std::cout
+                                                         : null_stream;
+}
+
+expected<A, A::CtorError> A::TryCreate(void) {
+    expected<A, CtorError> result{std::in_place, std::nothrow};
+    if (_throws_for(result->seq_no_)) {
+        // The instance is destroyed properly, no leaks unlike in the
+        // throwing constructor
+        result = unexpected{CtorError{result->seq_no_}};
+    }
+    return result; // The only return statement keeps NRVO possible
+}
+
+A::Counters A::Counters::operator-(const Counters &rh) const noexcept {
+    return Counters{default_ctor - rh.default_ctor, value_ctor - rh.value_ctor,
+                    copy_ctor - rh.copy_ctor,       move_ctor - rh.move_ctor,
+                    copy_assign - rh.copy_assign,   move_assign - rh.move_assign,
+                    dtor - rh.dtor};
+}
 
 void A::_init(void) {
     if (raw_string_) {
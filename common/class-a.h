@@ -1,8 +1,13 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <iostream>
 #include <memory>
+#include <new>
+
+#include "expected.h"
+#include "sequence-id.h"
 
 namespace cpp_core_sandbox {
 
@@ -12,30 +17,42 @@ namespace cpp_core_sandbox {
 class A final {
   public:
     explicit A(void) {
-        std::cout << __func__ << "() ctor [ " << seq_no_ << " ]"
-                  << "; this = " << reinterpret_cast<uint64_t>(this)
-                  << std::endl;
+        ++counters_.default_ctor;
+        _trace() << __func__ << "() ctor [ " << seq_no_ << " ]"
+                 << "; this = " << reinterpret_cast<uint64_t>(this)
+                 << std::endl;
         _init();
-        if (throw_in_ctor_for_seq_no_ == seq_no_) {
+        if (_throws_for(seq_no_)) {
             throw std::exception{};
         }
     }
 
+    // Never throws the injected exception, see `TryCreate`
+    explicit A(std::nothrow_t) {
+        ++counters_.default_ctor;
+        _trace() << __func__ << "( nothrow ) ctor [ " << seq_no_ << " ]"
+                 << "; this = " << reinterpret_cast<uint64_t>(this)
+                 << std::endl;
+        _init();
+    }
+
     explicit A(int val) {
-        std::cout << __func__ << "( " << val << " ) ctor [ " << seq_no_ << " ]"
-                  << "; this = " << reinterpret_cast<uint64_t>(this)
-                  << std::endl;
+        ++counters_.value_ctor;
+        _trace() << __func__ << "( " << val << " ) ctor [ " << seq_no_ << " ]"
+                 << "; this = " << reinterpret_cast<uint64_t>(this)
+                 << std::endl;
         _init();
-        if (throw_in_ctor_for_seq_no_ == val) {
+        if (_throws_for(val)) {
             throw std::exception{};
         }
     }
 
     A(const A &rh) {
         (void)rh;
-        std::cout << __func__ << "( const A& ) ctor [ " << seq_no_ << " ]"
-                  << "; this = " << reinterpret_cast<uint64_t>(this)
-                  << std::endl;
+        ++counters_.copy_ctor;
+        _trace() << __func__ << "( const A& ) ctor [ " << seq_no_ << " ]"
+                 << "; this = " << reinterpret_cast<uint64_t>(this)
+                 << std::endl;
         // Don't copy seq_no
 
         // Just init the payload, it's not necessary to perform a deep copy
@@ -45,9 +62,10 @@ class A final {
 
     A(A &&rh) noexcept {
         (void)rh;
-        std::cout << __func__ << "( A&& ) ctor [ " << seq_no_ << " ]"
-                  << "; this = " << reinterpret_cast<uint64_t>(this)
-                  << std::endl;
+        ++counters_.move_ctor;
+        _trace() << __func__ << "( A&& ) ctor [ " << seq_no_ << " ]"
+                 << "; this = " << reinterpret_cast<uint64_t>(this)
+                 << std::endl;
 
         /*seq_no_ = rh.seq_no_;
         rh.seq_no_ = -1;               // Isn't necessary, but let's invalidate
@@ -65,7 +83,8 @@ class A final {
             return *this;
         }
         (void)rh;
-        std::cout << "operator=( const A& ) [ " << seq_no_ << " ]" << std::endl;
+        ++counters_.copy_assign;
+        _trace() << "operator=( const A& ) [ " << seq_no_ << " ]" << std::endl;
 
         // Sequence number remains the same in order to observe the lifetime of
         // class instances
@@ -78,7 +97,8 @@ class A final {
             return *this;
         }
         (void)rh;
-        std::cout << "operator=( A&& ) [ " << seq_no_ << " ]" << std::endl;
+        ++counters_.move_assign;
+        _trace() << "operator=( A&& ) [ " << seq_no_ << " ]" << std::endl;
 
         // Sequence number remains the same in order to observe the lifetime of
         // the class instances
@@ -89,9 +109,10 @@ class A final {
     // Notes:
     // - by default destructors are noexcept
     ~A(void) noexcept(false) {
-        std::cout << __func__ << "() [ " << seq_no_ << " ]"
-                  << "; this = " << reinterpret_cast<uint64_t>(this)
-                  << std::endl;
+        ++counters_.dtor;
+        _trace() << __func__ << "() [ " << seq_no_ << " ]"
+                 << "; this = " << reinterpret_cast<uint64_t>(this)
+                 << std::endl;
 
         // The only manual deinitialization step
         if (raw_string_) {
@@ -101,16 +122,71 @@ class A final {
     }
 
     static void SetCtorThrowCondition(int seq_no = -2) noexcept {
-        throw_in_ctor_for_seq_no_ = seq_no;
+        throw_in_ctor_for_seq_no_.store(seq_no, std::memory_order_relaxed);
+    }
+
+    // Instances may be constructed on many threads: every thread takes the
+    // sequence numbers from a block of its own (see `sequence_ids`). On a
+    // single thread they remain 1, 2, 3...
+    static void SetSeqNoBlockSize(int size) noexcept {
+        sequence_ids<A>::set_block_size(size);
     }
 
+    // Tracing to stdout is on by default. Turn it off to measure something
+    static void SetTraceEnabled(bool enabled) noexcept;
+
+    // The error channel of `TryCreate`
+    struct CtorError {
+        int seq_no;
+    };
+
+    // Exception-free counterpart of `A()`: the injected construction failure
+    // (see `SetCtorThrowCondition`) is returned instead of being thrown.
+    // The instance is constructed in place, no moves are involved
+    static expected<A, CtorError> TryCreate(void);
+
+    // Lifetime events of A observed by the current thread
+    struct Counters {
+        uint64_t default_ctor{0};
+        uint64_t value_ctor{0};
+        uint64_t copy_ctor{0};
+        uint64_t move_ctor{0};
+        uint64_t copy_assign{0};
+        uint64_t move_assign{0};
+        uint64_t dtor{0};
+
+        Counters operator-(const Counters &rh) const noexcept;
+        bool operator==(const Counters &rh) const noexcept = default;
+    };
+
+    static const Counters &ThreadCounters(void) noexcept { return counters_; }
+
+    // Captures the counters on construction, so that `Delta()` returns only
+    // the events which happened on this thread while the snapshot is alive:
+    //
+    //   A::CountersSnapshot snapshot;
+    //   auto a = MakeA();
+    //   assert(snapshot.Delta().copy_ctor == 0);
+    class CountersSnapshot {
+      public:
+        CountersSnapshot(void) noexcept : start_{counters_} {}
+
+        Counters Delta(void) const noexcept { return counters_ - start_; }
+
+      private:
+        Counters start_;
+    };
+
   private:
-    // No matter how an object was constructed, `unique_seq_no_` always has
-    // unique sequentially incremented value
-    static int unique_seq_no_;
-    int seq_no_{unique_seq_no_++};
+    // No matter how an object was constructed, `seq_no_` always has a
+    // unique value, incremented sequentially within a thread
+    int seq_no_{sequence_ids<A>::next()};
+
+    static std::atomic<int> throw_in_ctor_for_seq_no_;
 
-    static int throw_in_ctor_for_seq_no_;
+    // Per-thread, so the accounting is neither a data race nor a shared
+    // cache line
+    static thread_local Counters counters_;
 
   private:
     // Some payload
@@ -120,6 +196,14 @@ class A final {
 
     // A function to initialize the payload
     void _init(void);
+
+    static bool _throws_for(int seq_no) noexcept {
+        return throw_in_ctor_for_seq_no_.load(std::memory_order_relaxed) ==
+               seq_no;
+    }
+
+    // std::cout or a stream discarding everything
+    static std::ostream &_trace(void) noexcept;
 };
 
 } // namespace cpp_core_sandbox
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "flat-hash-set.h"
+
+namespace cpp_core_sandbox {
+
+// The bytes a cached value holds, the default is just `sizeof`
+template <class Value> struct sizeof_weigher {
+    std::size_t operator()(const Value &) const noexcept {
+        return sizeof(Value);
+    }
+};
+
+// A bounded, thread-safe cache from strings to immutable values.
+//
+// The bound is in bytes: the key, the value as estimated by `Weigher` and a
+// fixed overhead per entry. When a new entry doesn't fit, entries are evicted
+// with the CLOCK policy, an approximation of LRU which needs no list
+// reordering on a hit: a hit only sets the entry's `referenced` bit, and the
+// clock hand sweeping the entries clears the bits, evicting the first entry
+// without one. An entry which isn't used after its insertion goes first, so
+// a scan of one-off keys doesn't flush the frequently used ones.
+//
+// The entries are split into shards by the key's hash, each with its own
+// mutex and a share of the capacity, so threads rarely wait for each other.
+// Values are handed out as `shared_ptr<const Value>`: a lookup copies a
+// pointer under the lock, not the value, and an evicted value stays alive
+// while someone uses it.
+//
+//   clock_cache<std::vector<std::string>, results_weigher> cache{64 << 20};
+//   if (auto cached = cache.find(key)) { ... *cached ... }
+//   else cache.insert(key, compute(key));
+template <class Value, class Weigher = sizeof_weigher<Value>>
+class clock_cache {
+  public:
+    using value_ptr = std::shared_ptr<const Value>;
+
+    // Bookkeeping of an entry besides the key and the value
+    static constexpr std::size_t entry_overhead{96};
+
+    struct stats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        uint64_t insertions{0};
+        uint64_t evictions{0};
+        std::size_t entries{0};
+        std::size_t bytes{0};
+
+        double hit_ratio(void) const noexcept {
+            const auto lookups = hits + misses;
+            return lookups == 0 ? 0.0
+                                : static_cast<double>(hits) /
+                                      static_cast<double>(lookups);
+        }
+    };
+
+    explicit clock_cache(std::size_t capacity_bytes, std::size_t shards = 16,
+                         Weigher weigher = Weigher{})
+        : weigher_(std::move(weigher)),
+          shards_(shards == 0 ? 1 : shards) {
+        for (auto &shard : shards_) {
+            shard.capacity = capacity_bytes / shards_.size();
+        }
+    }
+
+    clock_cache(const clock_cache &) = delete;
+    clock_cache &operator=(const clock_cache &) = delete;
+
+    // nullptr on a miss
+    value_ptr find(std::string_view key) {
+        shard &s = _shard_for(key);
+        std::lock_guard lock{s.mutex};
+        const auto it = s.index.find(key);
+        if (it == s.index.end()) {
+            ++s.counters.misses;
+            return nullptr;
+        }
+        ++s.counters.hits;
+        slot &entry = s.slots[it->second];
+        entry.referenced = true;
+        return entry.value;
+    }
+
+    // Replaces the value of an existing key. A value too large for a shard
+    // isn't cached at all
+    void insert(std::string_view key, value_ptr value) {
+        const std::size_t weight =
+            2 * key.size() + weigher_(*value) + entry_overhead;
+        shard &s = _shard_for(key);
+        std::lock_guard lock{s.mutex};
+        if (const auto it = s.index.find(key); it != s.index.end()) {
+            s.bytes -= s.slots[it->second].weight;
+            s.slots[it->second].value = std::move(value);
+            s.slots[it->second].weight = weight;
+            s.bytes += weight;
+            _evict(s, 0);
+            return;
+        }
+        if (weight > s.capacity) {
+            return;
+        }
+        _evict(s, weight);
+
+        std::size_t index;
+        if (s.free_slots.empty()) {
+            index = s.slots.size();
+            s.slots.emplace_back();
+        } else {
+            index = s.free_slots.back();
+            s.free_slots.pop_back();
+        }
+        slot &entry = s.slots[index];
+        entry.key.assign(key);
+        entry.value = std::move(value);
+        entry.weight = weight;
+        entry.referenced = false;
+        entry.used = true;
+        s.index.emplace(entry.key, index);
+        s.bytes += weight;
+        ++s.counters.insertions;
+    }
+
+    void insert(std::string_view key, Value value) {
+        insert(key, std::make_shared<const Value>(std::move(value)));
+    }
+
+    // Summed over the shards, each of them locked in turn
+    stats get_stats(void) const {
+        stats result;
+        for (const auto &s : shards_) {
+            std::lock_guard lock{s.mutex};
+            result.hits += s.counters.hits;
+            result.misses += s.counters.misses;
+            result.insertions += s.counters.insertions;
+            result.evictions += s.counters.evictions;
+            result.entries += s.index.size();
+            result.bytes += s.bytes;
+        }
+        return result;
+    }
+
+    void clear(void) {
+        for (auto &s : shards_) {
+            std::lock_guard lock{s.mutex};
+            s.index.clear();
+            s.slots.clear();
+            s.free_slots.clear();
+            s.hand = 0;
+            s.bytes = 0;
+        }
+    }
+
+  private:
+    struct slot {
+        std::string key;
+        value_ptr value;
+        std::size_t weight{0};
+        bool referenced{false};
+        bool used{false};
+    };
+
+    struct shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, std::size_t, string_hash,
+                           std::equal_to<>>
+            index; // Key to its slot
+        std::vector<slot> slots; // The clock, with unused slots in between
+        std::vector<std::size_t> free_slots;
+        std::size_t hand{0};
+        std::size_t capacity{0};
+        std::size_t bytes{0};
+        stats counters;
+    };
+
+    shard &_shard_for(std::string_view key) {
+        // The low bits pick the bucket inside the shard's map
+        const auto hash = string_hash{}(key);
+        return shards_[(hash >> 32) % shards_.size()];
+    }
+
+    // Makes room for `weight` more bytes
+    static void _evict(shard &s, std::size_t weight) {
+        while (s.bytes + weight > s.capacity && !s.index.empty()) {
+            if (s.hand >= s.slots.size()) {
+                s.hand = 0;
+            }
+            slot &entry = s.slots[s.hand];
+            if (entry.used) {
+                if (entry.referenced) {
+                    entry.referenced = false; // A second chance
+                } else {
+                    s.index.erase(entry.key);
+                    s.bytes -= entry.weight;
+                    entry.value.reset();
+                    entry.used = false;
+                    s.free_slots.push_back(s.hand);
+                    ++s.counters.evictions;
+                }
+            }
+            ++s.hand;
+        }
+    }
+
+    Weigher weigher_;
+    std::vector<shard> shards_;
+};
+
+} // namespace cpp_core_sandbox
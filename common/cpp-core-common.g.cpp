@@ -0,0 +1,1445 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <shared_mutex>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "class-a.h"
+#include "clock-cache.h"
+#include "expected.h"
+#include "flat-hash-set.h"
+#include "generator.h"
+#include "hdr-histogram.h"
+#include "huge-page-allocator.h"
+#include "packed-column.h"
+#include "poly-value.h"
+#include "relocating-vector.h"
+#include "segmented-vector.h"
+#include "sequence-id.h"
+#include "string-concat.h"
+#include "string-pool.h"
+#include "sync-primitives.h"
+
+using namespace cpp_core_sandbox;
+
+namespace {
+
+// Small blocks make every test cross block boundaries
+template <class T> using small_segmented_vector = segmented_vector<T, 2>;
+
+} // namespace
+
+namespace {
+
+struct Shape {
+    virtual int id(void) const = 0;
+
+  protected:
+    ~Shape(void) = default; // Not virtual: poly_value doesn't need it
+};
+
+// Counts the live objects, so every one of them is destroyed exactly once
+template <size_t Payload> struct counted_shape final : Shape {
+    static inline int constructed{0};
+    static inline int destroyed{0};
+
+    int value;
+    char payload[Payload]{};
+
+    explicit counted_shape(int v) noexcept : value{v} { ++constructed; }
+    counted_shape(const counted_shape &rh) noexcept : value{rh.value} {
+        ++constructed;
+    }
+    counted_shape(counted_shape &&rh) noexcept : value{rh.value} {
+        ++constructed;
+    }
+    ~counted_shape(void) { ++destroyed; }
+
+    int id(void) const override { return value; }
+
+    static int live(void) { return constructed - destroyed; }
+};
+
+using small_shape = counted_shape<1>;
+using large_shape = counted_shape<256>;
+using shape_value = poly_value<Shape>;
+
+shape_value make_shape(bool large, int value) {
+    if (large) {
+        return shape_value{std::in_place_type<large_shape>, value};
+    }
+    return shape_value{std::in_place_type<small_shape>, value};
+}
+
+} // namespace
+
+TEST(PolyValue, InlineOrHeap) {
+    {
+        shape_value empty;
+        EXPECT_FALSE(empty.has_value());
+        EXPECT_FALSE(empty.is_inline());
+
+        shape_value small = small_shape{1};
+        EXPECT_TRUE(small.is_inline());
+        EXPECT_EQ(small->id(), 1);
+        // The object lives inside the handle
+        const auto *handle = reinterpret_cast<const char *>(&small);
+        const auto *object = reinterpret_cast<const char *>(small.get());
+        EXPECT_GE(object, handle);
+        EXPECT_LT(object, handle + sizeof(small));
+
+        shape_value large = large_shape{2};
+        EXPECT_FALSE(large.is_inline());
+        EXPECT_EQ(large->id(), 2);
+
+        large.emplace<small_shape>(3);
+        EXPECT_TRUE(large.is_inline());
+        EXPECT_EQ((*large).id(), 3);
+        large.reset();
+        EXPECT_FALSE(large);
+        EXPECT_EQ(large_shape::live(), 0);
+    }
+    EXPECT_EQ(small_shape::live(), 0);
+    EXPECT_EQ(large_shape::live(), 0);
+}
+
+TEST(PolyValue, CopyMoveSwapInlineAndHeap) {
+    for (const bool large_a : {false, true}) {
+        for (const bool large_b : {false, true}) {
+            SCOPED_TRACE(testing::Message()
+                         << (large_a ? "heap" : "inline") << " and "
+                         << (large_b ? "heap" : "inline"));
+            {
+                shape_value a = make_shape(large_a, 1);
+                shape_value b = make_shape(large_b, 2);
+
+                shape_value copy{a};
+                EXPECT_EQ(copy.is_inline(), !large_a);
+                EXPECT_EQ(copy->id(), 1);
+                EXPECT_NE(copy.get(), a.get());
+
+                copy = b;
+                EXPECT_EQ(copy.is_inline(), !large_b);
+                EXPECT_EQ(copy->id(), 2);
+                EXPECT_EQ(b->id(), 2);
+
+                shape_value moved{std::move(copy)};
+                EXPECT_FALSE(copy.has_value());
+                EXPECT_EQ(moved->id(), 2);
+
+                moved = std::move(a);
+                EXPECT_FALSE(a.has_value());
+                EXPECT_EQ(moved.is_inline(), !large_a);
+                EXPECT_EQ(moved->id(), 1);
+
+                moved.swap(b);
+                EXPECT_EQ(moved.is_inline(), !large_b);
+                EXPECT_EQ(moved->id(), 2);
+                EXPECT_EQ(b.is_inline(), !large_a);
+                EXPECT_EQ(b->id(), 1);
+
+                moved = moved; // Self-assignment keeps the value
+                EXPECT_EQ(moved->id(), 2);
+            }
+            EXPECT_EQ(small_shape::live(), 0);
+            EXPECT_EQ(large_shape::live(), 0);
+        }
+    }
+}
+
+TEST(PolyValue, HeapObjectStaysInPlaceOnMove) {
+    shape_value large = large_shape{7};
+    const Shape *object = large.get();
+    shape_value moved{std::move(large)};
+    EXPECT_EQ(moved.get(), object);
+
+    std::vector<shape_value> values;
+    for (int k = 0; k < 100; ++k) {
+        values.push_back(make_shape(k % 3 == 0, k));
+    }
+    values.erase(values.begin(), values.begin() + 50);
+    for (int k = 0; k < 50; ++k) {
+        EXPECT_EQ(values[static_cast<size_t>(k)]->id(), k + 50);
+    }
+}
+
+TEST(StringPool, EqualStringsShareAHandle) {
+    StringPool pool;
+    const auto a = pool.Intern("(a)()");
+    const auto b = pool.Intern("(a())");
+    const std::string copy = "xx(a)()";
+    EXPECT_EQ(pool.Intern(std::string_view{copy}.substr(2)), a);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(pool.Intern(""), pool.Intern(std::string{}));
+    EXPECT_EQ(pool.Size(), 3u);
+
+    EXPECT_EQ(pool.View(a), "(a)()");
+    EXPECT_EQ(pool.View(b), "(a())");
+    EXPECT_EQ(pool.Find("(a)()"), a);
+    EXPECT_EQ(pool.Find("()"), std::nullopt);
+}
+
+TEST(StringPool, HandlesSurviveGrowth) {
+    StringPool pool;
+    const auto bytes = pool.BytesUsed();
+    std::vector<StringPool::Handle> handles;
+    std::vector<std::string_view> views;
+    // Far beyond the initial 64 slots and the first entry chunk per shard
+    for (int k = 0; k < 100'000; ++k) {
+        handles.push_back(pool.Intern(std::to_string(k)));
+        views.push_back(pool.View(handles.back()));
+    }
+    EXPECT_GT(pool.BytesUsed(), bytes);
+    ASSERT_EQ(pool.Size(), 100'000u);
+    for (int k = 0; k < 100'000; ++k) {
+        const auto key = std::to_string(k);
+        const auto handle = handles[static_cast<size_t>(k)];
+        EXPECT_EQ(pool.Intern(key), handle);
+        EXPECT_EQ(pool.Find(key), handle);
+        // The characters haven't moved either
+        EXPECT_EQ(pool.View(handle).data(), views[static_cast<size_t>(k)].data());
+        EXPECT_EQ(pool.View(handle), key);
+    }
+}
+
+TEST(StringPool, ConcurrentInterning) {
+    constexpr int kThreads{8};
+    constexpr int kKeys{20'000};
+    StringPool pool;
+
+    // Every thread interns an overlapping half of the keys in its own order,
+    // while the tables grow
+    std::vector<std::vector<StringPool::Handle>> handles(
+        kThreads, std::vector<StringPool::Handle>(kKeys));
+    std::vector<std::thread> workers;
+    for (int t = 0; t < kThreads; ++t) {
+        workers.emplace_back([&pool, &handles, t] {
+            std::vector<int> keys(kKeys / 2);
+            std::iota(keys.begin(), keys.end(), t * kKeys / (2 * kThreads));
+            std::shuffle(keys.begin(), keys.end(),
+                         std::mt19937{static_cast<unsigned>(t)});
+            for (const int key : keys) {
+                handles[static_cast<size_t>(t)][static_cast<size_t>(key)] =
+                    pool.Intern("key" + std::to_string(key));
+            }
+            for (const int key : keys) {
+                EXPECT_EQ(pool.View(handles[static_cast<size_t>(t)]
+                                           [static_cast<size_t>(key)]),
+                          "key" + std::to_string(key));
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    // The keys interned by several threads got the same handle everywhere
+    const int last = (kThreads - 1) * kKeys / (2 * kThreads) + kKeys / 2;
+    EXPECT_EQ(pool.Size(), static_cast<size_t>(last));
+    for (int key = 0; key < last; ++key) {
+        const auto handle = pool.Find("key" + std::to_string(key));
+        ASSERT_TRUE(handle.has_value());
+        for (int t = 0; t < kThreads; ++t) {
+            const int first = t * kKeys / (2 * kThreads);
+            if (key >= first && key < first + kKeys / 2) {
+                EXPECT_EQ(handles[static_cast<size_t>(t)]
+                                 [static_cast<size_t>(key)],
+                          *handle);
+            }
+        }
+    }
+}
+
+TEST(StringConcat, MixedOperands) {
+    const std::string name = "x";
+    const std::string_view unit = "ms";
+    EXPECT_EQ(concat(name, " = ", 42, unit, ',', -7, '\n'), "x = 42ms,-7\n");
+    EXPECT_EQ(concat(), "");
+    EXPECT_EQ(std::string(concat_expr{} + name + ": " + 0u), "x: 0");
+}
+
+TEST(StringConcat, IntegerLimits) {
+    using ll_limits = std::numeric_limits<long long>;
+    using ull_limits = std::numeric_limits<unsigned long long>;
+    EXPECT_EQ(concat(ll_limits::min()), std::to_string(ll_limits::min()));
+    EXPECT_EQ(concat(ull_limits::max()), std::to_string(ull_limits::max()));
+    // Only `char` is a character, the 8-bit integers are numbers
+    EXPECT_EQ(concat(std::int8_t{-128}, ' ', std::uint8_t{255}), "-128 255");
+    EXPECT_EQ(concat(short{-32768}), "-32768");
+}
+
+TEST(StringConcat, ConcatToThrowsIfTheBufferIsTooSmall) {
+    char buffer[8];
+    EXPECT_EQ(concat_to(buffer, "abc", 1234, '!'), "abc1234!");
+    EXPECT_THROW(concat_to(buffer, "abc", 12345, '!'), std::length_error);
+    EXPECT_EQ(concat_to(std::span<char>{}, ""), "");
+    EXPECT_THROW(concat_to(std::span<char>{}, 'a'), std::length_error);
+}
+
+TEST(StringConcat, AppendKeepsTheExistingContent) {
+    std::string out = "log:";
+    out.reserve(64);
+    const char *const data = out.data();
+    concat_append(out, ' ', "n=", 3);
+    concat_append(out, std::string_view{}, ", ok");
+    EXPECT_EQ(out, "log: n=3, ok");
+    // Fits into the reserved capacity: appended in place
+    EXPECT_EQ(out.data(), data);
+}
+
+// The special members are there only if T's and E's are
+static_assert(std::is_copy_constructible_v<expected<std::string, int>>);
+static_assert(std::is_copy_assignable_v<expected<std::string, int>>);
+static_assert(
+    !std::is_copy_constructible_v<expected<std::unique_ptr<int>, int>>);
+static_assert(!std::is_copy_assignable_v<expected<std::unique_ptr<int>, int>>);
+static_assert(
+    std::is_move_constructible_v<expected<std::unique_ptr<int>, int>>);
+static_assert(
+    std::is_nothrow_move_assignable_v<expected<std::unique_ptr<int>, int>>);
+static_assert(
+    !std::is_copy_constructible_v<expected<int, std::unique_ptr<int>>>);
+
+namespace {
+
+expected<int, std::string> parse_digit(char ch) {
+    if (ch < '0' || ch > '9') {
+        return unexpected{std::string{"not a digit: "} + ch};
+    }
+    return ch - '0';
+}
+
+// Throws on the copy while `fail` is set, counts the live objects
+struct fragile {
+    static inline bool fail{false};
+    static inline int live{0};
+
+    int value;
+
+    explicit fragile(int v) noexcept : value{v} { ++live; }
+    fragile(const fragile &rh) : value{rh.value} {
+        if (fail) {
+            throw std::runtime_error{"copy"};
+        }
+        ++live;
+    }
+    fragile(fragile &&rh) noexcept(false) : fragile(rh) {}
+    fragile &operator=(const fragile &rh) {
+        if (fail) {
+            throw std::runtime_error{"assign"};
+        }
+        value = rh.value;
+        return *this;
+    }
+    ~fragile(void) { --live; }
+};
+
+} // namespace
+
+TEST(Expected, AndThen) {
+    const auto twice = [](int v) -> expected<int, std::string> {
+        if (v > 4) {
+            return unexpected{std::string{"too large"}};
+        }
+        return v * 2;
+    };
+    EXPECT_EQ(parse_digit('3').and_then(twice).value(), 6);
+    EXPECT_EQ(parse_digit('7').and_then(twice).error(), "too large");
+
+    bool called{false};
+    const auto result = parse_digit('x').and_then([&](int v) {
+        called = true;
+        return twice(v);
+    });
+    EXPECT_FALSE(called);
+    EXPECT_EQ(result.error(), "not a digit: x");
+}
+
+TEST(Expected, Transform) {
+    const auto as_text = [](int v) { return std::to_string(v) + "!"; };
+    const auto value = parse_digit('5').transform(as_text);
+    static_assert(std::is_same_v<decltype(value),
+                                 const expected<std::string, std::string>>);
+    EXPECT_EQ(*value, "5!");
+
+    bool called{false};
+    const auto error = parse_digit('-').transform([&](int v) {
+        called = true;
+        return as_text(v);
+    });
+    EXPECT_FALSE(called);
+    EXPECT_EQ(error.error(), "not a digit: -");
+}
+
+TEST(Expected, OrElse) {
+    const auto recover = [](const std::string &) -> expected<int, std::string> {
+        return 0;
+    };
+    EXPECT_EQ(parse_digit('x').or_else(recover).value(), 0);
+    const auto rethrow =
+        [](const std::string &error) -> expected<int, std::string> {
+        return unexpected{"again: " + error};
+    };
+    EXPECT_EQ(parse_digit('x').or_else(rethrow).error(),
+              "again: not a digit: x");
+
+    bool called{false};
+    const auto value = parse_digit('9').or_else([&](const std::string &e) {
+        called = true;
+        return recover(e);
+    });
+    EXPECT_FALSE(called);
+    EXPECT_EQ(value.value(), 9);
+}
+
+TEST(Expected, TransformError) {
+    const auto code = [](const std::string &error) {
+        return static_cast<int>(error.size());
+    };
+    const auto error = parse_digit('x').transform_error(code);
+    static_assert(std::is_same_v<decltype(error), const expected<int, int>>);
+    EXPECT_EQ(error.error(), 14);
+
+    bool called{false};
+    const auto value =
+        parse_digit('1').transform_error([&](const std::string &e) {
+            called = true;
+            return code(e);
+        });
+    EXPECT_FALSE(called);
+    EXPECT_EQ(*value, 1);
+}
+
+TEST(Expected, ChainedMoveOnly) {
+    auto result =
+        expected<std::unique_ptr<int>, std::string>{std::make_unique<int>(4)}
+            .transform([](std::unique_ptr<int> p) { return *p + 1; })
+            .and_then([](int v) -> expected<int, std::string> {
+                return v * 10;
+            });
+    EXPECT_EQ(*result, 50);
+    EXPECT_THROW(parse_digit('x').value(), bad_expected_access<std::string>);
+}
+
+TEST(Expected, AssignmentKeepsTheOldStateOnThrow) {
+    {
+        using fragile_expected = expected<fragile, int>;
+        fragile_expected holder{unexpect, 7};
+        const fragile_expected source{std::in_place, 1};
+
+        fragile::fail = true;
+        EXPECT_THROW(holder = source, std::runtime_error);
+        fragile::fail = false;
+        // Still the error, not a destroyed value
+        ASSERT_FALSE(holder.has_value());
+        EXPECT_EQ(holder.error(), 7);
+
+        holder = source;
+        ASSERT_TRUE(holder.has_value());
+        EXPECT_EQ(holder->value, 1);
+
+        // Value to error and back, the same alternative is assigned
+        holder = fragile_expected{unexpect, 3};
+        EXPECT_EQ(holder.error(), 3);
+        holder = source;
+        holder = source;
+        EXPECT_EQ(holder->value, 1);
+
+        fragile::fail = true;
+        EXPECT_THROW(holder = source, std::runtime_error);
+        fragile::fail = false;
+        EXPECT_TRUE(holder.has_value());
+    }
+    EXPECT_EQ(fragile::live, 0);
+}
+
+TEST(SegmentedVector, IndexingMatchesPushOrder) {
+    small_segmented_vector<int> sv;
+    for (int k = 0; k < 100; ++k) {
+        sv.push_back(k);
+    }
+    ASSERT_EQ(sv.size(), 100u);
+    for (int k = 0; k < 100; ++k) {
+        EXPECT_EQ(sv[static_cast<size_t>(k)], k);
+    }
+    EXPECT_EQ(sv.front(), 0);
+    EXPECT_EQ(sv.back(), 99);
+    EXPECT_THROW(sv.at(100), std::out_of_range);
+}
+
+TEST(SegmentedVector, ReferencesAreStableOnPushBack) {
+    small_segmented_vector<std::string> sv;
+    sv.push_back("first");
+    const std::string *first = &sv.front();
+    for (int k = 0; k < 1000; ++k) {
+        sv.push_back(std::to_string(k));
+    }
+    EXPECT_EQ(first, &sv.front());
+    EXPECT_EQ(*first, "first");
+}
+
+TEST(SegmentedVector, WorksAsAQueue) {
+    small_segmented_vector<std::unique_ptr<int>> sv;
+    std::deque<int> reference;
+    int next{0};
+    for (int round = 0; round < 50; ++round) {
+        for (int k = 0; k < round % 7 + 1; ++k) {
+            sv.push_back(std::make_unique<int>(next));
+            reference.push_back(next++);
+        }
+        for (int k = 0; k < round % 5 + 1 && !sv.empty(); ++k) {
+            EXPECT_EQ(*sv.front(), reference.front());
+            sv.pop_front();
+            reference.pop_front();
+        }
+        ASSERT_EQ(sv.size(), reference.size());
+        for (size_t k = 0; k < sv.size(); ++k) {
+            EXPECT_EQ(*sv[k], reference[k]);
+        }
+    }
+}
+
+TEST(SegmentedVector, IteratorsAreRandomAccess) {
+    small_segmented_vector<int> sv;
+    for (int k = 0; k < 37; ++k) {
+        sv.push_back(k);
+    }
+    sv.pop_front(); // The front isn't at a block boundary
+
+    static_assert(std::random_access_iterator<decltype(sv.begin())>);
+    static_assert(std::random_access_iterator<decltype(sv.cbegin())>);
+
+    EXPECT_EQ(sv.end() - sv.begin(), 36);
+    EXPECT_EQ(std::accumulate(sv.cbegin(), sv.cend(), 0), 36 * 37 / 2);
+    EXPECT_EQ(*(sv.begin() + 10), 11);
+    EXPECT_EQ(sv.begin()[35], 36);
+    auto it = sv.end();
+    --it;
+    EXPECT_EQ(*it, 36);
+}
+
+TEST(SegmentedVector, SegmentsCoverAllElementsInOrder) {
+    small_segmented_vector<int> sv;
+    for (int k = 0; k < 30; ++k) {
+        sv.push_back(k);
+    }
+    sv.pop_front();
+    sv.pop_front();
+    sv.pop_front();
+
+    std::vector<int> seen;
+    size_t segments{0};
+    sv.for_each_segment([&](std::span<int> segment) {
+        EXPECT_LE(segment.size(), sv.block_size);
+        seen.insert(seen.end(), segment.begin(), segment.end());
+        ++segments;
+    });
+    std::vector<int> expected(27);
+    std::iota(expected.begin(), expected.end(), 3);
+    EXPECT_EQ(seen, expected);
+    EXPECT_EQ(segments, 8u); // 1 + 26 / 4 + 1
+
+    // The free function falls back to a single span for vectors
+    std::vector<int> vec(5);
+    size_t vec_segments{0};
+    EXPECT_TRUE(for_each_segment(vec, [&](std::span<int>) { ++vec_segments; }));
+    EXPECT_EQ(vec_segments, 1u);
+    std::deque<int> deq(5);
+    EXPECT_FALSE(for_each_segment(deq, [](std::span<int>) {}));
+}
+
+TEST(SegmentedVector, CopyAndMove) {
+    small_segmented_vector<std::string> sv;
+    for (int k = 0; k < 10; ++k) {
+        sv.push_back(std::to_string(k));
+    }
+    sv.pop_front();
+
+    auto copy = sv;
+    ASSERT_EQ(copy.size(), 9u);
+    EXPECT_EQ(copy.front(), "1");
+    EXPECT_EQ(copy.back(), "9");
+
+    auto moved = std::move(sv);
+    EXPECT_TRUE(sv.empty());
+    EXPECT_EQ(moved.size(), 9u);
+    EXPECT_EQ(moved[8], "9");
+
+    moved.clear();
+    EXPECT_TRUE(moved.empty());
+    moved.push_back("again");
+    EXPECT_EQ(moved.front(), "again");
+}
+
+TEST(FlatHashSet, InsertFindErase) {
+    flat_hash_set<int> set;
+    EXPECT_TRUE(set.empty());
+    EXPECT_FALSE(set.contains(1));
+
+    for (int k = 0; k < 1000; ++k) {
+        EXPECT_TRUE(set.insert(k).second);
+    }
+    EXPECT_FALSE(set.insert(500).second);
+    EXPECT_EQ(set.size(), 1000u);
+    for (int k = 0; k < 1000; ++k) {
+        ASSERT_TRUE(set.contains(k));
+        EXPECT_EQ(*set.find(k), k);
+    }
+    EXPECT_EQ(set.find(1000), set.end());
+
+    for (int k = 0; k < 1000; k += 2) {
+        EXPECT_EQ(set.erase(k), 1u);
+    }
+    EXPECT_EQ(set.erase(0), 0u);
+    EXPECT_EQ(set.size(), 500u);
+    for (int k = 0; k < 1000; ++k) {
+        EXPECT_EQ(set.contains(k), k % 2 == 1);
+    }
+}
+
+TEST(FlatHashSet, IterationVisitsEveryElementOnce) {
+    flat_hash_set<int> set;
+    for (int k = 0; k < 100; ++k) {
+        set.insert(k * 7);
+    }
+    std::vector<int> seen(set.begin(), set.end());
+    std::sort(seen.begin(), seen.end());
+    ASSERT_EQ(seen.size(), 100u);
+    for (int k = 0; k < 100; ++k) {
+        EXPECT_EQ(seen[static_cast<size_t>(k)], k * 7);
+    }
+}
+
+TEST(FlatHashSet, HeterogeneousStringLookup) {
+    flat_string_set set;
+    EXPECT_TRUE(set.insert(std::string_view{"(a)()"}).second);
+    EXPECT_TRUE(set.insert("(a())").second);
+    EXPECT_FALSE(set.insert(std::string{"(a)()"}).second);
+
+    const std::string buffer = "xx(a())xx";
+    EXPECT_TRUE(set.contains(std::string_view{buffer}.substr(2, 5)));
+    EXPECT_FALSE(set.contains(std::string_view{buffer}.substr(0, 5)));
+    EXPECT_EQ(*set.find("(a)()"), "(a)()");
+    EXPECT_EQ(set.erase(std::string_view{"(a())"}), 1u);
+    EXPECT_EQ(set.size(), 1u);
+}
+
+TEST(FlatHashSet, ChurnDoesNotGrowTheTable) {
+    flat_string_set set;
+    set.reserve(64);
+    const auto capacity = set.capacity();
+    // Inserting and erasing the same number of keys: tombstones are purged
+    // by rehashing in place
+    for (int k = 0; k < 100'000; ++k) {
+        set.insert(std::to_string(k));
+        if (set.size() > 32) {
+            set.erase(std::to_string(k - 32));
+        }
+    }
+    EXPECT_EQ(set.size(), 32u);
+    EXPECT_EQ(set.capacity(), capacity);
+    for (int k = 100'000 - 32; k < 100'000; ++k) {
+        EXPECT_TRUE(set.contains(std::to_string(k)));
+    }
+}
+
+namespace {
+
+// Counts the key comparisons, i.e. the slots a probe had to look at
+struct counting_equal {
+    static inline size_t calls{0};
+
+    bool operator()(uint64_t a, uint64_t b) const noexcept {
+        ++calls;
+        return a == b;
+    }
+};
+
+} // namespace
+
+TEST(FlatHashSet, KeysDifferingInHighBitsOnly) {
+    // std::hash<uint64_t> is the identity: the low bits of all the keys are
+    // zero
+    flat_hash_set<uint64_t, std::hash<uint64_t>, counting_equal> set;
+    constexpr uint64_t kKeys{20'000};
+    for (const unsigned shift : {24u, 32u, 48u}) {
+        set.clear();
+        for (uint64_t k = 0; k < kKeys; ++k) {
+            set.insert(k << shift);
+        }
+        counting_equal::calls = 0;
+        for (uint64_t k = 0; k < kKeys; ++k) {
+            ASSERT_TRUE(set.contains(k << shift));
+        }
+        // One comparison per hit, plus the rare 7-bit control byte collisions
+        EXPECT_LT(counting_equal::calls, kKeys * 11 / 10) << "shift " << shift;
+
+        counting_equal::calls = 0;
+        for (uint64_t k = kKeys; k < 2 * kKeys; ++k) {
+            ASSERT_FALSE(set.contains(k << shift));
+        }
+        EXPECT_LT(counting_equal::calls, kKeys / 5) << "shift " << shift;
+    }
+}
+
+TEST(FlatHashSet, CopyAndMove) {
+    flat_string_set set;
+    for (int k = 0; k < 50; ++k) {
+        set.insert(std::to_string(k));
+    }
+    auto copy = set;
+    EXPECT_EQ(copy.size(), 50u);
+    EXPECT_TRUE(copy.contains("49"));
+
+    auto moved = std::move(set);
+    EXPECT_TRUE(set.empty());
+    EXPECT_EQ(moved.size(), 50u);
+    EXPECT_TRUE(moved.contains("0"));
+
+    moved.clear();
+    EXPECT_TRUE(moved.empty());
+    EXPECT_FALSE(moved.contains("0"));
+}
+
+TEST(SequenceIds, SingleThreadIsSequential) {
+    struct tag;
+    using ids = sequence_ids<tag>;
+    ids::set_block_size(4);
+    for (int k = 1; k <= 10; ++k) {
+        EXPECT_EQ(ids::next(), k);
+    }
+    // The current block is used up first
+    ids::set_block_size(100);
+    for (int k = 11; k <= 300; ++k) {
+        EXPECT_EQ(ids::next(), k);
+    }
+    EXPECT_EQ(ids::reserved_end(), 313);
+}
+
+// Build with -DSANDBOX_SANITIZE_THREAD=ON to check for data races as well
+TEST(SequenceIds, UniqueAcrossThreads) {
+    struct tag;
+    using ids = sequence_ids<tag>;
+    ids::set_block_size(16);
+
+    constexpr int threads{8};
+    constexpr int per_thread{20'000};
+    std::vector<std::vector<int>> taken(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&numbers = taken[t], t] {
+            // Some threads switch the block size on the way
+            for (int k = 0; k < per_thread; ++k) {
+                if (t % 2 == 1 && k == per_thread / 2) {
+                    ids::set_block_size(t);
+                }
+                numbers.push_back(ids::next());
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    std::vector<int> all;
+    for (const auto &numbers : taken) {
+        EXPECT_TRUE(std::is_sorted(numbers.begin(), numbers.end()));
+        all.insert(all.end(), numbers.begin(), numbers.end());
+    }
+    std::sort(all.begin(), all.end());
+    EXPECT_EQ(std::adjacent_find(all.begin(), all.end()), all.end());
+    EXPECT_GE(all.front(), 1);
+    EXPECT_LT(all.back(), ids::reserved_end());
+}
+
+TEST(ClassA, ConcurrentConstruction) {
+    A::SetTraceEnabled(false);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 8; ++t) {
+        workers.emplace_back([] {
+            A::CountersSnapshot snapshot;
+            for (int k = 0; k < 5'000; ++k) {
+                A a;
+                auto b = a;
+                auto c = A::TryCreate();
+                EXPECT_TRUE(c.has_value());
+            }
+            EXPECT_EQ(snapshot.Delta().default_ctor, 10'000u);
+            EXPECT_EQ(snapshot.Delta().copy_ctor, 5'000u);
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    A::SetTraceEnabled(true);
+}
+
+namespace {
+
+// Every entry weighs the same: the overhead plus twice the 2-char key
+using int_cache = clock_cache<int>;
+constexpr size_t kIntEntry{int_cache::entry_overhead + 4 + sizeof(int)};
+
+} // namespace
+
+TEST(ClockCache, FindInsertAndStats) {
+    int_cache cache{1 << 20, 4};
+    EXPECT_EQ(cache.find("k1"), nullptr);
+    cache.insert("k1", 1);
+    ASSERT_NE(cache.find("k1"), nullptr);
+    EXPECT_EQ(*cache.find("k1"), 1);
+
+    cache.insert("k1", 2); // Replaces
+    EXPECT_EQ(*cache.find("k1"), 2);
+
+    const auto stats = cache.get_stats();
+    EXPECT_EQ(stats.hits, 3u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.insertions, 1u);
+    EXPECT_EQ(stats.entries, 1u);
+    EXPECT_EQ(stats.bytes, kIntEntry);
+}
+
+TEST(ClockCache, EvictsUnreferencedEntriesFirst) {
+    // A single shard holding four entries
+    int_cache cache{4 * kIntEntry, 1};
+    for (int k = 0; k < 4; ++k) {
+        cache.insert("k" + std::to_string(k), k);
+    }
+    EXPECT_NE(cache.find("k0"), nullptr);
+    EXPECT_NE(cache.find("k2"), nullptr);
+
+    // k1 and k3 were never used since their insertion
+    cache.insert("k4", 4);
+    cache.insert("k5", 5);
+    EXPECT_EQ(cache.find("k1"), nullptr);
+    EXPECT_EQ(cache.find("k3"), nullptr);
+    EXPECT_NE(cache.find("k0"), nullptr);
+    EXPECT_NE(cache.find("k2"), nullptr);
+    EXPECT_NE(cache.find("k4"), nullptr);
+
+    const auto stats = cache.get_stats();
+    EXPECT_EQ(stats.evictions, 2u);
+    EXPECT_EQ(stats.entries, 4u);
+    EXPECT_LE(stats.bytes, 4 * kIntEntry);
+}
+
+TEST(ClockCache, ValuesOutliveEviction) {
+    int_cache cache{kIntEntry, 1};
+    cache.insert("k0", 10);
+    const auto value = cache.find("k0");
+    cache.insert("k1", 11);
+    EXPECT_EQ(cache.find("k0"), nullptr);
+    EXPECT_EQ(*value, 10);
+}
+
+TEST(ClockCache, ConcurrentUse) {
+    clock_cache<std::string> cache{64 * 1024, 8};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&cache, t] {
+            for (int k = 0; k < 20'000; ++k) {
+                const auto key = std::to_string((k * 7 + t) % 3000);
+                if (const auto value = cache.find(key)) {
+                    EXPECT_EQ(*value, key);
+                } else {
+                    cache.insert(key, key);
+                }
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    const auto stats = cache.get_stats();
+    EXPECT_EQ(stats.hits + stats.misses, 80'000u);
+    EXPECT_LE(stats.bytes, 64u * 1024);
+}
+
+TEST(HdrHistogram, SmallValuesAreExact) {
+    HdrHistogram histogram;
+    for (uint64_t value = 1; value <= 100; ++value) {
+        histogram.Record(value);
+    }
+    EXPECT_EQ(histogram.TotalCount(), 100u);
+    EXPECT_EQ(histogram.Min(), 1u);
+    EXPECT_EQ(histogram.Max(), 100u);
+    EXPECT_DOUBLE_EQ(histogram.Mean(), 50.5);
+    EXPECT_EQ(histogram.ValueAtPercentile(50), 50u);
+    EXPECT_EQ(histogram.ValueAtPercentile(99), 99u);
+    EXPECT_EQ(histogram.ValueAtPercentile(100), 100u);
+    EXPECT_EQ(histogram.ValueAtPercentile(0), 1u);
+}
+
+TEST(HdrHistogram, LargeValuesWithinPrecision) {
+    for (const unsigned bits : {3u, 7u, 10u}) {
+        HdrHistogram histogram{bits};
+        const double tolerance = 1.0 / static_cast<double>(1u << bits);
+        for (uint64_t value = 1000; value < (uint64_t{1} << 50);
+             value = value * 3 + 7) {
+            histogram.Reset();
+            histogram.Record(value);
+            const auto reported = histogram.ValueAtPercentile(50);
+            EXPECT_GE(reported, value - value * tolerance) << bits;
+            EXPECT_LE(reported, value) << bits; // Clamped to the max
+        }
+        histogram.Reset();
+        histogram.Record(UINT64_MAX);
+        EXPECT_EQ(histogram.ValueAtPercentile(100), UINT64_MAX);
+    }
+}
+
+TEST(HdrHistogram, TailPercentiles) {
+    HdrHistogram histogram;
+    histogram.Record(1'000, 990);     // 1 us
+    histogram.Record(1'000'000, 9);   // 1 ms
+    histogram.Record(100'000'000, 1); // 100 ms
+    EXPECT_NEAR(histogram.ValueAtPercentile(50), 1'000, 10);
+    EXPECT_NEAR(histogram.ValueAtPercentile(99), 1'000, 10);
+    EXPECT_NEAR(histogram.ValueAtPercentile(99.5), 1'000'000, 10'000);
+    EXPECT_EQ(histogram.ValueAtPercentile(99.99), 100'000'000u);
+}
+
+TEST(HdrHistogram, MergeAndCopy) {
+    HdrHistogram a;
+    HdrHistogram b;
+    a.Record(10, 3);
+    b.Record(20, 1);
+    a.Merge(b);
+    EXPECT_EQ(a.TotalCount(), 4u);
+    EXPECT_EQ(a.Max(), 20u);
+
+    const HdrHistogram copy = a;
+    EXPECT_EQ(copy.TotalCount(), 4u);
+    EXPECT_EQ(copy.ValueAtPercentile(50), 10u);
+
+    HdrHistogram coarse{3};
+    EXPECT_THROW(coarse.Merge(a), std::invalid_argument);
+    coarse = a;
+    EXPECT_EQ(coarse.PrecisionBits(), a.PrecisionBits());
+    EXPECT_EQ(coarse.TotalCount(), 4u);
+}
+
+TEST(HdrHistogram, Dumps) {
+    HdrHistogram histogram;
+    for (uint64_t value = 1; value <= 1000; ++value) {
+        histogram.Record(value * 1000);
+    }
+    std::ostringstream summary;
+    histogram.PrintSummary(summary, "solve");
+    EXPECT_EQ(summary.str().rfind("solve: 1000 samples, min 1.00 us", 0), 0u)
+        << summary.str();
+
+    std::ostringstream distribution;
+    histogram.PrintDistribution(distribution);
+    EXPECT_NE(distribution.str().find("100.000000"), std::string::npos);
+
+    std::ostringstream json;
+    histogram.PrintJson(json);
+    EXPECT_EQ(json.str().rfind("{\"count\": 1000, \"min\": 1000, ", 0), 0u)
+        << json.str();
+    EXPECT_NE(json.str().find("\"buckets\": [["), std::string::npos);
+}
+
+TEST(HdrHistogram, PerThreadMerge) {
+    PerThreadHistograms latencies;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&latencies, t] {
+            auto &local = latencies.Local();
+            EXPECT_EQ(&local, &latencies.Local());
+            for (int k = 0; k < 1000; ++k) {
+                local.Record(static_cast<uint64_t>(t * 1000 + k));
+            }
+            ScopedLatencyTimer timer{local};
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    const auto merged = latencies.Merged();
+    EXPECT_EQ(merged.TotalCount(), 4004u);
+    EXPECT_EQ(merged.Min(), 0u);
+}
+
+TEST(HdrHistogram, PerThreadSwitchingInstances) {
+    // Back and forth: a thread keeps a single histogram per instance
+    PerThreadHistograms first;
+    PerThreadHistograms second;
+    HdrHistogram *first_local = &first.Local();
+    for (int k = 0; k < 1000; ++k) {
+        first.Local().Record(1);
+        second.Local().Record(2);
+    }
+    EXPECT_EQ(&first.Local(), first_local);
+    EXPECT_EQ(first.Merged().TotalCount(), 1000u);
+    EXPECT_EQ(second.Merged().TotalCount(), 1000u);
+    EXPECT_EQ(second.Merged().Min(), 2u);
+
+    // Short-lived instances, as many as the recursion program makes
+    for (int k = 0; k < 10'000; ++k) {
+        PerThreadHistograms latencies;
+        latencies.Local().Record(static_cast<uint64_t>(k));
+        ASSERT_EQ(latencies.Merged().TotalCount(), 1u);
+    }
+    EXPECT_EQ(&first.Local(), first_local);
+}
+
+namespace {
+
+// Unsynchronized increments, correct only if the lock excludes
+template <class Lock> void expect_mutual_exclusion(Lock &lock) {
+    constexpr int threads{8};
+    constexpr int per_thread{20'000};
+    long counter{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            for (int k = 0; k < per_thread; ++k) {
+                std::lock_guard guard{lock};
+                counter = counter + 1;
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    EXPECT_EQ(counter, long{threads} * per_thread);
+}
+
+} // namespace
+
+TEST(SyncPrimitives, AdaptiveMutex) {
+    adaptive_mutex mutex;
+    ASSERT_TRUE(mutex.try_lock());
+    EXPECT_FALSE(mutex.try_lock());
+    mutex.unlock();
+    expect_mutual_exclusion(mutex);
+
+    adaptive_mutex no_spinning{0};
+    expect_mutual_exclusion(no_spinning);
+}
+
+TEST(SyncPrimitives, TicketLock) {
+    ticket_lock lock;
+    ASSERT_TRUE(lock.try_lock());
+    EXPECT_FALSE(lock.try_lock());
+    lock.unlock();
+    expect_mutual_exclusion(lock);
+
+    ticket_lock no_spinning{0};
+    expect_mutual_exclusion(no_spinning);
+}
+
+TEST(SyncPrimitives, RwLockExclusive) {
+    rw_lock lock;
+    expect_mutual_exclusion(lock);
+
+    rw_lock no_spinning{0};
+    expect_mutual_exclusion(no_spinning);
+}
+
+TEST(SyncPrimitives, RwLockSharesReaders) {
+    rw_lock lock;
+    std::shared_lock first{lock};
+    EXPECT_TRUE(lock.try_lock_shared());
+    EXPECT_FALSE(lock.try_lock());
+    lock.unlock_shared();
+    first.unlock();
+    EXPECT_TRUE(lock.try_lock());
+    EXPECT_FALSE(lock.try_lock_shared());
+    lock.unlock();
+}
+
+TEST(SyncPrimitives, RwLockPrefersWriters) {
+    rw_lock lock;
+    lock.lock_shared();
+
+    std::atomic<bool> written{false};
+    std::thread writer{[&] {
+        std::lock_guard guard{lock};
+        written = true;
+    }};
+    // Once the writer waits, new readers don't get in
+    while (lock.try_lock_shared()) {
+        lock.unlock_shared();
+        std::this_thread::yield();
+    }
+    EXPECT_FALSE(written);
+
+    lock.unlock_shared();
+    writer.join();
+    EXPECT_TRUE(written);
+    EXPECT_TRUE(lock.try_lock_shared());
+    lock.unlock_shared();
+}
+
+TEST(SyncPrimitives, RwLockReadersSeeWholeWrites) {
+    rw_lock lock{0};
+    std::pair<long, long> value{0, 0}; // Always equal under the lock
+    std::atomic<long> torn{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 8; ++t) {
+        workers.emplace_back([&, t] {
+            for (int k = 0; k < 10'000; ++k) {
+                if (t % 4 == 0) {
+                    std::lock_guard guard{lock};
+                    ++value.first;
+                    ++value.second;
+                } else {
+                    std::shared_lock guard{lock};
+                    if (value.first != value.second) {
+                        ++torn;
+                    }
+                }
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    EXPECT_EQ(torn, 0);
+    EXPECT_EQ(value.first, 20'000);
+}
+
+static_assert(relocation_of<int> == relocation::bitwise);
+static_assert(relocation_of<std::pair<int, double>> == relocation::bitwise);
+static_assert(relocation_of<std::unique_ptr<int>> == relocation::bitwise);
+static_assert(relocation_of<std::string> == relocation::move);
+// The noexcept(false) destructor doesn't matter, the move constructor can't
+// throw
+static_assert(!std::is_nothrow_move_constructible_v<A>);
+static_assert(relocation_of<A> == relocation::move);
+
+TEST(RelocatingVector, GrowthKeepsValues) {
+    relocating_vector<std::unique_ptr<int>> pointers;
+    relocating_vector<std::string> strings;
+    for (int k = 0; k < 1000; ++k) {
+        pointers.push_back(std::make_unique<int>(k));
+        strings.emplace_back(static_cast<size_t>(k % 40), 'x');
+    }
+    ASSERT_EQ(pointers.size(), 1000u);
+    for (int k = 0; k < 1000; ++k) {
+        EXPECT_EQ(*pointers[k], k);
+        EXPECT_EQ(strings[k], std::string(static_cast<size_t>(k % 40), 'x'));
+    }
+
+    auto copy = strings;
+    strings.resize(10);
+    strings.shrink_to_fit();
+    EXPECT_EQ(strings.capacity(), 10u);
+    EXPECT_EQ(copy.size(), 1000u);
+    EXPECT_EQ(copy.back(), std::string(999 % 40, 'x'));
+    EXPECT_THROW(strings.at(10), std::out_of_range);
+}
+
+TEST(RelocatingVector, PushBackOfOwnElement) {
+    relocating_vector<std::string> strings;
+    relocating_vector<std::pair<int, double>> pairs;
+    strings.push_back(std::string(100, 'a'));
+    pairs.emplace_back(1, 2.0);
+    for (int k = 0; k < 100; ++k) {
+        // Every other one reallocates
+        strings.push_back(strings.front());
+        pairs.push_back(pairs.front());
+    }
+    for (const auto &str : strings) {
+        EXPECT_EQ(str, std::string(100, 'a'));
+    }
+    for (const auto &pair : pairs) {
+        EXPECT_EQ(pair, std::make_pair(1, 2.0));
+    }
+}
+
+TEST(RelocatingVector, MovesA) {
+    A::SetTraceEnabled(false);
+    {
+        A::CountersSnapshot snapshot;
+        std::vector<A> as;
+        for (int k = 0; k < 100; ++k) {
+            as.emplace_back(k);
+        }
+        EXPECT_GT(snapshot.Delta().copy_ctor, 0u);
+    }
+    {
+        A::CountersSnapshot snapshot;
+        relocating_vector<A> as;
+        for (int k = 0; k < 100; ++k) {
+            as.emplace_back(k);
+        }
+        EXPECT_EQ(snapshot.Delta().copy_ctor, 0u);
+        EXPECT_GT(snapshot.Delta().move_ctor, 0u);
+    }
+    A::SetTraceEnabled(true);
+}
+
+namespace {
+
+// Copies, and throws on the copy number `fail_at`
+struct throwing_copy {
+    static inline int copies{0};
+    static inline int fail_at{-1};
+
+    int value;
+
+    explicit throwing_copy(int v) : value{v} {}
+    throwing_copy(const throwing_copy &rh) : value{rh.value} {
+        if (++copies == fail_at) {
+            throw std::runtime_error{"copy"};
+        }
+    }
+    throwing_copy(throwing_copy &&rh) noexcept(false) : throwing_copy(rh) {}
+};
+
+} // namespace
+
+TEST(RelocatingVector, StrongGuaranteeWhenCopying) {
+    static_assert(relocation_of<throwing_copy> == relocation::copy);
+    relocating_vector<throwing_copy> values;
+    values.reserve(4);
+    for (int k = 0; k < 4; ++k) {
+        values.emplace_back(k);
+    }
+    throwing_copy::copies = 0;
+    throwing_copy::fail_at = 3;
+    EXPECT_THROW(values.emplace_back(4), std::runtime_error);
+    ASSERT_EQ(values.size(), 4u);
+    EXPECT_EQ(values.capacity(), 4u);
+    for (int k = 0; k < 4; ++k) {
+        EXPECT_EQ(values[k].value, k);
+    }
+    throwing_copy::fail_at = -1;
+    values.emplace_back(4);
+    EXPECT_EQ(values.back().value, 4);
+}
+
+namespace {
+
+generator<int> iota(int from, int *resumed) {
+    for (;;) {
+        ++*resumed;
+        co_yield from++;
+    }
+}
+
+generator<std::string> words(std::string text) {
+    std::string word;
+    for (const char c : text) {
+        if (c != ' ') {
+            word += c;
+        } else if (!word.empty()) {
+            co_yield std::move(word);
+            word.clear();
+        }
+    }
+    if (!word.empty()) {
+        co_yield word;
+    }
+}
+
+generator<int> throws_after(int count) {
+    for (int k = 0; k < count; ++k) {
+        co_yield k;
+    }
+    throw std::runtime_error{"done"};
+}
+
+} // namespace
+
+TEST(Generator, RunsOnlyWhenPulled) {
+    int resumed{0};
+    auto numbers = iota(1, &resumed);
+    EXPECT_EQ(resumed, 0);
+
+    std::vector<int> taken;
+    for (const int value : numbers) {
+        if (value > 5) {
+            break;
+        }
+        taken.push_back(value);
+    }
+    EXPECT_EQ(taken, (std::vector<int>{1, 2, 3, 4, 5}));
+    EXPECT_EQ(resumed, 6);
+}
+
+TEST(Generator, YieldedValuesCanBeMoved) {
+    std::vector<std::string> taken;
+    for (auto &word : words("  a long enough sentence ")) {
+        taken.push_back(std::move(word));
+    }
+    EXPECT_EQ(taken,
+              (std::vector<std::string>{"a", "long", "enough", "sentence"}));
+
+    auto none = words("   ");
+    EXPECT_TRUE(none.begin() == none.end());
+}
+
+TEST(Generator, RethrowsAndMoves) {
+    auto numbers = throws_after(2);
+    auto moved = std::move(numbers);
+    auto it = moved.begin();
+    EXPECT_EQ(*it, 0);
+    ++it;
+    EXPECT_EQ(*it, 1);
+    EXPECT_THROW(++it, std::runtime_error);
+    EXPECT_TRUE(it == moved.end());
+}
+
+TEST(PackedColumn, PicksTheNarrowestEncoding) {
+    EXPECT_EQ(packed_column<int>(5, 5).encoding(), packed_encoding::bits1);
+    EXPECT_EQ(packed_column<int>(120, 135).encoding(), packed_encoding::bits4);
+    EXPECT_EQ(packed_column<int>(0, 255).encoding(), packed_encoding::bytes1);
+    EXPECT_EQ(packed_column<int>(-100, 100).encoding(),
+              packed_encoding::bytes1);
+    EXPECT_EQ(packed_column<int>(0, 256).encoding(), packed_encoding::bytes2);
+    EXPECT_EQ(packed_column<int>(INT32_MIN, INT32_MAX).encoding(),
+              packed_encoding::bytes4);
+    EXPECT_THROW(packed_column<int>(0, 255, packed_encoding::bits4),
+                 std::invalid_argument);
+}
+
+TEST(PackedColumn, RandomAccessAndCountEqual) {
+    // Odd sizes, so every encoding has a partial tail
+    std::vector<int> values(10'007);
+    int generator{0};
+    for (auto &value : values) {
+        value = 120 + (++generator) * 7 % 16;
+    }
+    for (const auto encoding :
+         {packed_encoding::bits4, packed_encoding::bytes1,
+          packed_encoding::bytes2, packed_encoding::bytes4}) {
+        const auto column = packed_column<int>::encode(values, encoding);
+        ASSERT_EQ(column.size(), values.size());
+        for (size_t k = 0; k < values.size(); ++k) {
+            ASSERT_EQ(column[k], values[k]) << k;
+        }
+        for (int needle = 118; needle < 138; ++needle) {
+            EXPECT_EQ(column.count_equal(needle),
+                      static_cast<size_t>(
+                          std::count(values.begin(), values.end(), needle)))
+                << needle;
+        }
+    }
+}
+
+TEST(PackedColumn, BitWidths) {
+    for (const int range : {1, 3}) {
+        std::vector<int> values;
+        for (int k = 0; k < 1000; ++k) {
+            values.push_back(-10 + (k * 7) % (range + 1));
+        }
+        const auto column = packed_column<int>::encode(values);
+        EXPECT_EQ(column.bits_per_value(), range == 1 ? 1u : 2u);
+        EXPECT_EQ(column.memory_bytes(), range == 1 ? 128u : 256u);
+        for (int needle = -10; needle <= -10 + range; ++needle) {
+            EXPECT_EQ(column.count_equal(needle),
+                      static_cast<size_t>(
+                          std::count(values.begin(), values.end(), needle)));
+        }
+        EXPECT_EQ(column.at(999), values[999]);
+        EXPECT_THROW(column.at(1000), std::out_of_range);
+    }
+}
+
+TEST(PackedColumn, AppendWithinADeclaredRange) {
+    packed_column<int> column{0, 255};
+    for (int k = 0; k < 100'000; ++k) {
+        column.push_back(k % 256);
+    }
+    EXPECT_THROW(column.push_back(256), std::out_of_range);
+    EXPECT_EQ(column.count_equal(126), 391u);
+    EXPECT_EQ(column.count_equal(300), 0u);
+    EXPECT_EQ(column.memory_bytes(), 100'000u);
+
+    auto copy = column;
+    auto moved = std::move(column);
+    EXPECT_EQ(copy.count_equal(126), 391u);
+    EXPECT_EQ(moved[1234], 1234 % 256);
+    EXPECT_TRUE(column.empty());
+}
+
+TEST(HugePageAllocator, SmallAllocationsComeFromOperatorNew) {
+    struct alignas(64) line {
+        char bytes[64];
+    };
+    huge_page_allocator<line> allocator;
+    const auto before = get_huge_page_stats();
+    line *lines = allocator.allocate(10);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(lines) % alignof(line), 0u);
+    lines[9].bytes[63] = 1;
+    allocator.deallocate(lines, 10);
+    EXPECT_EQ(get_huge_page_stats().mapped_bytes, before.mapped_bytes);
+}
+
+TEST(HugePageAllocator, LargeAllocationsAreMappedAligned) {
+    constexpr size_t huge_page = size_t{2} << 20;
+    for (const bool populate : {false, true}) {
+        for (const bool thp : {false, true}) {
+            huge_page_allocator<int> allocator{
+                {.populate = populate, .transparent_huge_pages = thp}};
+            const auto before = get_huge_page_stats();
+            const size_t n = huge_page / sizeof(int) + 1;
+            int *ints = allocator.allocate(n);
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(ints) % huge_page, 0u);
+            ints[0] = 1;
+            ints[n - 1] = 2;
+            // Rounded up to whole huge pages
+            EXPECT_EQ(get_huge_page_stats().mapped_bytes - before.mapped_bytes,
+                      2 * huge_page);
+            allocator.deallocate(ints, n);
+        }
+    }
+}
+
+TEST(HugePageAllocator, HugetlbMapsOrFallsBack) {
+    huge_page_allocator<char> allocator{{.use_hugetlb = true}};
+    const auto before = get_huge_page_stats();
+    char *bytes = allocator.allocate(3 << 20);
+    bytes[(3 << 20) - 1] = 1;
+    const auto after = get_huge_page_stats();
+    EXPECT_TRUE(after.hugetlb_bytes > before.hugetlb_bytes ||
+                after.hugetlb_fallbacks > before.hugetlb_fallbacks);
+    // Unmapped with the length it was mapped with, whatever the page size
+    allocator.deallocate(bytes, 3 << 20);
+}
+
+TEST(HugePageAllocator, ThrowsOnOverflow) {
+    huge_page_allocator<uint64_t> allocator;
+    EXPECT_THROW(allocator.allocate(std::numeric_limits<size_t>::max() / 4),
+                 std::bad_array_new_length);
+    EXPECT_THROW(allocator.allocate(std::numeric_limits<size_t>::max() / 16),
+                 std::bad_alloc);
+}
+
+TEST(HugePageAllocator, BacksContainers) {
+    // Growth crosses the threshold: both kinds of allocations are freed
+    huge_page_allocator<int> allocator{{.threshold = 4096}};
+    std::vector<int, huge_page_allocator<int>> ints{allocator};
+    for (int k = 0; k < 1'000'000; ++k) {
+        ints.push_back(k);
+    }
+    EXPECT_EQ(std::accumulate(ints.begin(), ints.end(), int64_t{0}),
+              int64_t{999'999} * 1'000'000 / 2);
+
+    auto copy = ints;
+    EXPECT_EQ(copy.get_allocator(), allocator);
+    EXPECT_NE(copy.get_allocator(), huge_page_allocator<int>{});
+    EXPECT_EQ(copy, ints);
+
+    std::vector<std::string, huge_page_allocator<std::string>> strings{
+        huge_page_allocator<std::string>{{.threshold = 0}}};
+    strings.assign(1000, "a string longer than the small buffer");
+    EXPECT_EQ(strings.back().size(), 37u);
+}
@@ -0,0 +1,366 @@
+#pragma once
+
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace cpp_core_sandbox {
+
+// A subset of C++23 `std::expected` for compilers which don't ship it yet:
+// either a value of T or an error of E, with monadic chaining (`and_then`,
+// `transform`, `or_else`, `transform_error`).
+//
+// Unlike an exception, an error travels back through ordinary returns, so the
+// cost of failing is the same as the cost of succeeding.
+
+template <class E> class unexpected {
+  public:
+    template <class Err = E,
+              class = std::enable_if_t<
+                  !std::is_same_v<std::remove_cvref_t<Err>, unexpected> &&
+                  std::is_constructible_v<E, Err>>>
+    constexpr explicit unexpected(Err &&error)
+        : error_(std::forward<Err>(error)) {}
+
+    template <class... Args>
+    constexpr explicit unexpected(std::in_place_t, Args &&...args)
+        : error_(std::forward<Args>(args)...) {}
+
+    constexpr E &error(void) & noexcept { return error_; }
+    constexpr const E &error(void) const & noexcept { return error_; }
+    constexpr E &&error(void) && noexcept { return std::move(error_); }
+
+  private:
+    E error_;
+};
+
+template <class E> unexpected(E) -> unexpected<E>;
+
+struct unexpect_t {
+    explicit unexpect_t(void) = default;
+};
+inline constexpr unexpect_t unexpect{};
+
+template <class E> class bad_expected_access : public std::exception {
+  public:
+    explicit bad_expected_access(E error) : error_(std::move(error)) {}
+
+    const char *what(void) const noexcept override {
+        return "bad expected access";
+    }
+
+    const E &error(void) const & noexcept { return error_; }
+
+  private:
+    E error_;
+};
+
+template <class T, class E> class expected {
+    static_assert(!std::is_reference_v<T> && !std::is_void_v<T>,
+                  "T must be an object type");
+
+    template <class U, class G> friend class expected;
+
+  public:
+    using value_type = T;
+    using error_type = E;
+
+    template <class U> using rebind = expected<U, error_type>;
+
+    // Value construction
+    constexpr expected(void)
+        requires std::is_default_constructible_v<T>
+        : has_value_{true} {
+        std::construct_at(std::addressof(value_));
+    }
+
+    template <class U = T>
+        requires(!std::is_same_v<std::remove_cvref_t<U>, expected> &&
+                 !std::is_same_v<std::remove_cvref_t<U>, std::in_place_t> &&
+                 std::is_constructible_v<T, U>)
+    constexpr expected(U &&value) : has_value_{true} {
+        std::construct_at(std::addressof(value_), std::forward<U>(value));
+    }
+
+    template <class... Args>
+    constexpr explicit expected(std::in_place_t, Args &&...args)
+        : has_value_{true} {
+        std::construct_at(std::addressof(value_), std::forward<Args>(args)...);
+    }
+
+    // Error construction
+    template <class G>
+    constexpr expected(const unexpected<G> &error) : has_value_{false} {
+        std::construct_at(std::addressof(error_), error.error());
+    }
+
+    template <class G>
+    constexpr expected(unexpected<G> &&error) : has_value_{false} {
+        std::construct_at(std::addressof(error_), std::move(error).error());
+    }
+
+    template <class... Args>
+    constexpr explicit expected(unexpect_t, Args &&...args)
+        : has_value_{false} {
+        std::construct_at(std::addressof(error_), std::forward<Args>(args)...);
+    }
+
+    constexpr expected(const expected &rh)
+        requires std::is_copy_constructible_v<T> &&
+                 std::is_copy_constructible_v<E>
+        : has_value_{rh.has_value_} {
+        if (has_value_) {
+            std::construct_at(std::addressof(value_), rh.value_);
+        } else {
+            std::construct_at(std::addressof(error_), rh.error_);
+        }
+    }
+
+    constexpr expected(expected &&rh) noexcept(
+        std::is_nothrow_move_constructible_v<T> &&
+        std::is_nothrow_move_constructible_v<E>)
+        requires std::is_move_constructible_v<T> &&
+                 std::is_move_constructible_v<E>
+        : has_value_{rh.has_value_} {
+        if (has_value_) {
+            std::construct_at(std::addressof(value_), std::move(rh.value_));
+        } else {
+            std::construct_at(std::addressof(error_), std::move(rh.error_));
+        }
+    }
+
+    // As in std::expected: the same alternative is assigned, a different one
+    // is constructed in place of the old one (see `_reinit`). An exception
+    // leaves the old value or error in place
+    constexpr expected &operator=(const expected &rh)
+        requires std::is_copy_constructible_v<T> &&
+                 std::is_copy_assignable_v<T> &&
+                 std::is_copy_constructible_v<E> &&
+                 std::is_copy_assignable_v<E> &&
+                 (std::is_nothrow_move_constructible_v<T> ||
+                  std::is_nothrow_move_constructible_v<E>)
+    {
+        _assign(rh);
+        return *this;
+    }
+
+    constexpr expected &operator=(expected &&rh) noexcept(
+        std::is_nothrow_move_constructible_v<T> &&
+        std::is_nothrow_move_assignable_v<T> &&
+        std::is_nothrow_move_constructible_v<E> &&
+        std::is_nothrow_move_assignable_v<E>)
+        requires std::is_move_constructible_v<T> &&
+                 std::is_move_assignable_v<T> &&
+                 std::is_move_constructible_v<E> &&
+                 std::is_move_assignable_v<E> &&
+                 (std::is_nothrow_move_constructible_v<T> ||
+                  std::is_nothrow_move_constructible_v<E>)
+    {
+        _assign(std::move(rh));
+        return *this;
+    }
+
+    constexpr ~expected(void) { _destroy(); }
+
+    // Observers
+    constexpr bool has_value(void) const noexcept { return has_value_; }
+    constexpr explicit operator bool(void) const noexcept { return has_value_; }
+
+    constexpr T &value(void) & {
+        _check();
+        return value_;
+    }
+    constexpr const T &value(void) const & {
+        _check();
+        return value_;
+    }
+    constexpr T &&value(void) && {
+        _check();
+        return std::move(value_);
+    }
+
+    constexpr E &error(void) & noexcept { return error_; }
+    constexpr const E &error(void) const & noexcept { return error_; }
+    constexpr E &&error(void) && noexcept { return std::move(error_); }
+
+    constexpr T &operator*(void) & noexcept { return value_; }
+    constexpr const T &operator*(void) const & noexcept { return value_; }
+    constexpr T &&operator*(void) && noexcept { return std::move(value_); }
+
+    constexpr T *operator->(void) noexcept { return std::addressof(value_); }
+    constexpr const T *operator->(void) const noexcept {
+        return std::addressof(value_);
+    }
+
+    template <class U> constexpr T value_or(U &&default_value) const & {
+        return has_value_ ? value_
+                          : static_cast<T>(std::forward<U>(default_value));
+    }
+
+    // Monadic operations
+
+    // f( value ) -> expected< U, E >
+    template <class F> constexpr auto and_then(F &&f) & {
+        return _and_then(*this, std::forward<F>(f));
+    }
+    template <class F> constexpr auto and_then(F &&f) const & {
+        return _and_then(*this, std::forward<F>(f));
+    }
+    template <class F> constexpr auto and_then(F &&f) && {
+        return _and_then(std::move(*this), std::forward<F>(f));
+    }
+
+    // f( value ) -> U
+    template <class F> constexpr auto transform(F &&f) & {
+        return _transform(*this, std::forward<F>(f));
+    }
+    template <class F> constexpr auto transform(F &&f) const & {
+        return _transform(*this, std::forward<F>(f));
+    }
+    template <class F> constexpr auto transform(F &&f) && {
+        return _transform(std::move(*this), std::forward<F>(f));
+    }
+
+    // f( error ) -> expected< T, G >
+    template <class F> constexpr auto or_else(F &&f) & {
+        return _or_else(*this, std::forward<F>(f));
+    }
+    template <class F> constexpr auto or_else(F &&f) const & {
+        return _or_else(*this, std::forward<F>(f));
+    }
+    template <class F> constexpr auto or_else(F &&f) && {
+        return _or_else(std::move(*this), std::forward<F>(f));
+    }
+
+    // f( error ) -> G
+    template <class F> constexpr auto transform_error(F &&f) & {
+        return _transform_error(*this, std::forward<F>(f));
+    }
+    template <class F> constexpr auto transform_error(F &&f) const & {
+        return _transform_error(*this, std::forward<F>(f));
+    }
+    template <class F> constexpr auto transform_error(F &&f) && {
+        return _transform_error(std::move(*this), std::forward<F>(f));
+    }
+
+  private:
+    template <class Self, class F>
+    static constexpr auto _and_then(Self &&self, F &&f) {
+        using result_type = std::remove_cvref_t<
+            std::invoke_result_t<F, decltype(std::forward<Self>(self).value_)>>;
+        static_assert(std::is_same_v<typename result_type::error_type, E>,
+                      "and_then() must keep the error type");
+        if (self.has_value_) {
+            return std::invoke(std::forward<F>(f),
+                               std::forward<Self>(self).value_);
+        }
+        return result_type{unexpect, std::forward<Self>(self).error_};
+    }
+
+    template <class Self, class F>
+    static constexpr auto _transform(Self &&self, F &&f) {
+        using value_type = std::remove_cv_t<
+            std::invoke_result_t<F, decltype(std::forward<Self>(self).value_)>>;
+        using result_type = expected<value_type, E>;
+        if (self.has_value_) {
+            return result_type{std::in_place,
+                               std::invoke(std::forward<F>(f),
+                                           std::forward<Self>(self).value_)};
+        }
+        return result_type{unexpect, std::forward<Self>(self).error_};
+    }
+
+    template <class Self, class F>
+    static constexpr auto _or_else(Self &&self, F &&f) {
+        using result_type = std::remove_cvref_t<
+            std::invoke_result_t<F, decltype(std::forward<Self>(self).error_)>>;
+        static_assert(std::is_same_v<typename result_type::value_type, T>,
+                      "or_else() must keep the value type");
+        if (self.has_value_) {
+            return result_type{std::in_place, std::forward<Self>(self).value_};
+        }
+        return std::invoke(std::forward<F>(f), std::forward<Self>(self).error_);
+    }
+
+    template <class Self, class F>
+    static constexpr auto _transform_error(Self &&self, F &&f) {
+        using error_type = std::remove_cv_t<
+            std::invoke_result_t<F, decltype(std::forward<Self>(self).error_)>>;
+        using result_type = expected<T, error_type>;
+        if (self.has_value_) {
+            return result_type{std::in_place, std::forward<Self>(self).value_};
+        }
+        return result_type{unexpect,
+                           std::invoke(std::forward<F>(f),
+                                       std::forward<Self>(self).error_)};
+    }
+
+    template <class Rh> constexpr void _assign(Rh &&rh) {
+        if (has_value_ && rh.has_value_) {
+            value_ = std::forward<Rh>(rh).value_;
+        } else if (!has_value_ && !rh.has_value_) {
+            error_ = std::forward<Rh>(rh).error_;
+        } else if (has_value_) {
+            _reinit(error_, value_, std::forward<Rh>(rh).error_);
+            has_value_ = false;
+        } else {
+            _reinit(value_, error_, std::forward<Rh>(rh).value_);
+            has_value_ = true;
+        }
+    }
+
+    // Replaces `old_member` with `new_member` constructed from `args`. If
+    // the construction throws, `old_member` is alive again: either it's
+    // destroyed only once the new one is built, or it's backed up, which
+    // can't throw as one of T and E is nothrow move constructible
+    template <class New, class Old, class... Args>
+    static constexpr void _reinit(New &new_member, Old &old_member,
+                                  Args &&...args) {
+        if constexpr (std::is_nothrow_constructible_v<New, Args...>) {
+            std::destroy_at(std::addressof(old_member));
+            std::construct_at(std::addressof(new_member),
+                              std::forward<Args>(args)...);
+        } else if constexpr (std::is_nothrow_move_constructible_v<New>) {
+            New tmp(std::forward<Args>(args)...);
+            std::destroy_at(std::addressof(old_member));
+            std::construct_at(std::addressof(new_member), std::move(tmp));
+        } else {
+            static_assert(std::is_nothrow_move_constructible_v<Old>);
+            Old backup(std::move(old_member));
+            std::destroy_at(std::addressof(old_member));
+            try {
+                std::construct_at(std::addressof(new_member),
+                                  std::forward<Args>(args)...);
+            } catch (...) {
+                std::construct_at(std::addressof(old_member),
+                                  std::move(backup));
+                throw;
+            }
+        }
+    }
+
+    constexpr void _check(void) const {
+        if (!has_value_) {
+            throw bad_expected_access<E>{error_};
+        }
+    }
+
+    constexpr void _destroy(void) noexcept {
+        if (has_value_) {
+            std::destroy_at(std::addressof(value_));
+        } else {
+            std::destroy_at(std::addressof(error_));
+        }
+    }
+
+    union {
+        T value_;
+        E error_;
+    };
+    bool has_value_;
+};
+
+} // namespace cpp_core_sandbox
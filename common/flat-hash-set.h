@@ -0,0 +1,431 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace cpp_core_sandbox {
+
+// Hashes std::string, string_view and literals alike, so a set of std::string
+// can be probed with a string_view (and no temporary std::string)
+struct string_hash {
+    using is_transparent = void;
+
+    std::size_t operator()(std::string_view str) const noexcept {
+        return std::hash<std::string_view>{}(str);
+    }
+};
+
+// An open addressing hash set in the style of Abseil's Swiss table.
+//
+// Elements are stored inline in a single array (no node per element). A
+// separate array holds a control byte per slot: empty, deleted, or the low 7
+// bits of the element's hash. Slots are probed a group of 16 at a time: one
+// SSE2 comparison of the control bytes yields the candidates whose hash bits
+// match, and only those elements are compared. Most failed lookups never touch
+// the elements at all.
+//
+// Erase leaves no tombstone when the slot's group still has an empty slot:
+// a probe would have stopped at that group anyway.
+//
+// With a transparent `Hash` and `KeyEqual` (see `string_hash`), lookups and
+// `insert` accept any type the key can be compared with; `insert` constructs
+// the key only if it isn't in the set yet.
+//
+// Iterators and references are invalidated by rehashing, i.e. by an insert
+// which grows the table.
+template <class Key, class Hash = std::hash<Key>,
+          class KeyEqual = std::equal_to<Key>>
+class flat_hash_set {
+    static constexpr std::size_t kGroupSize{16};
+
+    using _Ctrl = int8_t;
+    static constexpr _Ctrl kEmpty{-128};  // 0b10000000
+    static constexpr _Ctrl kDeleted{-2};  // 0b11111110
+    // Full slots hold 0b0xxxxxxx: 7 bits of the hash
+
+    template <class K>
+    static constexpr bool _is_transparent =
+        requires { typename Hash::is_transparent; } &&
+        requires { typename KeyEqual::is_transparent; } &&
+        std::is_invocable_v<const Hash &, const K &>;
+
+    template <class K>
+    using _lookup_t = std::conditional_t<_is_transparent<K>, K, Key>;
+
+    class _Iterator;
+
+  public:
+    using key_type = Key;
+    using value_type = Key;
+    using size_type = std::size_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using iterator = _Iterator; // Elements are immutable, as in std::set
+    using const_iterator = _Iterator;
+
+    flat_hash_set(void) noexcept = default;
+
+    flat_hash_set(const flat_hash_set &rh) : hash_(rh.hash_), eq_(rh.eq_) {
+        if (rh.empty()) {
+            return;
+        }
+        reserve(rh.size_);
+        for (const auto &key : rh) {
+            _insert_new(key, _hash(key));
+        }
+    }
+
+    flat_hash_set(flat_hash_set &&rh) noexcept
+        : ctrl_(std::exchange(rh.ctrl_, nullptr)),
+          slots_(std::exchange(rh.slots_, nullptr)),
+          capacity_(std::exchange(rh.capacity_, 0)),
+          size_(std::exchange(rh.size_, 0)),
+          tombstones_(std::exchange(rh.tombstones_, 0)), hash_(rh.hash_),
+          eq_(rh.eq_) {}
+
+    flat_hash_set &operator=(flat_hash_set rh) noexcept {
+        swap(rh);
+        return *this;
+    }
+
+    ~flat_hash_set(void) {
+        clear();
+        _deallocate();
+    }
+
+    void swap(flat_hash_set &rh) noexcept {
+        std::swap(ctrl_, rh.ctrl_);
+        std::swap(slots_, rh.slots_);
+        std::swap(capacity_, rh.capacity_);
+        std::swap(size_, rh.size_);
+        std::swap(tombstones_, rh.tombstones_);
+        std::swap(hash_, rh.hash_);
+        std::swap(eq_, rh.eq_);
+    }
+
+    size_type size(void) const noexcept { return size_; }
+    bool empty(void) const noexcept { return size_ == 0; }
+    size_type capacity(void) const noexcept { return capacity_; }
+
+    template <class K = Key>
+    const_iterator find(const K &key) const noexcept {
+        const _lookup_t<K> &lookup = key;
+        const size_type slot = _find(lookup, _hash(lookup));
+        return slot == kNpos ? end() : const_iterator{this, slot};
+    }
+
+    template <class K = Key> bool contains(const K &key) const noexcept {
+        const _lookup_t<K> &lookup = key;
+        return _find(lookup, _hash(lookup)) != kNpos;
+    }
+
+    template <class K = Key> size_type count(const K &key) const noexcept {
+        return contains(key) ? 1 : 0;
+    }
+
+    // The key is constructed only if there's no equal one yet
+    template <class K = Key>
+    std::pair<iterator, bool> insert(K &&key)
+        requires std::is_constructible_v<Key, K &&>
+    {
+        const _lookup_t<std::remove_cvref_t<K>> &lookup = key;
+        const std::size_t hash = _hash(lookup);
+        if (const size_type slot = _find(lookup, hash); slot != kNpos) {
+            return {iterator{this, slot}, false};
+        }
+        return {iterator{this, _insert_new(std::forward<K>(key), hash)}, true};
+    }
+
+    template <class... Args> std::pair<iterator, bool> emplace(Args &&...args) {
+        return insert(Key(std::forward<Args>(args)...));
+    }
+
+    template <class K = Key> size_type erase(const K &key) {
+        const _lookup_t<K> &lookup = key;
+        const size_type slot = _find(lookup, _hash(lookup));
+        if (slot == kNpos) {
+            return 0;
+        }
+        _erase_slot(slot);
+        return 1;
+    }
+
+    void erase(const_iterator pos) { _erase_slot(pos.slot_); }
+
+    void clear(void) noexcept {
+        if (capacity_ == 0) {
+            return;
+        }
+        if constexpr (!std::is_trivially_destructible_v<Key>) {
+            for (size_type slot = 0; slot < capacity_; ++slot) {
+                if (_is_full(ctrl_[slot])) {
+                    std::destroy_at(_key_at(slot));
+                }
+            }
+        }
+        std::memset(ctrl_, kEmpty, capacity_);
+        size_ = 0;
+        tombstones_ = 0;
+    }
+
+    // Makes room for `count` elements without rehashing
+    void reserve(size_type count) {
+        size_type capacity = kGroupSize;
+        while (_max_load(capacity) < count) {
+            capacity *= 2;
+        }
+        if (capacity > capacity_) {
+            _rehash(capacity);
+        }
+    }
+
+    const_iterator begin(void) const noexcept { return {this, _next_full(0)}; }
+    const_iterator end(void) const noexcept { return {this, capacity_}; }
+
+  private:
+    static constexpr size_type kNpos{~size_type{0}};
+
+    static bool _is_full(_Ctrl ctrl) noexcept { return ctrl >= 0; }
+
+    // Load factor 7/8
+    static size_type _max_load(size_type capacity) noexcept {
+        return capacity - capacity / 8;
+    }
+
+    // std::hash may be the identity, so the bits are mixed (the splitmix64
+    // finalizer): every bit of the key affects the low ones, which select
+    // the group and go to the control byte. A plain multiplication isn't
+    // enough, the low bits of a product depend on the low bits of the key
+    // only, and keys like `k << 24` would all share a group
+    template <class K> std::size_t _hash(const K &key) const noexcept {
+        auto value = static_cast<uint64_t>(hash_(key));
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return static_cast<std::size_t>(value ^ (value >> 31));
+    }
+    // Bits 7 and up select the group, the low 7 bits go to the control byte
+    static size_type _h1(std::size_t hash) noexcept { return hash >> 7; }
+    static _Ctrl _h2(std::size_t hash) noexcept {
+        return static_cast<_Ctrl>(hash & 0x7F);
+    }
+
+    // Bit `i` of the result is set if `ctrl[i] == value`
+    static uint32_t _match(const _Ctrl *group, _Ctrl value) noexcept {
+#if defined(__SSE2__)
+        const __m128i ctrl =
+            _mm_load_si128(reinterpret_cast<const __m128i *>(group));
+        return static_cast<uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(value))));
+#else
+        uint32_t mask{0};
+        for (size_type k = 0; k < kGroupSize; ++k) {
+            mask |= static_cast<uint32_t>(group[k] == value) << k;
+        }
+        return mask;
+#endif
+    }
+
+    // Empty or deleted: the sign bit is set
+    static uint32_t _match_free(const _Ctrl *group) noexcept {
+#if defined(__SSE2__)
+        return static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_load_si128(reinterpret_cast<const __m128i *>(group))));
+#else
+        uint32_t mask{0};
+        for (size_type k = 0; k < kGroupSize; ++k) {
+            mask |= static_cast<uint32_t>(group[k] < 0) << k;
+        }
+        return mask;
+#endif
+    }
+
+    Key *_key_at(size_type slot) const noexcept {
+        return std::launder(reinterpret_cast<Key *>(slots_) + slot);
+    }
+
+    // Groups are visited in the triangular order: 0, 1, 3, 6, ... (mod the
+    // group count) which covers all the groups of a power-of-two table
+    template <class Fn> bool _probe(std::size_t hash, Fn &&fn) const {
+        const size_type groups_mask = capacity_ / kGroupSize - 1;
+        size_type group = _h1(hash) & groups_mask;
+        for (size_type step = 1; step <= groups_mask + 1; ++step) {
+            if (fn(group * kGroupSize)) {
+                return true;
+            }
+            group = (group + step) & groups_mask;
+        }
+        return false;
+    }
+
+    template <class K>
+    size_type _find(const K &key, std::size_t hash) const noexcept {
+        if (capacity_ == 0) {
+            return kNpos;
+        }
+        size_type found{kNpos};
+        _probe(hash, [&](size_type first) {
+            const _Ctrl *group = ctrl_ + first;
+            for (uint32_t mask = _match(group, _h2(hash)); mask != 0;
+                 mask &= mask - 1) {
+                const size_type slot =
+                    first + static_cast<size_type>(std::countr_zero(mask));
+                if (eq_(*_key_at(slot), key)) {
+                    found = slot;
+                    return true;
+                }
+            }
+            // An empty slot ends the probe sequence
+            return _match(group, kEmpty) != 0;
+        });
+        return found;
+    }
+
+    // `key` is known to be absent
+    template <class K> size_type _insert_new(K &&key, std::size_t hash) {
+        if (size_ + tombstones_ + 1 > _max_load(capacity_)) {
+            // Many tombstones: rehashing in place is enough
+            _rehash(size_ + 1 > _max_load(capacity_) / 2 || capacity_ == 0
+                        ? std::max(capacity_ * 2, kGroupSize)
+                        : capacity_);
+        }
+        size_type slot{kNpos};
+        _probe(hash, [&](size_type first) {
+            const uint32_t mask = _match_free(ctrl_ + first);
+            if (mask == 0) {
+                return false;
+            }
+            slot = first + static_cast<size_type>(std::countr_zero(mask));
+            return true;
+        });
+        ::new (static_cast<void *>(_key_at(slot))) Key(std::forward<K>(key));
+        if (ctrl_[slot] == kDeleted) {
+            --tombstones_;
+        }
+        ctrl_[slot] = _h2(hash);
+        ++size_;
+        return slot;
+    }
+
+    void _erase_slot(size_type slot) {
+        std::destroy_at(_key_at(slot));
+        --size_;
+        const _Ctrl *group = ctrl_ + slot / kGroupSize * kGroupSize;
+        if (_match(group, kEmpty) != 0) {
+            ctrl_[slot] = kEmpty;
+        } else {
+            ctrl_[slot] = kDeleted;
+            ++tombstones_;
+        }
+    }
+
+    void _rehash(size_type capacity) {
+        flat_hash_set fresh;
+        fresh.hash_ = hash_;
+        fresh.eq_ = eq_;
+        fresh._allocate(capacity);
+        for (size_type slot = 0; slot < capacity_; ++slot) {
+            if (_is_full(ctrl_[slot])) {
+                Key *key = _key_at(slot);
+                fresh._insert_new(std::move(*key), fresh._hash(*key));
+                std::destroy_at(key);
+                ctrl_[slot] = kEmpty;
+            }
+        }
+        size_ = 0;
+        tombstones_ = 0;
+        swap(fresh);
+    }
+
+    void _allocate(size_type capacity) {
+        ctrl_ = static_cast<_Ctrl *>(
+            ::operator new(capacity, std::align_val_t{kGroupSize}));
+        std::memset(ctrl_, kEmpty, capacity);
+        slots_ = ::operator new(capacity * sizeof(Key),
+                                std::align_val_t{alignof(Key)});
+        capacity_ = capacity;
+    }
+
+    void _deallocate(void) noexcept {
+        if (capacity_ == 0) {
+            return;
+        }
+        ::operator delete(ctrl_, std::align_val_t{kGroupSize});
+        ::operator delete(slots_, std::align_val_t{alignof(Key)});
+        ctrl_ = nullptr;
+        slots_ = nullptr;
+        capacity_ = 0;
+    }
+
+    size_type _next_full(size_type slot) const noexcept {
+        while (slot < capacity_ && !_is_full(ctrl_[slot])) {
+            ++slot;
+        }
+        return slot;
+    }
+
+    _Ctrl *ctrl_{nullptr};
+    void *slots_{nullptr};
+    size_type capacity_{0}; // A power of two, a multiple of the group size
+    size_type size_{0};
+    size_type tombstones_{0};
+    [[no_unique_address]] Hash hash_{};
+    [[no_unique_address]] KeyEqual eq_{};
+};
+
+template <class Key, class Hash, class KeyEqual>
+class flat_hash_set<Key, Hash, KeyEqual>::_Iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Key;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Key *;
+    using reference = const Key &;
+
+    _Iterator(void) noexcept = default;
+    _Iterator(const flat_hash_set *owner, size_type slot) noexcept
+        : owner_(owner), slot_(slot) {}
+
+    reference operator*(void) const noexcept { return *owner_->_key_at(slot_); }
+    pointer operator->(void) const noexcept { return owner_->_key_at(slot_); }
+
+    _Iterator &operator++(void) noexcept {
+        slot_ = owner_->_next_full(slot_ + 1);
+        return *this;
+    }
+    _Iterator operator++(int) noexcept {
+        auto copy = *this;
+        ++*this;
+        return copy;
+    }
+
+    friend bool operator==(const _Iterator &a, const _Iterator &b) noexcept {
+        return a.slot_ == b.slot_;
+    }
+
+  private:
+    friend class flat_hash_set;
+
+    const flat_hash_set *owner_{nullptr};
+    size_type slot_{0};
+};
+
+// A set of std::string probed with string_view, literals, etc.
+using flat_string_set =
+    flat_hash_set<std::string, string_hash, std::equal_to<>>;
+
+} // namespace cpp_core_sandbox
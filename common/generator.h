@@ -0,0 +1,153 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace cpp_core_sandbox {
+
+// A lazy sequence produced by a coroutine, the essentials of C++23's
+// `std::generator` (which our standard library doesn't have yet):
+//
+//   generator<int> iota(int from) {
+//       for (;;) {
+//           co_yield from++;
+//       }
+//   }
+//
+//   for (int value : iota(1)) {
+//       if (value > 10) break; // The coroutine is destroyed with the generator
+//   }
+//
+// The body runs only while the caller pulls the next value: up to the next
+// `co_yield`, which hands out a reference to the yielded object without
+// copying it. The reference is valid till the next increment, so the
+// caller may move from it. An exception escaping the body is rethrown from
+// `begin()` or `++`.
+//
+// A single pass input range. Move-only: the coroutine frame, with all its
+// locals, belongs to the generator and goes away with it.
+template <class T> class generator {
+  public:
+    using value_type = std::remove_cvref_t<T>;
+    using reference = value_type &;
+
+    struct promise_type {
+        value_type *current{nullptr};
+        std::exception_ptr exception;
+
+        generator get_return_object(void) noexcept {
+            return generator{
+                std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        // Nothing runs before the first pull
+        std::suspend_always initial_suspend(void) const noexcept { return {}; }
+        std::suspend_always final_suspend(void) const noexcept { return {}; }
+
+        // A temporary lives till the end of the full expression, i.e. past
+        // the suspension
+        std::suspend_always yield_value(value_type &value) noexcept {
+            current = std::addressof(value);
+            return {};
+        }
+        std::suspend_always yield_value(value_type &&value) noexcept {
+            current = std::addressof(value);
+            return {};
+        }
+
+        void return_void(void) const noexcept {}
+
+        void unhandled_exception(void) noexcept {
+            exception = std::current_exception();
+        }
+
+        // No co_await inside, the values come only from co_yield
+        template <class U> std::suspend_never await_transform(U &&) = delete;
+    };
+
+    class iterator {
+      public:
+        using iterator_concept = std::input_iterator_tag;
+        using value_type = generator::value_type;
+        using difference_type = std::ptrdiff_t;
+
+        iterator(void) noexcept = default;
+
+        reference operator*(void) const noexcept {
+            return *handle_.promise().current;
+        }
+        value_type *operator->(void) const noexcept {
+            return handle_.promise().current;
+        }
+
+        iterator &operator++(void) {
+            _resume(handle_);
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+
+        friend bool operator==(const iterator &it,
+                               std::default_sentinel_t) noexcept {
+            return it.handle_ == nullptr || it.handle_.done();
+        }
+
+      private:
+        friend class generator;
+
+        explicit iterator(std::coroutine_handle<promise_type> handle) noexcept
+            : handle_{handle} {}
+
+        std::coroutine_handle<promise_type> handle_;
+    };
+
+    generator(generator &&rh) noexcept
+        : handle_{std::exchange(rh.handle_, nullptr)} {}
+
+    generator &operator=(generator &&rh) noexcept {
+        if (this != &rh) {
+            _destroy();
+            handle_ = std::exchange(rh.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    ~generator(void) { _destroy(); }
+
+    // Runs the body up to the first value; call once
+    iterator begin(void) {
+        if (handle_ != nullptr) {
+            _resume(handle_);
+        }
+        return iterator{handle_};
+    }
+
+    std::default_sentinel_t end(void) const noexcept { return {}; }
+
+  private:
+    explicit generator(std::coroutine_handle<promise_type> handle) noexcept
+        : handle_{handle} {}
+
+    static void _resume(std::coroutine_handle<promise_type> handle) {
+        handle.resume();
+        if (handle.promise().exception) {
+            std::rethrow_exception(
+                std::exchange(handle.promise().exception, nullptr));
+        }
+    }
+
+    void _destroy(void) noexcept {
+        if (handle_ != nullptr) {
+            handle_.destroy();
+            handle_ = nullptr;
+        }
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+} // namespace cpp_core_sandbox
@@ -0,0 +1,299 @@
+#include "hdr-histogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace cpp_core_sandbox {
+
+namespace {
+
+std::atomic<uint64_t> next_registry_id{1};
+
+void store_min(std::atomic<uint64_t> &target, uint64_t value) noexcept {
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (value < current &&
+           !target.compare_exchange_weak(current, value,
+                                         std::memory_order_relaxed)) {
+    }
+}
+
+void store_max(std::atomic<uint64_t> &target, uint64_t value) noexcept {
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (value > current &&
+           !target.compare_exchange_weak(current, value,
+                                         std::memory_order_relaxed)) {
+    }
+}
+
+// "812 ns", "3.41 us", "12.0 ms", "1.50 s"
+std::string format_ns(double ns) {
+    char text[32];
+    if (ns < 1e3) {
+        std::snprintf(text, sizeof(text), "%.0f ns", ns);
+    } else if (ns < 1e6) {
+        std::snprintf(text, sizeof(text), "%.2f us", ns / 1e3);
+    } else if (ns < 1e9) {
+        std::snprintf(text, sizeof(text), "%.2f ms", ns / 1e6);
+    } else {
+        std::snprintf(text, sizeof(text), "%.2f s", ns / 1e9);
+    }
+    return text;
+}
+
+} // namespace
+
+HdrHistogram::HdrHistogram(unsigned precision_bits)
+    : precision_bits_{std::clamp(precision_bits, 1u, 16u)},
+      size_{(65 - precision_bits_) * (std::size_t{1} << precision_bits_)} {
+    counts_ = std::make_unique<std::atomic<uint64_t>[]>(size_);
+}
+
+HdrHistogram::HdrHistogram(const HdrHistogram &rh)
+    : HdrHistogram(rh.precision_bits_) {
+    Merge(rh);
+}
+
+HdrHistogram &HdrHistogram::operator=(const HdrHistogram &rh) {
+    if (this != &rh) {
+        if (precision_bits_ != rh.precision_bits_) {
+            precision_bits_ = rh.precision_bits_;
+            size_ = rh.size_;
+            counts_ = std::make_unique<std::atomic<uint64_t>[]>(size_);
+        }
+        Reset();
+        Merge(rh);
+    }
+    return *this;
+}
+
+std::size_t HdrHistogram::_index(uint64_t value) const noexcept {
+    const uint64_t linear = uint64_t{1} << precision_bits_;
+    if (value < linear) {
+        return static_cast<std::size_t>(value);
+    }
+    // value is in [2^(p + e - 1), 2^(p + e)): the range `e`, and its top p
+    // bits after the leading one are the bucket inside the range
+    const unsigned e =
+        static_cast<unsigned>(std::bit_width(value)) - precision_bits_;
+    const uint64_t offset = (value >> (e - 1)) - linear;
+    return static_cast<std::size_t>((uint64_t{e} << precision_bits_) + offset);
+}
+
+uint64_t HdrHistogram::_lowest(std::size_t index) const noexcept {
+    const uint64_t linear = uint64_t{1} << precision_bits_;
+    if (index < linear) {
+        return index;
+    }
+    const auto e = static_cast<unsigned>(index >> precision_bits_);
+    const uint64_t offset = index & (linear - 1);
+    return (linear + offset) << (e - 1);
+}
+
+uint64_t HdrHistogram::_highest(std::size_t index) const noexcept {
+    const uint64_t linear = uint64_t{1} << precision_bits_;
+    if (index < linear) {
+        return index;
+    }
+    const auto e = static_cast<unsigned>(index >> precision_bits_);
+    return _lowest(index) + ((uint64_t{1} << (e - 1)) - 1);
+}
+
+void HdrHistogram::Record(uint64_t value, uint64_t count) noexcept {
+    if (count == 0) {
+        return;
+    }
+    counts_[_index(value)].fetch_add(count, std::memory_order_relaxed);
+    total_.fetch_add(count, std::memory_order_relaxed);
+    sum_.fetch_add(value * count, std::memory_order_relaxed);
+    store_min(min_, value);
+    store_max(max_, value);
+}
+
+void HdrHistogram::Merge(const HdrHistogram &other) {
+    if (other.precision_bits_ != precision_bits_) {
+        throw std::invalid_argument{
+            "HdrHistogram::Merge: the precisions differ"};
+    }
+    for (std::size_t k = 0; k < size_; ++k) {
+        if (const auto count = other.counts_[k].load(std::memory_order_relaxed)) {
+            counts_[k].fetch_add(count, std::memory_order_relaxed);
+        }
+    }
+    total_.fetch_add(other.total_.load(std::memory_order_relaxed),
+                     std::memory_order_relaxed);
+    sum_.fetch_add(other.sum_.load(std::memory_order_relaxed),
+                   std::memory_order_relaxed);
+    store_min(min_, other.min_.load(std::memory_order_relaxed));
+    store_max(max_, other.max_.load(std::memory_order_relaxed));
+}
+
+void HdrHistogram::Reset(void) noexcept {
+    for (std::size_t k = 0; k < size_; ++k) {
+        counts_[k].store(0, std::memory_order_relaxed);
+    }
+    total_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    min_.store(UINT64_MAX, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t HdrHistogram::TotalCount(void) const noexcept {
+    return total_.load(std::memory_order_relaxed);
+}
+
+uint64_t HdrHistogram::Min(void) const noexcept {
+    return TotalCount() == 0 ? 0 : min_.load(std::memory_order_relaxed);
+}
+
+uint64_t HdrHistogram::Max(void) const noexcept {
+    return max_.load(std::memory_order_relaxed);
+}
+
+double HdrHistogram::Mean(void) const noexcept {
+    const auto total = TotalCount();
+    return total == 0 ? 0.0
+                      : static_cast<double>(sum_.load(std::memory_order_relaxed)) /
+                            static_cast<double>(total);
+}
+
+uint64_t HdrHistogram::ValueAtPercentile(double percentile) const noexcept {
+    const uint64_t total = TotalCount();
+    if (total == 0) {
+        return 0;
+    }
+    percentile = std::clamp(percentile, 0.0, 100.0);
+    // The rank of the value, at least the first one
+    const auto rank = std::max<uint64_t>(
+        1, static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(total) +
+                                 0.5));
+    uint64_t seen{0};
+    for (std::size_t k = 0; k < size_; ++k) {
+        seen += counts_[k].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(_highest(k), Max());
+        }
+    }
+    // Records which came in while counting
+    return Max();
+}
+
+void HdrHistogram::PrintSummary(std::ostream &out,
+                                std::string_view label) const {
+    out << label << ": " << TotalCount() << " samples";
+    if (TotalCount() == 0) {
+        out << std::endl;
+        return;
+    }
+    out << ", min " << format_ns(static_cast<double>(Min()));
+    constexpr std::pair<const char *, double> percentiles[]{
+        {"p50", 50.0}, {"p90", 90.0}, {"p99", 99.0}, {"p99.9", 99.9}};
+    for (const auto &[name, percentile] : percentiles) {
+        out << ", " << name << ' '
+            << format_ns(static_cast<double>(ValueAtPercentile(percentile)));
+    }
+    out << ", max " << format_ns(static_cast<double>(Max())) << ", mean "
+        << format_ns(Mean()) << std::endl;
+}
+
+void HdrHistogram::PrintDistribution(std::ostream &out) const {
+    char line[96];
+    std::snprintf(line, sizeof(line), "%14s %12s %12s\n", "value ns",
+                  "percentile", "count");
+    out << line;
+    const uint64_t total = TotalCount();
+    if (total == 0) {
+        return;
+    }
+    // Four lines per halving of the distance to 100%
+    for (double percentile = 0.0;;) {
+        const double below = static_cast<double>(total) * percentile / 100.0;
+        std::snprintf(
+            line, sizeof(line), "%14llu %12.6f %12llu\n",
+            static_cast<unsigned long long>(ValueAtPercentile(percentile)),
+            percentile, static_cast<unsigned long long>(below + 0.5));
+        out << line;
+        if (below >= static_cast<double>(total) - 1.0) {
+            break;
+        }
+        const double halvings =
+            std::floor(std::log2(100.0 / (100.0 - percentile))) + 1.0;
+        percentile += 100.0 / (4.0 * std::exp2(halvings));
+    }
+    std::snprintf(line, sizeof(line), "%14llu %12.6f %12llu\n",
+                  static_cast<unsigned long long>(Max()), 100.0,
+                  static_cast<unsigned long long>(total));
+    out << line;
+}
+
+void HdrHistogram::PrintJson(std::ostream &out) const {
+    out << "{\"count\": " << TotalCount() << ", \"min\": " << Min()
+        << ", \"max\": " << Max() << ", \"mean\": " << Mean()
+        << ", \"percentiles\": {";
+    constexpr std::pair<const char *, double> percentiles[]{
+        {"50", 50.0},  {"90", 90.0},     {"99", 99.0},
+        {"99.9", 99.9}, {"99.99", 99.99}};
+    const char *separator = "";
+    for (const auto &[name, percentile] : percentiles) {
+        out << separator << '"' << name << "\": " << ValueAtPercentile(percentile);
+        separator = ", ";
+    }
+    out << "}, \"buckets\": [";
+    separator = "";
+    for (std::size_t k = 0; k < size_; ++k) {
+        if (const auto count = counts_[k].load(std::memory_order_relaxed)) {
+            out << separator << '[' << _highest(k) << ", " << count << ']';
+            separator = ", ";
+        }
+    }
+    out << "]}";
+}
+
+PerThreadHistograms::PerThreadHistograms(unsigned precision_bits)
+    : id_{next_registry_id.fetch_add(1, std::memory_order_relaxed)},
+      precision_bits_{precision_bits} {}
+
+HdrHistogram &PerThreadHistograms::Local(void) {
+    // The last instance the thread has used: a single entry, so a thread
+    // going through many short-lived instances keeps nothing of theirs. A
+    // destroyed instance's id is never reused, so a stale entry can't match
+    struct Cached {
+        uint64_t id{0};
+        HdrHistogram *histogram{nullptr};
+    };
+    thread_local Cached cached;
+    if (cached.id == id_) {
+        return *cached.histogram;
+    }
+
+    // Back to an instance used before, or the first time
+    const auto thread = std::this_thread::get_id();
+    std::lock_guard lock{mutex_};
+    auto it = std::find_if(
+        histograms_.begin(), histograms_.end(),
+        [thread](const auto &entry) { return entry.first == thread; });
+    if (it == histograms_.end()) {
+        histograms_.emplace_back(
+            thread, std::make_unique<HdrHistogram>(precision_bits_));
+        it = std::prev(histograms_.end());
+    }
+    cached = Cached{id_, it->second.get()};
+    return *it->second;
+}
+
+HdrHistogram PerThreadHistograms::Merged(void) const {
+    HdrHistogram result{precision_bits_};
+    std::lock_guard lock{mutex_};
+    for (const auto &[thread, histogram] : histograms_) {
+        result.Merge(*histogram);
+    }
+    return result;
+}
+
+} // namespace cpp_core_sandbox
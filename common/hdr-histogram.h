@@ -0,0 +1,156 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace cpp_core_sandbox {
+
+// A latency histogram in the style of HdrHistogram.
+//
+// Values up to 2^precision_bits are counted exactly. Above that every power
+// of two range is split into 2^precision_bits linear buckets, so a value is
+// known within 1 / 2^precision_bits of itself: 0.8% with the default 7 bits,
+// from nanoseconds to centuries, in (65 - 7) * 128 counters.
+//
+// Recording is a few relaxed atomic increments, no locks: any thread may read
+// or merge a histogram while others record into it. Recording from many
+// threads into one histogram is correct but makes its counters a contended
+// cache line, `PerThreadHistograms` gives every thread its own instead.
+//
+//   HdrHistogram latencies;
+//   for (...) {
+//       ScopedLatencyTimer timer{latencies};
+//       ...
+//   }
+//   latencies.PrintSummary(std::cout, "solve");
+//   // solve: 1000 samples, min 1.2 us, p50 3.4 us, p90 ..., max 9.1 ms
+class HdrHistogram final {
+  public:
+    static constexpr unsigned kDefaultPrecisionBits{7};
+
+    // `precision_bits` is clamped to 1..16
+    explicit HdrHistogram(unsigned precision_bits = kDefaultPrecisionBits);
+
+    // A snapshot of the counters
+    HdrHistogram(const HdrHistogram &rh);
+    HdrHistogram &operator=(const HdrHistogram &rh);
+
+    void Record(uint64_t value, uint64_t count = 1) noexcept;
+
+    // Adds the counts of `other`. Throws std::invalid_argument if the
+    // precisions differ
+    void Merge(const HdrHistogram &other);
+
+    void Reset(void) noexcept;
+
+    uint64_t TotalCount(void) const noexcept;
+    uint64_t Min(void) const noexcept; // 0 if empty
+    uint64_t Max(void) const noexcept;
+    double Mean(void) const noexcept;
+
+    // The largest value equivalent to the one at `percentile` (0..100),
+    // i.e. the error is on the safe side. 0 if empty
+    uint64_t ValueAtPercentile(double percentile) const noexcept;
+
+    unsigned PrecisionBits(void) const noexcept { return precision_bits_; }
+
+    // One line: count, min, p50, p90, p99, p99.9, max. The values are
+    // nanoseconds, printed in the units which suit them
+    void PrintSummary(std::ostream &out, std::string_view label) const;
+
+    // The percentile distribution, four lines per halving of the distance to
+    // 100% like HdrHistogram prints it: 0%, 12.5%, 25%, 37.5%, 50%, 56.25%...
+    void PrintDistribution(std::ostream &out) const;
+
+    // {"count": .., "min": .., "max": .., "mean": .., "percentiles":
+    //  {"50": .., ...}, "buckets": [[highest value, count], ...]}
+    // with the non-empty buckets only
+    void PrintJson(std::ostream &out) const;
+
+  private:
+    std::size_t _index(uint64_t value) const noexcept;
+    uint64_t _lowest(std::size_t index) const noexcept;
+    uint64_t _highest(std::size_t index) const noexcept;
+
+    unsigned precision_bits_;
+    std::unique_ptr<std::atomic<uint64_t>[]> counts_;
+    std::size_t size_;
+    std::atomic<uint64_t> total_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> min_{UINT64_MAX};
+    std::atomic<uint64_t> max_{0};
+};
+
+// Records the nanoseconds of its lifetime, or till `Stop()`
+class ScopedLatencyTimer final {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    explicit ScopedLatencyTimer(HdrHistogram &histogram) noexcept
+        : histogram_{&histogram} {}
+    ~ScopedLatencyTimer(void) { Stop(); }
+
+    ScopedLatencyTimer(const ScopedLatencyTimer &) = delete;
+    ScopedLatencyTimer &operator=(const ScopedLatencyTimer &) = delete;
+
+    // Records once, returns the nanoseconds recorded (0 the second time)
+    uint64_t Stop(void) noexcept {
+        if (histogram_ == nullptr) {
+            return 0;
+        }
+        const auto ns = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                clock::now() - start_)
+                .count());
+        histogram_->Record(ns);
+        histogram_ = nullptr;
+        return ns;
+    }
+
+  private:
+    HdrHistogram *histogram_;
+    clock::time_point start_{clock::now()};
+};
+
+// A histogram per recording thread, merged on demand.
+//
+//   PerThreadHistograms latencies;
+//   // on any thread
+//   latencies.Local().Record(ns);
+//   // when done
+//   latencies.Merged().PrintSummary(std::cout, "handoff");
+//
+// `Local()` locks only when the thread switches between instances. The
+// histograms live as long as the instance, including those of the threads
+// which have exited.
+class PerThreadHistograms final {
+  public:
+    explicit PerThreadHistograms(
+        unsigned precision_bits = HdrHistogram::kDefaultPrecisionBits);
+
+    PerThreadHistograms(const PerThreadHistograms &) = delete;
+    PerThreadHistograms &operator=(const PerThreadHistograms &) = delete;
+
+    HdrHistogram &Local(void);
+
+    HdrHistogram Merged(void) const;
+
+  private:
+    const uint64_t id_; // Unique, unlike the address of an instance
+    const unsigned precision_bits_;
+    mutable std::mutex mutex_;
+    // One per thread
+    std::vector<std::pair<std::thread::id, std::unique_ptr<HdrHistogram>>>
+        histograms_;
+};
+
+} // namespace cpp_core_sandbox
@@ -0,0 +1,192 @@
+#include "huge-page-allocator.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace cpp_core_sandbox {
+
+namespace {
+
+constexpr std::size_t huge_page_size{std::size_t{2} << 20};
+
+std::atomic<uint64_t> mapped_bytes{0};
+std::atomic<uint64_t> hugetlb_bytes{0};
+std::atomic<uint64_t> hugetlb_fallbacks{0};
+
+#if defined(__linux__)
+
+std::size_t round_up(std::size_t bytes, std::size_t page) noexcept {
+    return (bytes + page - 1) / page * page;
+}
+
+// The length of every mapping: munmap of MAP_HUGETLB memory fails unless it's
+// a multiple of the huge page size, which may be 1 GB
+std::mutex mappings_mutex;
+std::unordered_map<void *, std::size_t> mappings;
+
+// Unmaps `ptr` if it can't be recorded
+void add_mapping(void *ptr, std::size_t length) {
+    try {
+        const std::lock_guard lock{mappings_mutex};
+        mappings.emplace(ptr, length);
+    } catch (...) {
+        munmap(ptr, length);
+        throw;
+    }
+}
+
+// The size MAP_HUGETLB maps with (Hugepagesize of /proc/meminfo)
+std::size_t hugetlb_page_size(void) noexcept {
+    static const std::size_t size = [] {
+        std::size_t kb{0};
+        if (FILE *meminfo = std::fopen("/proc/meminfo", "r")) {
+            char line[256];
+            while (std::fgets(line, sizeof(line), meminfo)) {
+                if (std::strncmp(line, "Hugepagesize:", 13) == 0) {
+                    kb = std::strtoull(line + 13, nullptr, 10);
+                    break;
+                }
+            }
+            std::fclose(meminfo);
+        }
+        return kb != 0 ? kb << 10 : huge_page_size;
+    }();
+    return size;
+}
+
+#if !defined(MADV_POPULATE_WRITE)
+#define MADV_POPULATE_WRITE 23 // Linux 5.14
+#endif
+
+// Regular pages with a 2 MB aligned start: THP can only back aligned ranges
+void *map_aligned(std::size_t length) {
+    const std::size_t padded = length + huge_page_size;
+    void *raw = mmap(nullptr, padded, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        return nullptr;
+    }
+    const auto start = reinterpret_cast<uintptr_t>(raw);
+    const auto aligned = (start + huge_page_size - 1) & ~(huge_page_size - 1);
+    const std::size_t head = aligned - start;
+    const std::size_t tail = padded - head - length;
+    if (head != 0) {
+        munmap(raw, head);
+    }
+    if (tail != 0) {
+        munmap(reinterpret_cast<void *>(aligned + length), tail);
+    }
+    return reinterpret_cast<void *>(aligned);
+}
+
+void prefault(void *ptr, std::size_t length) noexcept {
+    if (madvise(ptr, length, MADV_POPULATE_WRITE) == 0) {
+        return;
+    }
+    // An older kernel: touch a byte of every regular page
+    const auto page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    auto *bytes = static_cast<volatile char *>(ptr);
+    for (std::size_t offset = 0; offset < length; offset += page) {
+        bytes[offset] = 0;
+    }
+}
+
+#endif
+
+} // namespace
+
+void *huge_page_map(std::size_t bytes, const huge_page_options &options) {
+#if defined(__linux__)
+    // Rounded up and padded for the alignment, it wouldn't fit
+    if (bytes > std::numeric_limits<std::size_t>::max() / 2) {
+        throw std::bad_alloc{};
+    }
+    if (options.use_hugetlb) {
+        const std::size_t length = round_up(bytes, hugetlb_page_size());
+        void *ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+                             (options.populate ? MAP_POPULATE : 0),
+                         -1, 0);
+        if (ptr != MAP_FAILED) {
+            add_mapping(ptr, length);
+            mapped_bytes.fetch_add(length, std::memory_order_relaxed);
+            hugetlb_bytes.fetch_add(length, std::memory_order_relaxed);
+            return ptr;
+        }
+        hugetlb_fallbacks.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const std::size_t length = round_up(bytes, huge_page_size);
+    void *ptr = map_aligned(length);
+    if (ptr == nullptr) {
+        throw std::bad_alloc{};
+    }
+    add_mapping(ptr, length);
+    // Must precede the first touch, so MAP_POPULATE isn't used here
+    madvise(ptr, length,
+            options.transparent_huge_pages ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+    if (options.populate) {
+        prefault(ptr, length);
+    }
+    mapped_bytes.fetch_add(length, std::memory_order_relaxed);
+    return ptr;
+#else
+    (void)options;
+    void *ptr = ::operator new(bytes, std::align_val_t{huge_page_size});
+    mapped_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    return ptr;
+#endif
+}
+
+void huge_page_unmap(void *ptr) noexcept {
+#if defined(__linux__)
+    std::size_t length{0};
+    {
+        const std::lock_guard lock{mappings_mutex};
+        const auto mapping = mappings.find(ptr);
+        if (mapping == mappings.end()) {
+            return;
+        }
+        length = mapping->second;
+        mappings.erase(mapping);
+    }
+    munmap(ptr, length);
+#else
+    ::operator delete(ptr, std::align_val_t{huge_page_size});
+#endif
+}
+
+huge_page_stats get_huge_page_stats(void) noexcept {
+    return {mapped_bytes.load(std::memory_order_relaxed),
+            hugetlb_bytes.load(std::memory_order_relaxed),
+            hugetlb_fallbacks.load(std::memory_order_relaxed)};
+}
+
+uint64_t anon_huge_pages_kb(void) {
+    FILE *smaps = std::fopen("/proc/self/smaps_rollup", "r");
+    if (smaps == nullptr) {
+        return 0;
+    }
+    char line[256];
+    uint64_t result{0};
+    while (std::fgets(line, sizeof(line), smaps)) {
+        if (std::strncmp(line, "AnonHugePages:", 14) == 0) {
+            result = std::strtoull(line + 14, nullptr, 10);
+            break;
+        }
+    }
+    std::fclose(smaps);
+    return result;
+}
+
+} // namespace cpp_core_sandbox
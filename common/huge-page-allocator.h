@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+
+namespace cpp_core_sandbox {
+
+struct huge_page_options {
+    // Explicit huge pages (MAP_HUGETLB). They must be reserved beforehand
+    // (vm.nr_hugepages); if there are not enough of them, the allocation
+    // falls back to transparent huge pages
+    bool use_hugetlb{false};
+
+    // Fault the pages in right away instead of on the first touch
+    bool populate{false};
+
+    // Mark the mapping MADV_HUGEPAGE. Off, it's mapped with regular pages
+    // (MADV_NOHUGEPAGE): to compare against huge pages with the same `populate`
+    bool transparent_huge_pages{true};
+
+    // Smaller allocations are served by `operator new`
+    std::size_t threshold{std::size_t{2} << 20};
+
+    friend bool operator==(const huge_page_options &,
+                           const huge_page_options &) = default;
+};
+
+// What the huge page allocations have been given so far
+struct huge_page_stats {
+    uint64_t mapped_bytes;  // All the mappings
+    uint64_t hugetlb_bytes; // Of them backed by MAP_HUGETLB
+    uint64_t hugetlb_fallbacks;
+};
+
+// mmap'ed memory aligned to 2 MB, so the kernel may back it with huge pages.
+// Throws std::bad_alloc. On systems other than Linux it's `operator new`
+// aligned to 2 MB
+void *huge_page_map(std::size_t bytes, const huge_page_options &options);
+// `ptr` must come from huge_page_map, which records the length it has mapped
+void huge_page_unmap(void *ptr) noexcept;
+
+huge_page_stats get_huge_page_stats(void) noexcept;
+
+// The transparent huge pages the process has (AnonHugePages of
+// /proc/self/smaps_rollup), 0 if unknown
+uint64_t anon_huge_pages_kb(void);
+
+// An STL allocator for large containers.
+//
+// Allocations of at least `threshold` bytes are mapped with mmap, aligned to
+// 2 MB and marked MADV_HUGEPAGE, or taken from explicit huge pages when
+// configured. A huge page covers 512 regular ones, so a linear scan over
+// gigabytes needs 512 times fewer TLB entries.
+//
+// The options are part of the allocator's state, pass an instance to the
+// container to change them:
+//   std::vector<int, huge_page_allocator<int>> v{
+//       huge_page_allocator<int>{{.use_hugetlb = true}}};
+template <class T> class huge_page_allocator {
+  public:
+    using value_type = T;
+
+    huge_page_allocator(void) noexcept = default;
+    explicit huge_page_allocator(const huge_page_options &options) noexcept
+        : options_(options) {}
+    template <class U>
+    huge_page_allocator(const huge_page_allocator<U> &rh) noexcept
+        : options_(rh.options()) {}
+
+    T *allocate(std::size_t n) {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length{};
+        }
+        const std::size_t bytes = n * sizeof(T);
+        if (bytes < options_.threshold) {
+            return static_cast<T *>(
+                ::operator new(bytes, std::align_val_t{alignof(T)}));
+        }
+        return static_cast<T *>(huge_page_map(bytes, options_));
+    }
+
+    void deallocate(T *ptr, std::size_t n) noexcept {
+        const std::size_t bytes = n * sizeof(T);
+        if (bytes < options_.threshold) {
+            ::operator delete(ptr, std::align_val_t{alignof(T)});
+            return;
+        }
+        huge_page_unmap(ptr);
+    }
+
+    const huge_page_options &options(void) const noexcept { return options_; }
+
+    template <class U>
+    friend bool operator==(const huge_page_allocator &a,
+                           const huge_page_allocator<U> &b) noexcept {
+        return a.options() == b.options();
+    }
+
+  private:
+    huge_page_options options_{};
+};
+
+} // namespace cpp_core_sandbox
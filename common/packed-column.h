@@ -0,0 +1,533 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace cpp_core_sandbox {
+
+// How a packed_column stores its values. The code of a value is its offset
+// from the column's minimum (frame of reference), in as many bits as the
+// range of the values needs
+enum class packed_encoding {
+    automatic, // The narrowest one for the range
+    bits1,     // 64 codes per 64-bit word
+    bits2,
+    bits4,
+    bytes1,
+    bytes2,
+    bytes4,
+};
+
+namespace detail {
+
+#if defined(__SSE2__)
+
+// The sum of the four 32-bit lanes
+inline std::size_t sum_epi32(__m128i sums) noexcept {
+    sums = _mm_add_epi32(sums, _mm_srli_si128(sums, 8));
+    sums = _mm_add_epi32(sums, _mm_srli_si128(sums, 4));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(sums));
+}
+
+// A matching lane of `_mm_cmpeq_*` is all ones, i.e. -1: subtracting the
+// comparisons counts the matches per lane. `Step` is how many of them the
+// lane counters take before they have to be summed up, the rest is scalar
+template <class Code, std::size_t Step, class Count>
+std::size_t count_lanes(const Code *codes, std::size_t size, Code code,
+                        Count count_block) noexcept {
+    constexpr std::size_t per_vector = 16 / sizeof(Code);
+    std::size_t count{0};
+    std::size_t k{0};
+    while (size - k >= per_vector) {
+        const std::size_t vectors = std::min((size - k) / per_vector, Step);
+        count += count_block(codes + k, vectors);
+        k += vectors * per_vector;
+    }
+    for (; k < size; ++k) {
+        count += codes[k] == code;
+    }
+    return count;
+}
+
+#endif
+
+// The number of `code`s in the packed arrays, SSE2 where available
+inline std::size_t count_equal_u8(const uint8_t *codes, std::size_t size,
+                                  uint8_t code) noexcept {
+#if defined(__SSE2__)
+    const __m128i needle = _mm_set1_epi8(static_cast<char>(code));
+    return count_lanes<uint8_t, 255>(
+        codes, size, code, [needle](const uint8_t *data, std::size_t vectors) {
+            __m128i counters = _mm_setzero_si128();
+            for (std::size_t v = 0; v < vectors; ++v) {
+                const __m128i values = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i *>(data + v * 16));
+                counters = _mm_sub_epi8(counters,
+                                        _mm_cmpeq_epi8(values, needle));
+            }
+            // Bytes summed into the two 64-bit halves
+            const __m128i sums = _mm_sad_epu8(counters, _mm_setzero_si128());
+            return static_cast<std::size_t>(
+                static_cast<uint32_t>(_mm_cvtsi128_si32(sums)) +
+                static_cast<uint32_t>(
+                    _mm_cvtsi128_si32(_mm_srli_si128(sums, 8))));
+        });
+#else
+    std::size_t count{0};
+    for (std::size_t k = 0; k < size; ++k) {
+        count += codes[k] == code;
+    }
+    return count;
+#endif
+}
+
+inline std::size_t count_equal_u16(const uint16_t *codes, std::size_t size,
+                                   uint16_t code) noexcept {
+#if defined(__SSE2__)
+    const __m128i needle = _mm_set1_epi16(static_cast<short>(code));
+    // 32767, as `_mm_madd_epi16` takes the counters as signed
+    return count_lanes<uint16_t, 32767>(
+        codes, size, code,
+        [needle](const uint16_t *data, std::size_t vectors) {
+            __m128i counters = _mm_setzero_si128();
+            for (std::size_t v = 0; v < vectors; ++v) {
+                const __m128i values = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i *>(data + v * 8));
+                counters = _mm_sub_epi16(counters,
+                                         _mm_cmpeq_epi16(values, needle));
+            }
+            return sum_epi32(_mm_madd_epi16(counters, _mm_set1_epi16(1)));
+        });
+#else
+    std::size_t count{0};
+    for (std::size_t k = 0; k < size; ++k) {
+        count += codes[k] == code;
+    }
+    return count;
+#endif
+}
+
+inline std::size_t count_equal_u32(const uint32_t *codes, std::size_t size,
+                                   uint32_t code) noexcept {
+#if defined(__SSE2__)
+    const __m128i needle = _mm_set1_epi32(static_cast<int>(code));
+    return count_lanes<uint32_t, std::size_t{1} << 29>(
+        codes, size, code,
+        [needle](const uint32_t *data, std::size_t vectors) {
+            __m128i counters = _mm_setzero_si128();
+            for (std::size_t v = 0; v < vectors; ++v) {
+                const __m128i values = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i *>(data + v * 4));
+                counters = _mm_sub_epi32(counters,
+                                         _mm_cmpeq_epi32(values, needle));
+            }
+            return sum_epi32(counters);
+        });
+#else
+    std::size_t count{0};
+    for (std::size_t k = 0; k < size; ++k) {
+        count += codes[k] == code;
+    }
+    return count;
+#endif
+}
+
+#if defined(__SSE2__)
+
+// The lanes equal to `pattern`'s in the first `words` (an even number) words
+template <unsigned Bits>
+std::size_t count_equal_bits_sse2(const uint64_t *words, std::size_t size,
+                                  uint64_t pattern) noexcept {
+    // Every byte holds 8 / Bits lanes: each of them is masked out in turn
+    // and compared with zero, after the XOR with the code in every lane
+    constexpr unsigned lanes_per_byte = 8 / Bits;
+    __m128i lane_masks[lanes_per_byte];
+    for (unsigned j = 0; j < lanes_per_byte; ++j) {
+        lane_masks[j] =
+            _mm_set1_epi8(static_cast<char>(((1u << Bits) - 1) << (j * Bits)));
+    }
+    const __m128i codes = _mm_set1_epi64x(static_cast<long long>(pattern));
+    const __m128i zero = _mm_setzero_si128();
+
+    std::size_t count{0};
+    for (std::size_t w = 0; w < size;) {
+        // Before the byte counters overflow
+        const std::size_t vectors =
+            std::min<std::size_t>((size - w) / 2, 255 / lanes_per_byte);
+        __m128i counters = zero;
+        for (std::size_t v = 0; v < vectors; ++v, w += 2) {
+            const __m128i x = _mm_xor_si128(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(words + w)),
+                codes);
+            for (unsigned j = 0; j < lanes_per_byte; ++j) {
+                counters = _mm_sub_epi8(
+                    counters,
+                    _mm_cmpeq_epi8(_mm_and_si128(x, lane_masks[j]), zero));
+            }
+        }
+        const __m128i sums = _mm_sad_epu8(counters, zero);
+        count += static_cast<uint32_t>(_mm_cvtsi128_si32(sums)) +
+                 static_cast<uint32_t>(
+                     _mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+    }
+    return count;
+}
+
+#endif
+
+// `size` codes of `bits` (1, 2 or 4) bits each, from the low bits of every
+// word up
+inline std::size_t count_equal_bits(const uint64_t *words, std::size_t size,
+                                    unsigned bits, uint64_t code) noexcept {
+    const unsigned lanes = 64 / bits;
+    const uint64_t low_bits = ~uint64_t{0} / ((uint64_t{1} << bits) - 1);
+    const uint64_t pattern = code * low_bits;
+    const std::size_t full_words = size / lanes;
+
+    std::size_t count{0};
+    std::size_t w{0};
+#if defined(__SSE2__)
+    // Pairs of full words
+    w = full_words / 2 * 2;
+    switch (bits) {
+    case 1:
+        count = count_equal_bits_sse2<1>(words, w, pattern);
+        break;
+    case 2:
+        count = count_equal_bits_sse2<2>(words, w, pattern);
+        break;
+    default:
+        count = count_equal_bits_sse2<4>(words, w, pattern);
+    }
+#endif
+
+    // SIMD within a register: XOR with the code repeated in every lane
+    // leaves the matching lanes zero. Their bits are OR'ed into the lowest
+    // bit of the lane, and popcount gives the lanes which don't match
+    auto mismatches = [bits, low_bits, pattern](uint64_t word) {
+        uint64_t x = word ^ pattern;
+        if (bits >= 2) {
+            x |= x >> 1;
+        }
+        if (bits >= 4) {
+            x |= x >> 2;
+        }
+        return x & low_bits;
+    };
+    for (; w < full_words; ++w) {
+        count += lanes - static_cast<unsigned>(
+                             std::popcount(mismatches(words[w])));
+    }
+    if (const std::size_t tail = size % lanes; tail != 0) {
+        const uint64_t valid = (uint64_t{1} << (tail * bits)) - 1;
+        count += tail - static_cast<unsigned>(std::popcount(
+                            mismatches(words[full_words]) & valid));
+    }
+    return count;
+}
+
+} // namespace detail
+
+// A column of integers stored in the narrowest width their range allows.
+//
+// The traversal dataset, `(++generator) % 256` in a std::vector<int>, needs
+// 1 byte per value instead of 4: every scan over it moves 4x fewer bytes.
+// The values are kept as codes, `value - min`: 1, 2 or 4 bytes each, or 1, 2
+// or 4 bits each for the small ranges (packed into 64-bit words, never
+// straddling two of them). `count_equal` compares the codes, 16 bytes at a
+// time with SSE2, without decoding them.
+//
+// The range is fixed on construction, observed from the values or declared
+// up front for appending values as they come:
+//
+//   auto column = packed_column<int>::encode(values);
+//   column.count_equal(126);
+//
+//   packed_column<int> column{0, 255}; // bytes1
+//   column.push_back(...);             // Throws std::out_of_range outside it
+template <class T> class packed_column {
+    static_assert(std::is_integral_v<T> && sizeof(T) <= 4,
+                  "integers of at most 32 bits");
+
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+
+    // Throws std::invalid_argument if `encoding` is too narrow for the range
+    packed_column(T min, T max,
+                  packed_encoding encoding = packed_encoding::automatic)
+        : min_{min}, max_{max} {
+        if (max < min) {
+            throw std::invalid_argument{"packed_column: max < min"};
+        }
+        const auto needed = static_cast<unsigned>(std::bit_width(_range()));
+        encoding_ = encoding == packed_encoding::automatic
+                        ? _narrowest(needed)
+                        : encoding;
+        bits_ = _bits_of(encoding_);
+        if (needed > bits_) {
+            throw std::invalid_argument{
+                "packed_column: the encoding is too narrow for the range"};
+        }
+    }
+
+    // The range of `values`, then the values
+    static packed_column
+    encode(std::span<const T> values,
+           packed_encoding encoding = packed_encoding::automatic) {
+        const auto [min, max] =
+            values.empty() ? std::pair<T, T>{}
+                           : std::pair<T, T>{
+                                 *std::min_element(values.begin(),
+                                                   values.end()),
+                                 *std::max_element(values.begin(),
+                                                   values.end())};
+        packed_column column{min, max, encoding};
+        column.reserve(values.size());
+        column.append(values);
+        return column;
+    }
+
+    packed_column(const packed_column &rh)
+        : packed_column(rh.min_, rh.max_, rh.encoding_) {
+        if (rh.size_ != 0) {
+            reserve(rh.size_);
+            std::memcpy(data_.get(), rh.data_.get(), _bytes_for(rh.size_));
+            size_ = rh.size_;
+        }
+    }
+
+    packed_column(packed_column &&rh) noexcept
+        : min_{rh.min_}, max_{rh.max_}, encoding_{rh.encoding_},
+          bits_{rh.bits_}, data_{std::move(rh.data_)},
+          size_{std::exchange(rh.size_, 0)},
+          capacity_{std::exchange(rh.capacity_, 0)} {}
+
+    packed_column &operator=(packed_column rh) noexcept {
+        swap(rh);
+        return *this;
+    }
+
+    void swap(packed_column &rh) noexcept {
+        std::swap(min_, rh.min_);
+        std::swap(max_, rh.max_);
+        std::swap(encoding_, rh.encoding_);
+        std::swap(bits_, rh.bits_);
+        data_.swap(rh.data_);
+        std::swap(size_, rh.size_);
+        std::swap(capacity_, rh.capacity_);
+    }
+
+    T operator[](size_type pos) const noexcept {
+        return static_cast<T>(static_cast<int64_t>(min_) +
+                              static_cast<int64_t>(_code(pos)));
+    }
+
+    T at(size_type pos) const {
+        if (pos >= size_) {
+            throw std::out_of_range{"packed_column: position out of range"};
+        }
+        return (*this)[pos];
+    }
+
+    void push_back(T value) {
+        if (value < min_ || value > max_) {
+            throw std::out_of_range{"packed_column: value out of the range"};
+        }
+        if (size_ == capacity_) {
+            reserve(std::max<size_type>(capacity_ * 2, 64));
+        }
+        _set_code(size_, _code_of(value));
+        ++size_;
+    }
+
+    void append(std::span<const T> values) {
+        reserve(size_ + values.size());
+        for (const T value : values) {
+            push_back(value);
+        }
+    }
+
+    void reserve(size_type capacity) {
+        if (capacity <= capacity_) {
+            return;
+        }
+        const size_type bytes = _bytes_for(capacity);
+        _Storage storage{static_cast<unsigned char *>(
+            ::operator new(bytes, std::align_val_t{64}))};
+        std::memset(storage.get(), 0, bytes);
+        if (size_ != 0) {
+            std::memcpy(storage.get(), data_.get(), _bytes_for(size_));
+        }
+        data_ = std::move(storage);
+        capacity_ = capacity;
+    }
+
+    // The number of values equal to `value`
+    size_type count_equal(T value) const noexcept {
+        if (value < min_ || value > max_) {
+            return 0;
+        }
+        const uint64_t code = _code_of(value);
+        switch (encoding_) {
+        case packed_encoding::bytes1:
+            return detail::count_equal_u8(_codes<uint8_t>(), size_,
+                                          static_cast<uint8_t>(code));
+        case packed_encoding::bytes2:
+            return detail::count_equal_u16(_codes<uint16_t>(), size_,
+                                           static_cast<uint16_t>(code));
+        case packed_encoding::bytes4:
+            return detail::count_equal_u32(_codes<uint32_t>(), size_,
+                                           static_cast<uint32_t>(code));
+        default:
+            return detail::count_equal_bits(_codes<uint64_t>(), size_, bits_,
+                                            code);
+        }
+    }
+
+    size_type size(void) const noexcept { return size_; }
+    bool empty(void) const noexcept { return size_ == 0; }
+
+    T min_value(void) const noexcept { return min_; }
+    T max_value(void) const noexcept { return max_; }
+    packed_encoding encoding(void) const noexcept { return encoding_; }
+    unsigned bits_per_value(void) const noexcept { return bits_; }
+
+    // The packed values, without the unused capacity
+    size_type memory_bytes(void) const noexcept { return _bytes_for(size_); }
+
+  private:
+    struct _Deleter {
+        void operator()(unsigned char *ptr) const noexcept {
+            ::operator delete(ptr, std::align_val_t{64});
+        }
+    };
+    using _Storage = std::unique_ptr<unsigned char[], _Deleter>;
+
+    static packed_encoding _narrowest(unsigned bits) noexcept {
+        if (bits <= 1) {
+            return packed_encoding::bits1;
+        }
+        if (bits <= 2) {
+            return packed_encoding::bits2;
+        }
+        if (bits <= 4) {
+            return packed_encoding::bits4;
+        }
+        if (bits <= 8) {
+            return packed_encoding::bytes1;
+        }
+        return bits <= 16 ? packed_encoding::bytes2 : packed_encoding::bytes4;
+    }
+
+    static unsigned _bits_of(packed_encoding encoding) noexcept {
+        switch (encoding) {
+        case packed_encoding::bits1:
+            return 1;
+        case packed_encoding::bits2:
+            return 2;
+        case packed_encoding::bits4:
+            return 4;
+        case packed_encoding::bytes1:
+            return 8;
+        case packed_encoding::bytes2:
+            return 16;
+        default:
+            return 32;
+        }
+    }
+
+    uint64_t _range(void) const noexcept {
+        return static_cast<uint64_t>(static_cast<int64_t>(max_) -
+                                     static_cast<int64_t>(min_));
+    }
+
+    uint64_t _code_of(T value) const noexcept {
+        return static_cast<uint64_t>(static_cast<int64_t>(value) -
+                                     static_cast<int64_t>(min_));
+    }
+
+    size_type _bytes_for(size_type count) const noexcept {
+        if (bits_ >= 8) {
+            return count * (bits_ / 8);
+        }
+        const size_type per_word = 64 / bits_;
+        return (count + per_word - 1) / per_word * sizeof(uint64_t);
+    }
+
+    // The storage comes from `operator new`, which creates the code arrays
+    // implicitly
+    template <class Code> const Code *_codes(void) const noexcept {
+        return reinterpret_cast<const Code *>(data_.get());
+    }
+    template <class Code> Code *_codes(void) noexcept {
+        return reinterpret_cast<Code *>(data_.get());
+    }
+
+    uint64_t _code(size_type pos) const noexcept {
+        switch (bits_) {
+        case 8:
+            return _codes<uint8_t>()[pos];
+        case 16:
+            return _codes<uint16_t>()[pos];
+        case 32:
+            return _codes<uint32_t>()[pos];
+        default: {
+            const uint64_t word = _codes<uint64_t>()[pos >> _lanes_shift()];
+            return (word >> _lane_offset(pos)) & ((uint64_t{1} << bits_) - 1);
+        }
+        }
+    }
+
+    void _set_code(size_type pos, uint64_t code) noexcept {
+        switch (bits_) {
+        case 8:
+            _codes<uint8_t>()[pos] = static_cast<uint8_t>(code);
+            break;
+        case 16:
+            _codes<uint16_t>()[pos] = static_cast<uint16_t>(code);
+            break;
+        case 32:
+            _codes<uint32_t>()[pos] = static_cast<uint32_t>(code);
+            break;
+        default:
+            // The storage is zeroed, and values are only appended
+            _codes<uint64_t>()[pos >> _lanes_shift()] |= code
+                                                        << _lane_offset(pos);
+        }
+    }
+
+    // 64 / bits_ codes per word, a power of two: 2^_lanes_shift()
+    unsigned _lanes_shift(void) const noexcept {
+        return 6u - static_cast<unsigned>(std::countr_zero(bits_));
+    }
+
+    // The bit offset of the code `pos` in its word
+    unsigned _lane_offset(size_type pos) const noexcept {
+        const size_type lane = pos & ((size_type{1} << _lanes_shift()) - 1);
+        return static_cast<unsigned>(lane) * bits_;
+    }
+
+    T min_;
+    T max_;
+    packed_encoding encoding_;
+    unsigned bits_;
+    _Storage data_;
+    size_type size_{0};
+    size_type capacity_{0};
+};
+
+} // namespace cpp_core_sandbox
@@ -0,0 +1,239 @@
+#include "perf-counters.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace cpp_core_sandbox {
+
+namespace {
+
+int64_t now_ns(void) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+constexpr std::array<const char *, kPerfEventCount> event_names{
+    "cycles", "instructions", "L1d misses", "LLC misses", "branch misses",
+    "dTLB misses"};
+
+#if defined(__linux__)
+
+struct EventConfig {
+    uint32_t type;
+    uint64_t config;
+};
+
+constexpr uint64_t cache_event(uint64_t cache, uint64_t op, uint64_t result) {
+    return cache | (op << 8) | (result << 16);
+}
+
+constexpr std::array<EventConfig, kPerfEventCount> event_configs{{
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE,
+     cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                 PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE,
+     cache_event(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                 PERF_COUNT_HW_CACHE_RESULT_MISS)},
+}};
+
+// Returns the descriptor or -errno
+int open_event(const EventConfig &event) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1; // Allowed with perf_event_paranoid <= 2
+    attr.exclude_hv = 1;
+    // Events may be multiplexed when there are more of them than hardware
+    // counters, the times let us scale the counts
+    attr.read_format =
+        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    const long fd = syscall(SYS_perf_event_open, &attr, 0 /* this thread */,
+                            -1 /* any CPU */, -1 /* no group */, 0);
+    return fd < 0 ? -errno : static_cast<int>(fd);
+}
+
+std::string describe_error(int error) {
+    switch (error) {
+    case EACCES:
+    case EPERM:
+        return "not permitted, see /proc/sys/kernel/perf_event_paranoid";
+    case ENOENT:
+    case ENODEV:
+    case EOPNOTSUPP:
+        return "no hardware PMU (a VM or a container?)";
+    case ENOSYS:
+        return "perf_event_open isn't supported by the kernel";
+    default:
+        return std::strerror(error);
+    }
+}
+
+#endif
+
+} // namespace
+
+std::optional<double> PerfCounterValues::Ipc(void) const noexcept {
+    const auto cycles = Get(PerfEvent::kCycles);
+    const auto instructions = Get(PerfEvent::kInstructions);
+    if (!cycles || !instructions || *cycles == 0) {
+        return std::nullopt;
+    }
+    return static_cast<double>(*instructions) / static_cast<double>(*cycles);
+}
+
+ScopedPerfCounters::ScopedPerfCounters(std::string_view label,
+                                       uint64_t elements)
+    : label_(label), elements_(elements) {
+    fds_.fill(-1);
+    _start();
+}
+
+ScopedPerfCounters::~ScopedPerfCounters(void) {
+    if (!stopped_) {
+        Stop();
+        Print(std::cout);
+    }
+#if defined(__linux__)
+    for (const int fd : fds_) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+#endif
+}
+
+void ScopedPerfCounters::_start(void) {
+#if defined(__linux__)
+    int first_error{0};
+    for (std::size_t k = 0; k < kPerfEventCount; ++k) {
+        const int fd = open_event(event_configs[k]);
+        if (fd < 0) {
+            first_error = first_error == 0 ? -fd : first_error;
+            continue;
+        }
+        fds_[k] = fd;
+    }
+    if (std::all_of(fds_.cbegin(), fds_.cend(),
+                    [](int fd) { return fd < 0; })) {
+        unavailable_reason_ = describe_error(first_error);
+    }
+    start_ns_ = now_ns();
+    for (const int fd : fds_) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#else
+    unavailable_reason_ = "perf_event_open is Linux only";
+    start_ns_ = now_ns();
+#endif
+}
+
+const PerfCounterValues &ScopedPerfCounters::Stop(void) {
+    if (!stopped_) {
+        stopped_ = true;
+        _read();
+    }
+    return values_;
+}
+
+void ScopedPerfCounters::_read(void) {
+#if defined(__linux__)
+    for (const int fd : fds_) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+#endif
+    values_.elapsed_ms = static_cast<double>(now_ns() - start_ns_) / 1e6;
+#if defined(__linux__)
+    for (std::size_t k = 0; k < kPerfEventCount; ++k) {
+        if (fds_[k] < 0) {
+            continue;
+        }
+        // value, time enabled, time running
+        uint64_t data[3]{};
+        if (::read(fds_[k], data, sizeof(data)) != sizeof(data) ||
+            data[2] == 0) {
+            continue; // Never scheduled on a counter
+        }
+        values_.counts[k] = data[2] < data[1]
+                                ? static_cast<uint64_t>(
+                                      static_cast<double>(data[0]) *
+                                      static_cast<double>(data[1]) /
+                                      static_cast<double>(data[2]))
+                                : data[0];
+    }
+#endif
+}
+
+void ScopedPerfCounters::Print(std::ostream &out) const {
+    std::ostringstream line; // Keep the caller's stream flags intact
+    line << std::fixed << std::setprecision(1) << "[" << label_ << "] "
+         << values_.elapsed_ms << " ms";
+    if (!unavailable_reason_.empty()) {
+        line << " (hardware counters unavailable: " << unavailable_reason_
+             << ")";
+        out << line.str() << std::endl;
+        return;
+    }
+    if (const auto ipc = values_.Ipc()) {
+        line << std::setprecision(2) << ", IPC " << *ipc;
+    }
+    const double divisor =
+        elements_ == 0 ? 1.0 : static_cast<double>(elements_);
+    line << std::setprecision(4)
+         << (elements_ == 0 ? ", total:" : ", per element:");
+    bool first{true};
+    for (std::size_t k = 0; k < kPerfEventCount; ++k) {
+        if (static_cast<PerfEvent>(k) == PerfEvent::kInstructions ||
+            !values_.counts[k]) {
+            continue;
+        }
+        line << (first ? " " : ", ") << event_names[k] << " "
+             << static_cast<double>(*values_.counts[k]) / divisor;
+        first = false;
+    }
+    out << line.str() << std::endl;
+}
+
+bool ScopedPerfCounters::Available(void) {
+#if defined(__linux__)
+    static const bool available = [] {
+        for (const auto &event : event_configs) {
+            const int fd = open_event(event);
+            if (fd >= 0) {
+                close(fd);
+                return true;
+            }
+        }
+        return false;
+    }();
+    return available;
+#else
+    return false;
+#endif
+}
+
+} // namespace cpp_core_sandbox
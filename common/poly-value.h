@@ -0,0 +1,197 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace cpp_core_sandbox {
+
+// A value type holding any object derived from `Interface`.
+//
+// Objects that fit into `InlineSize` bytes (and can be moved without throwing)
+// are stored right inside the handle, so a container of `poly_value`s doesn't
+// need an allocation per element and iteration doesn't chase pointers. Larger
+// objects go to the heap, as they would with `std::unique_ptr<Interface>`.
+//
+// Lifetime operations (copy, move, destroy) are dispatched through a small
+// hand-rolled table owned by the handle, not through the virtual functions of
+// `Interface`. So neither a virtual destructor nor a `clone()` method is
+// required from the hierarchy.
+//
+// Interface methods are called through `operator->`, it costs a load of a
+// cached `Interface*` followed by a regular virtual call.
+template <class Interface, std::size_t InlineSize = 3 * sizeof(void *)>
+class poly_value {
+    struct _Ops {
+        void (*copy)(const poly_value &from, poly_value &to);
+        void (*move)(poly_value &from, poly_value &to) noexcept;
+        void (*destroy)(poly_value &self) noexcept;
+        bool is_inline;
+    };
+
+    template <class T>
+    static constexpr bool _fits_inline =
+        sizeof(T) <= InlineSize &&
+        alignof(T) <= alignof(std::max_align_t) &&
+        std::is_nothrow_move_constructible_v<T>;
+
+    template <class T> struct _InlineOps {
+        static T *get(poly_value &self) noexcept {
+            return std::launder(reinterpret_cast<T *>(self.buffer_));
+        }
+        static const T *get(const poly_value &self) noexcept {
+            return std::launder(reinterpret_cast<const T *>(self.buffer_));
+        }
+        static void copy(const poly_value &from, poly_value &to) {
+            to.iface_ = ::new (static_cast<void *>(to.buffer_)) T(*get(from));
+        }
+        static void move(poly_value &from, poly_value &to) noexcept {
+            T *src = get(from);
+            to.iface_ =
+                ::new (static_cast<void *>(to.buffer_)) T(std::move(*src));
+            src->~T();
+        }
+        static void destroy(poly_value &self) noexcept { get(self)->~T(); }
+
+        static constexpr _Ops ops{&copy, &move, &destroy, true};
+    };
+
+    template <class T> struct _HeapOps {
+        static T *&get(poly_value &self) noexcept {
+            return *std::launder(reinterpret_cast<T **>(self.buffer_));
+        }
+        static T *get(const poly_value &self) noexcept {
+            return *std::launder(reinterpret_cast<T *const *>(self.buffer_));
+        }
+        static void copy(const poly_value &from, poly_value &to) {
+            T *ptr = new T(*get(from));
+            ::new (static_cast<void *>(to.buffer_)) T *(ptr);
+            to.iface_ = ptr;
+        }
+        static void move(poly_value &from, poly_value &to) noexcept {
+            ::new (static_cast<void *>(to.buffer_)) T *(get(from));
+            to.iface_ = from.iface_; // The object itself stays in place
+        }
+        static void destroy(poly_value &self) noexcept { delete get(self); }
+
+        static constexpr _Ops ops{&copy, &move, &destroy, false};
+    };
+
+  public:
+    static_assert(InlineSize >= sizeof(void *),
+                  "The buffer must be able to hold at least a pointer");
+
+    poly_value(void) noexcept = default;
+
+    template <class T,
+              class = std::enable_if_t<
+                  !std::is_same_v<std::decay_t<T>, poly_value> &&
+                  std::is_base_of_v<Interface, std::decay_t<T>>>>
+    poly_value(T &&value) {
+        emplace<std::decay_t<T>>(std::forward<T>(value));
+    }
+
+    template <class T, class... Args>
+    explicit poly_value(std::in_place_type_t<T>, Args &&...args) {
+        emplace<T>(std::forward<Args>(args)...);
+    }
+
+    poly_value(const poly_value &rh) {
+        if (rh.ops_) {
+            rh.ops_->copy(rh, *this);
+            ops_ = rh.ops_;
+        }
+    }
+
+    poly_value(poly_value &&rh) noexcept { _steal(rh); }
+
+    poly_value &operator=(const poly_value &rh) {
+        if (this != &rh) {
+            poly_value tmp{rh}; // Strong exception guarantee
+            reset();
+            _steal(tmp);
+        }
+        return *this;
+    }
+
+    poly_value &operator=(poly_value &&rh) noexcept {
+        if (this != &rh) {
+            reset();
+            _steal(rh);
+        }
+        return *this;
+    }
+
+    ~poly_value(void) { reset(); }
+
+    template <class T, class... Args> T &emplace(Args &&...args) {
+        static_assert(std::is_base_of_v<Interface, T>,
+                      "T must be derived from Interface");
+        static_assert(std::is_copy_constructible_v<T>,
+                      "poly_value is copyable, so must be T");
+        reset();
+
+        T *ptr{nullptr};
+        if constexpr (_fits_inline<T>) {
+            ptr = ::new (static_cast<void *>(buffer_))
+                T(std::forward<Args>(args)...);
+            ops_ = &_InlineOps<T>::ops;
+        } else {
+            ptr = new T(std::forward<Args>(args)...);
+            ::new (static_cast<void *>(buffer_)) T *(ptr);
+            ops_ = &_HeapOps<T>::ops;
+        }
+        iface_ = ptr;
+        return *ptr;
+    }
+
+    void reset(void) noexcept {
+        if (ops_) {
+            ops_->destroy(*this);
+            ops_ = nullptr;
+            iface_ = nullptr;
+        }
+    }
+
+    void swap(poly_value &rh) noexcept {
+        poly_value tmp{std::move(rh)};
+        rh = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    [[nodiscard]] bool has_value(void) const noexcept {
+        return ops_ != nullptr;
+    }
+    explicit operator bool(void) const noexcept { return has_value(); }
+
+    // True if the object lives inside the handle
+    [[nodiscard]] bool is_inline(void) const noexcept {
+        return ops_ && ops_->is_inline;
+    }
+
+    Interface *get(void) noexcept { return iface_; }
+    const Interface *get(void) const noexcept { return iface_; }
+
+    Interface *operator->(void) noexcept { return iface_; }
+    const Interface *operator->(void) const noexcept { return iface_; }
+
+    Interface &operator*(void) noexcept { return *iface_; }
+    const Interface &operator*(void) const noexcept { return *iface_; }
+
+  private:
+    void _steal(poly_value &rh) noexcept {
+        if (rh.ops_) {
+            rh.ops_->move(rh, *this);
+            ops_ = rh.ops_;
+            rh.ops_ = nullptr;
+            rh.iface_ = nullptr;
+        }
+    }
+
+    const _Ops *ops_{nullptr};
+    Interface *iface_{nullptr};
+    alignas(std::max_align_t) unsigned char buffer_[InlineSize];
+};
+
+} // namespace cpp_core_sandbox
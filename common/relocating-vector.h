@@ -0,0 +1,317 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace cpp_core_sandbox {
+
+// Whether an object can be moved to another address by copying its bytes,
+// without running the move constructor and the destructor of the source.
+//
+// Detected for trivially copyable types. Most other types are relocatable
+// too as long as they don't point into themselves (unlike libstdc++'s
+// `std::string` with its short string buffer), but only the author of the
+// type knows it; opt in with a specialization:
+//
+//   template <> struct is_trivially_relocatable<my_handle> : std::true_type {};
+template <class T>
+struct is_trivially_relocatable
+    : std::bool_constant<std::is_trivially_copyable_v<T>> {};
+
+// A pointer and possibly the deleter, relocatable if the deleter is
+template <class T, class Deleter>
+struct is_trivially_relocatable<std::unique_ptr<T, Deleter>>
+    : is_trivially_relocatable<Deleter> {};
+
+template <class T, class U>
+struct is_trivially_relocatable<std::pair<T, U>>
+    : std::bool_constant<is_trivially_relocatable<T>::value &&
+                         is_trivially_relocatable<U>::value> {};
+
+template <class T>
+inline constexpr bool is_trivially_relocatable_v =
+    is_trivially_relocatable<T>::value;
+
+// How `relocating_vector<T>` moves its elements when it grows
+enum class relocation {
+    bitwise, // memcpy, or realloc which may not copy at all
+    move,    // The move constructor can't throw
+    copy,    // For the strong exception guarantee, like std::vector
+};
+
+// The move constructor alone. `std::is_nothrow_move_constructible` also asks
+// the destructor, and a `noexcept(false)` one like A's makes std::vector copy
+// on every growth
+template <class T>
+inline constexpr bool has_nothrow_move_constructor_v = noexcept(
+    ::new (static_cast<void *>(nullptr)) T(std::declval<T &&>()));
+
+template <class T>
+inline constexpr relocation relocation_of =
+    is_trivially_relocatable_v<T> ? relocation::bitwise
+    : has_nothrow_move_constructor_v<T> || !std::is_copy_constructible_v<T>
+        ? relocation::move
+        : relocation::copy;
+
+// A vector which grows without constructing anything for the trivially
+// relocatable types.
+//
+// std::vector moves its elements one by one into the new storage and
+// destroys the old ones, and copies them instead if the move constructor
+// may throw. Here a trivially relocatable element isn't touched at all: the
+// storage comes from `malloc`, and growing it is a `realloc` which extends
+// the block in place when it can, and for large blocks remaps the pages
+// rather than copying them (glibc's mremap). The other types are moved if
+// their move constructor is noexcept, copied otherwise (see
+// `relocation_of`).
+//
+// Interface of std::vector, the part needed for building a sequence:
+// no insertion in the middle, no allocator.
+template <class T> class relocating_vector {
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T &;
+    using const_reference = const T &;
+    using pointer = T *;
+    using const_pointer = const T *;
+    using iterator = T *;
+    using const_iterator = const T *;
+
+    static constexpr relocation relocation_kind = relocation_of<T>;
+
+    relocating_vector(void) noexcept = default;
+
+    relocating_vector(const relocating_vector &rh) : relocating_vector() {
+        reserve(rh.size_);
+        for (const auto &value : rh) {
+            emplace_back(value);
+        }
+    }
+
+    relocating_vector(relocating_vector &&rh) noexcept
+        : data_(std::exchange(rh.data_, nullptr)),
+          size_(std::exchange(rh.size_, 0)),
+          capacity_(std::exchange(rh.capacity_, 0)) {}
+
+    relocating_vector &operator=(relocating_vector rh) noexcept {
+        swap(rh);
+        return *this;
+    }
+
+    ~relocating_vector(void) {
+        clear();
+        _deallocate(data_);
+    }
+
+    void swap(relocating_vector &rh) noexcept {
+        std::swap(data_, rh.data_);
+        std::swap(size_, rh.size_);
+        std::swap(capacity_, rh.capacity_);
+    }
+
+    size_type size(void) const noexcept { return size_; }
+    size_type capacity(void) const noexcept { return capacity_; }
+    bool empty(void) const noexcept { return size_ == 0; }
+
+    T *data(void) noexcept { return data_; }
+    const T *data(void) const noexcept { return data_; }
+
+    reference operator[](size_type pos) noexcept { return data_[pos]; }
+    const_reference operator[](size_type pos) const noexcept {
+        return data_[pos];
+    }
+
+    reference at(size_type pos) {
+        _check_range(pos);
+        return data_[pos];
+    }
+    const_reference at(size_type pos) const {
+        _check_range(pos);
+        return data_[pos];
+    }
+
+    reference front(void) noexcept { return data_[0]; }
+    const_reference front(void) const noexcept { return data_[0]; }
+    reference back(void) noexcept { return data_[size_ - 1]; }
+    const_reference back(void) const noexcept { return data_[size_ - 1]; }
+
+    iterator begin(void) noexcept { return data_; }
+    iterator end(void) noexcept { return data_ + size_; }
+    const_iterator begin(void) const noexcept { return data_; }
+    const_iterator end(void) const noexcept { return data_ + size_; }
+    const_iterator cbegin(void) const noexcept { return begin(); }
+    const_iterator cend(void) const noexcept { return end(); }
+
+    void reserve(size_type capacity) {
+        if (capacity > capacity_) {
+            _reallocate(capacity);
+        }
+    }
+
+    void shrink_to_fit(void) {
+        if (size_ == 0) {
+            _deallocate(std::exchange(data_, nullptr));
+            capacity_ = 0;
+        } else if (size_ < capacity_) {
+            _reallocate(size_);
+        }
+    }
+
+    template <class... Args> reference emplace_back(Args &&...args) {
+        if (size_ == capacity_) {
+            return _grow_and_emplace(std::forward<Args>(args)...);
+        }
+        T *ptr = ::new (static_cast<void *>(data_ + size_))
+            T(std::forward<Args>(args)...);
+        ++size_;
+        return *ptr;
+    }
+
+    void push_back(const T &value) { emplace_back(value); }
+    void push_back(T &&value) { emplace_back(std::move(value)); }
+
+    void pop_back(void) noexcept {
+        --size_;
+        std::destroy_at(data_ + size_);
+    }
+
+    // Value-initialized new elements
+    void resize(size_type size) {
+        if (size < size_) {
+            std::destroy(data_ + size, data_ + size_);
+            size_ = size;
+            return;
+        }
+        reserve(size);
+        while (size_ < size) {
+            ::new (static_cast<void *>(data_ + size_)) T();
+            ++size_;
+        }
+    }
+
+    void clear(void) noexcept {
+        std::destroy(data_, data_ + size_);
+        size_ = 0;
+    }
+
+  private:
+    // realloc knows only the fundamental alignment
+    static constexpr bool _use_realloc =
+        relocation_kind == relocation::bitwise &&
+        alignof(T) <= alignof(std::max_align_t);
+
+    // Without realloc; with it, realloc(nullptr) is the malloc
+    static T *_allocate(size_type capacity) {
+        return static_cast<T *>(::operator new(capacity * sizeof(T),
+                                               std::align_val_t{alignof(T)}));
+    }
+
+    static void _deallocate(T *data) noexcept {
+        if constexpr (_use_realloc) {
+            std::free(data);
+        } else if (data != nullptr) {
+            ::operator delete(static_cast<void *>(data),
+                              std::align_val_t{alignof(T)});
+        }
+    }
+
+    void _check_range(size_type pos) const {
+        if (pos >= size_) {
+            throw std::out_of_range{
+                "relocating_vector: position out of range"};
+        }
+    }
+
+    size_type _next_capacity(void) const noexcept {
+        return std::max<size_type>(capacity_ * 2, 4);
+    }
+
+    // The elements from `data_` to `to`, which has room for them: moved or
+    // copied and destroyed, or just their bytes. On an exception (only
+    // copying may throw) `data_` is intact
+    void _relocate_to(T *to) {
+        if constexpr (relocation_kind == relocation::bitwise) {
+            if (size_ != 0) {
+                std::memcpy(static_cast<void *>(to), data_, size_ * sizeof(T));
+            }
+        } else if constexpr (relocation_kind == relocation::move) {
+            std::uninitialized_move(data_, data_ + size_, to);
+            std::destroy(data_, data_ + size_);
+        } else {
+            std::uninitialized_copy(data_, data_ + size_, to);
+            std::destroy(data_, data_ + size_);
+        }
+    }
+
+    void _reallocate(size_type capacity) {
+        if constexpr (_use_realloc) {
+            void *ptr = std::realloc(static_cast<void *>(data_),
+                                     capacity * sizeof(T));
+            if (ptr == nullptr) {
+                throw std::bad_alloc{};
+            }
+            data_ = static_cast<T *>(ptr);
+        } else {
+            T *storage = _allocate(capacity);
+            try {
+                _relocate_to(storage);
+            } catch (...) {
+                _deallocate(storage);
+                throw;
+            }
+            _deallocate(std::exchange(data_, storage));
+        }
+        capacity_ = capacity;
+    }
+
+    template <class... Args> reference _grow_and_emplace(Args &&...args) {
+        const size_type capacity = _next_capacity();
+        if constexpr (_use_realloc) {
+            // `args` may refer to an element, which realloc may free
+            T value(std::forward<Args>(args)...);
+            _reallocate(capacity);
+            T *ptr = ::new (static_cast<void *>(data_ + size_))
+                T(std::move(value));
+            ++size_;
+            return *ptr;
+        } else {
+            // The new element first, from `args` which may refer to an old
+            // one; nothing changes if it throws
+            T *storage = _allocate(capacity);
+            T *ptr;
+            try {
+                ptr = ::new (static_cast<void *>(storage + size_))
+                    T(std::forward<Args>(args)...);
+            } catch (...) {
+                _deallocate(storage);
+                throw;
+            }
+            try {
+                _relocate_to(storage);
+            } catch (...) {
+                std::destroy_at(ptr);
+                _deallocate(storage);
+                throw;
+            }
+            _deallocate(std::exchange(data_, storage));
+            capacity_ = capacity;
+            ++size_;
+            return *ptr;
+        }
+    }
+
+    T *data_{nullptr};
+    size_type size_{0};
+    size_type capacity_{0};
+};
+
+} // namespace cpp_core_sandbox
@@ -0,0 +1,353 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cpp_core_sandbox {
+
+// As many elements as fit into 4 KB (a power of two), but at least 16
+template <class T>
+inline constexpr unsigned default_block_shift =
+    std::max(4u, static_cast<unsigned>(std::bit_width(
+                     std::max<std::size_t>(1, 4096 / sizeof(T)))) -
+                     1u);
+
+// A sequence stored in fixed-size blocks of `1 << BlockShift` elements.
+//
+// Like `std::deque`:
+//  - push_back / pop_back / pop_front don't move the other elements, so
+//    references to them stay valid;
+//  - no reallocation with copying of the whole contents as the size grows.
+// Unlike libstdc++'s `std::deque` (512-byte blocks):
+//  - the block size is a template parameter, large by default;
+//  - element `i` is found with a shift and a mask, no division;
+//  - `for_each_segment` hands out the contiguous parts as spans, so the hot
+//    loops run over plain arrays and may be vectorized.
+//
+// Blocks released by pop_front are reused by push_back.
+template <class T, unsigned BlockShift = default_block_shift<T>>
+class segmented_vector {
+    template <bool Const> class _Iterator;
+
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T &;
+    using const_reference = const T &;
+    using pointer = T *;
+    using const_pointer = const T *;
+    using iterator = _Iterator<false>;
+    using const_iterator = _Iterator<true>;
+
+    static constexpr unsigned block_shift = BlockShift;
+    static constexpr size_type block_size = size_type{1} << BlockShift;
+
+    segmented_vector(void) noexcept = default;
+
+    segmented_vector(const segmented_vector &rh) : segmented_vector() {
+        rh.for_each_segment([this](std::span<const T> segment) {
+            for (const auto &value : segment) {
+                push_back(value);
+            }
+        });
+    }
+
+    segmented_vector(segmented_vector &&rh) noexcept
+        : blocks_(std::move(rh.blocks_)), spare_(std::move(rh.spare_)),
+          first_block_(std::exchange(rh.first_block_, 0)),
+          head_(std::exchange(rh.head_, 0)),
+          size_(std::exchange(rh.size_, 0)) {}
+
+    segmented_vector &operator=(segmented_vector rh) noexcept {
+        swap(rh);
+        return *this;
+    }
+
+    ~segmented_vector(void) { clear(); }
+
+    void swap(segmented_vector &rh) noexcept {
+        blocks_.swap(rh.blocks_);
+        spare_.swap(rh.spare_);
+        std::swap(first_block_, rh.first_block_);
+        std::swap(head_, rh.head_);
+        std::swap(size_, rh.size_);
+    }
+
+    size_type size(void) const noexcept { return size_; }
+    bool empty(void) const noexcept { return size_ == 0; }
+
+    reference operator[](size_type pos) noexcept { return *_at(pos); }
+    const_reference operator[](size_type pos) const noexcept {
+        return *_at(pos);
+    }
+
+    reference at(size_type pos) {
+        _check_range(pos);
+        return *_at(pos);
+    }
+    const_reference at(size_type pos) const {
+        _check_range(pos);
+        return *_at(pos);
+    }
+
+    reference front(void) noexcept { return *_at(0); }
+    const_reference front(void) const noexcept { return *_at(0); }
+    reference back(void) noexcept { return *_at(size_ - 1); }
+    const_reference back(void) const noexcept { return *_at(size_ - 1); }
+
+    template <class... Args> reference emplace_back(Args &&...args) {
+        const size_type slot = head_ + size_;
+        if ((slot >> BlockShift) >= _block_count()) {
+            _add_block();
+        }
+        T *ptr = ::new (static_cast<void *>(_slot(slot)))
+            T(std::forward<Args>(args)...);
+        ++size_;
+        return *ptr;
+    }
+
+    void push_back(const T &value) { emplace_back(value); }
+    void push_back(T &&value) { emplace_back(std::move(value)); }
+
+    void pop_back(void) noexcept {
+        --size_;
+        std::destroy_at(_slot(head_ + size_));
+    }
+
+    void pop_front(void) noexcept {
+        std::destroy_at(_slot(head_));
+        --size_;
+        if (size_ == 0) {
+            // Start over at the beginning of the first block
+            head_ = 0;
+            return;
+        }
+        if (++head_ == block_size) {
+            _release_first_block();
+            head_ = 0;
+        }
+    }
+
+    void clear(void) noexcept {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for_each_segment([](std::span<T> segment) {
+                std::destroy(segment.begin(), segment.end());
+            });
+        }
+        size_ = 0;
+        head_ = 0;
+    }
+
+    // Calls `fn(std::span<T>)` for every contiguous part, in order
+    template <class Fn> void for_each_segment(Fn &&fn) {
+        _for_each_segment<T>(*this, fn);
+    }
+    template <class Fn> void for_each_segment(Fn &&fn) const {
+        _for_each_segment<const T>(*this, fn);
+    }
+
+    iterator begin(void) noexcept { return {this, 0}; }
+    iterator end(void) noexcept { return {this, size_}; }
+    const_iterator begin(void) const noexcept { return {this, 0}; }
+    const_iterator end(void) const noexcept { return {this, size_}; }
+    const_iterator cbegin(void) const noexcept { return begin(); }
+    const_iterator cend(void) const noexcept { return end(); }
+
+  private:
+    static constexpr size_type kMask = block_size - 1;
+
+    struct _BlockDeleter {
+        void operator()(T *block) const noexcept {
+            ::operator delete(static_cast<void *>(block),
+                              std::align_val_t{alignof(T)});
+        }
+    };
+    using _Block = std::unique_ptr<T, _BlockDeleter>;
+
+    size_type _block_count(void) const noexcept {
+        return blocks_.size() - first_block_;
+    }
+
+    // `slot` counts from the beginning of the first block in use
+    T *_slot(size_type slot) const noexcept {
+        return blocks_[first_block_ + (slot >> BlockShift)].get() +
+               (slot & kMask);
+    }
+
+    T *_at(size_type pos) const noexcept { return _slot(head_ + pos); }
+
+    void _check_range(size_type pos) const {
+        if (pos >= size_) {
+            throw std::out_of_range{"segmented_vector: position out of range"};
+        }
+    }
+
+    void _add_block(void) {
+        if (!spare_.empty()) {
+            blocks_.push_back(std::move(spare_.back()));
+            spare_.pop_back();
+            return;
+        }
+        blocks_.emplace_back(static_cast<T *>(::operator new(
+            block_size * sizeof(T), std::align_val_t{alignof(T)})));
+    }
+
+    // The first block has been emptied by pop_front
+    void _release_first_block(void) {
+        spare_.push_back(std::move(blocks_[first_block_++]));
+        // Compact the block table lazily: amortized O(1) per block
+        if (first_block_ * 2 >= blocks_.size()) {
+            blocks_.erase(blocks_.begin(),
+                          blocks_.begin() +
+                              static_cast<difference_type>(first_block_));
+            first_block_ = 0;
+        }
+    }
+
+    template <class U, class Self, class Fn>
+    static void _for_each_segment(Self &self, Fn &fn) {
+        size_type slot = self.head_;
+        size_type left = self.size_;
+        while (left != 0) {
+            const size_type count = std::min(left, block_size - (slot & kMask));
+            fn(std::span<U>{self._slot(slot), count});
+            slot += count;
+            left -= count;
+        }
+    }
+
+    std::vector<_Block> blocks_;
+    std::vector<_Block> spare_;
+    size_type first_block_{0}; // Blocks before it are retired
+    size_type head_{0};        // Offset of the front in the first block
+    size_type size_{0};
+};
+
+// A random access iterator caching the current block, so `++` is a pointer
+// increment until the end of the block
+template <class T, unsigned BlockShift>
+template <bool Const>
+class segmented_vector<T, BlockShift>::_Iterator {
+    using _Owner = std::conditional_t<Const, const segmented_vector,
+                                      segmented_vector>;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using iterator_concept = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const, const T *, T *>;
+    using reference = std::conditional_t<Const, const T &, T &>;
+
+    _Iterator(void) noexcept = default;
+    _Iterator(_Owner *owner, size_type pos) noexcept
+        : owner_(owner), pos_(pos) {
+        _reseat();
+    }
+
+    // iterator -> const_iterator
+    template <bool OtherConst>
+        requires(Const && !OtherConst)
+    _Iterator(const _Iterator<OtherConst> &rh) noexcept
+        : _Iterator(rh.owner_, rh.pos_) {}
+
+    reference operator*(void) const noexcept { return *cur_; }
+    pointer operator->(void) const noexcept { return cur_; }
+    reference operator[](difference_type n) const noexcept {
+        return (*owner_)[pos_ + static_cast<size_type>(n)];
+    }
+
+    _Iterator &operator++(void) noexcept {
+        ++pos_;
+        if (++cur_ == block_end_) {
+            _reseat();
+        }
+        return *this;
+    }
+    _Iterator operator++(int) noexcept {
+        auto copy = *this;
+        ++*this;
+        return copy;
+    }
+    _Iterator &operator--(void) noexcept { return *this -= 1; }
+    _Iterator operator--(int) noexcept {
+        auto copy = *this;
+        --*this;
+        return copy;
+    }
+
+    _Iterator &operator+=(difference_type n) noexcept {
+        pos_ += static_cast<size_type>(n);
+        _reseat();
+        return *this;
+    }
+    _Iterator &operator-=(difference_type n) noexcept { return *this += -n; }
+
+    friend _Iterator operator+(_Iterator it, difference_type n) noexcept {
+        return it += n;
+    }
+    friend _Iterator operator+(difference_type n, _Iterator it) noexcept {
+        return it += n;
+    }
+    friend _Iterator operator-(_Iterator it, difference_type n) noexcept {
+        return it -= n;
+    }
+    friend difference_type operator-(const _Iterator &a,
+                                     const _Iterator &b) noexcept {
+        return static_cast<difference_type>(a.pos_) -
+               static_cast<difference_type>(b.pos_);
+    }
+
+    friend bool operator==(const _Iterator &a, const _Iterator &b) noexcept {
+        return a.pos_ == b.pos_;
+    }
+    friend auto operator<=>(const _Iterator &a, const _Iterator &b) noexcept {
+        return a.pos_ <=> b.pos_;
+    }
+
+  private:
+    template <bool> friend class _Iterator;
+
+    void _reseat(void) noexcept {
+        if (owner_ == nullptr || pos_ >= owner_->size_) {
+            cur_ = block_end_ = nullptr;
+            return;
+        }
+        const size_type slot = owner_->head_ + pos_;
+        cur_ = owner_->_slot(slot);
+        block_end_ = cur_ + (block_size - (slot & kMask));
+    }
+
+    _Owner *owner_{nullptr};
+    size_type pos_{0};
+    pointer cur_{nullptr};
+    pointer block_end_{nullptr};
+};
+
+// Calls `fn(std::span)` for every contiguous part of `container`: the segments
+// of a `segmented_vector`, the whole storage of a contiguous container.
+// Returns false if the container is neither (e.g. `std::deque`)
+template <class Container, class Fn>
+bool for_each_segment(Container &container, Fn &&fn) {
+    if constexpr (requires { container.for_each_segment(fn); }) {
+        container.for_each_segment(fn);
+        return true;
+    } else if constexpr (requires { std::span{container}; }) {
+        fn(std::span{container});
+        return true;
+    } else {
+        return false;
+    }
+}
+
+} // namespace cpp_core_sandbox
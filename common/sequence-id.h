@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+
+namespace cpp_core_sandbox {
+
+// Unique sequence numbers for instances created on many threads.
+//
+// A single atomic counter incremented for every instance is a cache line all
+// the constructing threads fight for. Here a thread reserves a block of
+// `block_size()` consecutive numbers with one `fetch_add` on the global
+// counter and then hands them out from thread-local storage, touching the
+// shared line once per block.
+//
+// The numbers are unique and increase within a thread. Across threads they
+// are ordered only up to a block: a thread may still be using an older block
+// while another one has reserved a newer. With a single thread they are
+// exactly `First, First + 1, ...`, whatever the block size.
+//
+// `Tag` separates the sequences, every tag has its own counter:
+//   int seq_no_{sequence_ids<A>::next()};
+template <class Tag, int First = 1> class sequence_ids {
+  public:
+    static constexpr int default_block_size{64};
+
+    static int next(void) noexcept {
+        block &current = block_;
+        if (current.next == current.end) {
+            _reserve(current);
+        }
+        return current.next++;
+    }
+
+    // Applies to the blocks reserved from now on; the numbers already
+    // reserved by the threads are used up first. Values below 1 mean 1,
+    // i.e. one atomic increment per number
+    static void set_block_size(int size) noexcept {
+        block_size_.store(size < 1 ? 1 : size, std::memory_order_relaxed);
+    }
+
+    static int block_size(void) noexcept {
+        return block_size_.load(std::memory_order_relaxed);
+    }
+
+    // The first number no thread has reserved yet
+    static int reserved_end(void) noexcept {
+        return counter_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    struct block {
+        int next{0};
+        int end{0};
+    };
+
+    static void _reserve(block &current) noexcept {
+        // Uniqueness is all the counter guarantees, no ordering of memory
+        // around it is needed
+        const int size = block_size();
+        current.next = counter_.fetch_add(size, std::memory_order_relaxed);
+        current.end = current.next + size;
+    }
+
+    // On a line of its own, so that reading `block_size_` doesn't contend
+    // with the reservations
+    alignas(64) static inline std::atomic<int> counter_{First};
+    alignas(64) static inline std::atomic<int> block_size_{default_block_size};
+
+    static inline thread_local block block_;
+};
+
+} // namespace cpp_core_sandbox
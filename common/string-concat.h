@@ -0,0 +1,187 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace cpp_core_sandbox {
+
+// Concatenation of string-like values with a single allocation.
+//
+// `a + b + c + d` on std::string creates a temporary after the first `+` and
+// appends the rest to it, reallocating whenever the capacity is exceeded.
+// Here the operands are collected first, the final length is computed once,
+// and the characters are written into a buffer of exactly that size:
+//
+//   std::string s = concat(name, ": ", 42, '\n');       // one allocation
+//   std::string s = concat_expr{} + name + ": " + 42;   // the same
+//   auto view = concat_to(buffer, name, ": ", 42);      // no allocation
+//
+// Operands: anything convertible to std::string_view (std::string, literals,
+// views), `char`, and integers (formatted with std::to_chars, `signed char`
+// and `unsigned char` included). Other character types are rejected.
+//
+// Operands are captured by reference (string-likes) until the expression is
+// converted, so don't keep a `concat_expr` beyond the full expression.
+
+namespace detail {
+
+struct string_piece {
+    std::string_view view;
+
+    std::size_t size(void) const noexcept { return view.size(); }
+    char *write(char *out) const noexcept {
+        if (!view.empty()) {
+            std::memcpy(out, view.data(), view.size());
+        }
+        return out + view.size();
+    }
+};
+
+struct char_piece {
+    char ch;
+
+    static constexpr std::size_t size(void) noexcept { return 1; }
+    char *write(char *out) const noexcept {
+        *out = ch;
+        return out + 1;
+    }
+};
+
+// Integers are formatted when captured, that's the only way to know the length
+template <class Int> struct integer_piece {
+    static_assert(std::numeric_limits<Int>::is_integer);
+
+    // All the digits `digits10` guarantees, one which may be partial, a sign
+    char digits[std::numeric_limits<Int>::digits10 + 2];
+    unsigned char length;
+
+    explicit integer_piece(Int value) noexcept {
+        const auto result =
+            std::to_chars(digits, digits + sizeof(digits), value);
+        // Can't fail, the buffer holds the longest value of Int
+        if (result.ec != std::errc{}) {
+            std::terminate();
+        }
+        length = static_cast<unsigned char>(result.ptr - digits);
+    }
+
+    std::size_t size(void) const noexcept { return length; }
+    char *write(char *out) const noexcept {
+        std::memcpy(out, digits, length);
+        return out + length;
+    }
+};
+
+template <class T>
+inline constexpr bool is_wide_char_v =
+    std::is_same_v<T, wchar_t> || std::is_same_v<T, char8_t> ||
+    std::is_same_v<T, char16_t> || std::is_same_v<T, char32_t>;
+
+// `signed char` and `unsigned char` are std::int8_t and std::uint8_t, so they
+// are formatted as integers; only plain `char` is a character
+template <class T> auto make_piece(const T &value) noexcept {
+    static_assert(!is_wide_char_v<T>,
+                  "Only char is written as a character, convert other "
+                  "character types to a string_view or an integer");
+    if constexpr (std::is_same_v<T, char>) {
+        return char_piece{value};
+    } else if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool>) {
+        return integer_piece<T>{value};
+    } else {
+        static_assert(std::is_convertible_v<const T &, std::string_view>,
+                      "Operand must be a string-like value, a char or an "
+                      "integer");
+        return string_piece{std::string_view{value}};
+    }
+}
+
+} // namespace detail
+
+template <class... Pieces> class concat_expr {
+  public:
+    concat_expr(void) noexcept
+        requires(sizeof...(Pieces) == 0)
+    = default;
+
+    explicit concat_expr(std::tuple<Pieces...> pieces) noexcept
+        : pieces_(std::move(pieces)) {}
+
+    // Total length of the result
+    std::size_t size(void) const noexcept {
+        return std::apply(
+            [](const auto &...piece) { return (std::size_t{0} + ... + piece.size()); },
+            pieces_);
+    }
+
+    // Writes exactly `size()` characters, returns the end of the output
+    char *write(char *out) const noexcept {
+        std::apply([&out](const auto &...piece) { ((out = piece.write(out)), ...); },
+                   pieces_);
+        return out;
+    }
+
+    // Appends to `out`, growing it at most once
+    void append_to(std::string &out) const {
+        const auto old_size = out.size();
+        out.resize(old_size + size());
+        write(out.data() + old_size);
+    }
+
+    std::string str(void) const {
+        std::string result;
+        append_to(result);
+        return result;
+    }
+
+    operator std::string(void) const { return str(); }
+
+    template <class T> auto operator+(const T &value) const noexcept {
+        return concat_expr<Pieces..., decltype(detail::make_piece(value))>{
+            std::tuple_cat(pieces_, std::make_tuple(detail::make_piece(value)))};
+    }
+
+  private:
+    std::tuple<Pieces...> pieces_;
+};
+
+concat_expr() -> concat_expr<>;
+
+template <class... Args> auto make_concat_expr(const Args &...args) noexcept {
+    return concat_expr<decltype(detail::make_piece(args))...>{
+        std::make_tuple(detail::make_piece(args)...)};
+}
+
+template <class... Args> std::string concat(const Args &...args) {
+    return make_concat_expr(args...).str();
+}
+
+// Appends all operands to `out`, reusing its capacity
+template <class... Args> void concat_append(std::string &out, const Args &...args) {
+    make_concat_expr(args...).append_to(out);
+}
+
+// Writes into a caller-supplied buffer, throws std::length_error if the
+// buffer is too small
+template <class... Args>
+std::string_view concat_to(std::span<char> buffer, const Args &...args) {
+    const auto expr = make_concat_expr(args...);
+    const auto size = expr.size();
+    if (size > buffer.size()) {
+        throw std::length_error{"concat_to: the buffer is too small"};
+    }
+    expr.write(buffer.data());
+    return {buffer.data(), size};
+}
+
+} // namespace cpp_core_sandbox
@@ -0,0 +1,220 @@
+#include "string-pool.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+
+namespace cpp_core_sandbox {
+
+StringPool::_Table::_Table(std::size_t size)
+    : mask{size - 1}, slots{std::make_unique<std::atomic<uint32_t>[]>(size)} {}
+
+StringPool::StringPool(void) {
+    for (auto &shard : shards_) {
+        shard.tables.push_back(std::make_unique<_Table>(64));
+        shard.table.store(shard.tables.back().get(), std::memory_order_release);
+    }
+}
+
+StringPool::~StringPool(void) {
+    for (auto &shard : shards_) {
+        for (auto &chunk : shard.chunks) {
+            delete[] chunk.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+uint64_t StringPool::_hash(std::string_view str) noexcept {
+    // Spread the bits: the top ones select a shard, the bottom ones a slot
+    const uint64_t h = std::hash<std::string_view>{}(str);
+    return h * 0x9E3779B97F4A7C15ULL;
+}
+
+const StringPool::_Entry &
+StringPool::_entry_at(const _Shard &shard, uint32_t index) const noexcept {
+    const uint64_t j = uint64_t{index} + (uint64_t{1} << kFirstChunkBits);
+    const auto chunk =
+        static_cast<unsigned>(std::bit_width(j)) - 1 - kFirstChunkBits;
+    const uint64_t offset = j - (uint64_t{1} << (chunk + kFirstChunkBits));
+    return shard.chunks[chunk].load(std::memory_order_acquire)[offset];
+}
+
+uint32_t StringPool::_probe(const _Shard &shard, const _Table &table,
+                            std::string_view str,
+                            uint64_t hash) const noexcept {
+    const auto mask = table.mask;
+    for (auto pos = static_cast<std::size_t>(static_cast<uint32_t>(hash)) & mask;
+         ; pos = (pos + 1) & mask) {
+        // Acquire pairs with the release store of `_insert`: the entry is
+        // complete once its slot is visible
+        const uint32_t slot = table.slots[pos].load(std::memory_order_acquire);
+        if (slot == 0) {
+            return kNotFound;
+        }
+        const auto &entry = _entry_at(shard, slot - 1);
+        if (entry.hash == static_cast<uint32_t>(hash) &&
+            std::string_view{entry.data, entry.size} == str) {
+            return slot - 1;
+        }
+    }
+}
+
+const char *StringPool::_copy_chars(_Shard &shard, std::string_view str) {
+    if (str.empty()) {
+        return "";
+    }
+    if (str.size() > shard.arena_left) {
+        // Long strings get a block of their own, so the current block isn't
+        // wasted
+        const auto block_size = std::max(str.size(), kArenaBlockSize);
+        shard.arena.push_back(std::make_unique_for_overwrite<char[]>(block_size));
+        shard.arena_bytes += block_size;
+        if (block_size == kArenaBlockSize) {
+            shard.arena_cursor = shard.arena.back().get();
+            shard.arena_left = block_size;
+        } else {
+            std::memcpy(shard.arena.back().get(), str.data(), str.size());
+            return shard.arena.back().get();
+        }
+    }
+    char *data = shard.arena_cursor;
+    std::memcpy(data, str.data(), str.size());
+    shard.arena_cursor += str.size();
+    shard.arena_left -= str.size();
+    return data;
+}
+
+void StringPool::_grow(_Shard &shard) {
+    const auto &current = *shard.tables.back();
+    auto table = std::make_unique<_Table>((current.mask + 1) * 2);
+    const auto count = shard.count.load(std::memory_order_relaxed);
+    for (uint32_t index = 0; index < count; ++index) {
+        auto pos =
+            static_cast<std::size_t>(_entry_at(shard, index).hash) & table->mask;
+        while (table->slots[pos].load(std::memory_order_relaxed) != 0) {
+            pos = (pos + 1) & table->mask;
+        }
+        table->slots[pos].store(index + 1, std::memory_order_relaxed);
+    }
+
+    // Readers may still probe the old table, so it isn't freed. Tables grow
+    // twice each time, so retired ones take less memory than the current one
+    shard.table.store(table.get(), std::memory_order_release);
+    shard.tables.push_back(std::move(table));
+}
+
+uint32_t StringPool::_insert(_Shard &shard, std::string_view str,
+                             uint64_t hash) {
+    if (str.size() > UINT32_MAX) {
+        throw std::length_error{"StringPool: the string is too long"};
+    }
+    const uint32_t index = shard.count.load(std::memory_order_relaxed);
+    if (index >= (uint32_t{1} << kIndexBits)) {
+        throw std::length_error{"StringPool: the shard is full"};
+    }
+
+    // Keep the load factor below 1/2
+    if ((std::size_t{index} + 1) * 2 > shard.tables.back()->mask + 1) {
+        _grow(shard);
+    }
+
+    // A new chunk is published before the entry becomes reachable
+    const uint64_t j = uint64_t{index} + (uint64_t{1} << kFirstChunkBits);
+    const auto chunk =
+        static_cast<unsigned>(std::bit_width(j)) - 1 - kFirstChunkBits;
+    const uint64_t offset = j - (uint64_t{1} << (chunk + kFirstChunkBits));
+    _Entry *entries = shard.chunks[chunk].load(std::memory_order_relaxed);
+    if (entries == nullptr) {
+        entries = new _Entry[std::size_t{1} << (chunk + kFirstChunkBits)];
+        shard.chunks[chunk].store(entries, std::memory_order_release);
+    }
+    entries[offset] = _Entry{_copy_chars(shard, str),
+                             static_cast<uint32_t>(str.size()),
+                             static_cast<uint32_t>(hash)};
+
+    auto &table = *shard.tables.back();
+    auto pos = static_cast<std::size_t>(static_cast<uint32_t>(hash)) & table.mask;
+    while (table.slots[pos].load(std::memory_order_relaxed) != 0) {
+        pos = (pos + 1) & table.mask;
+    }
+    table.slots[pos].store(index + 1, std::memory_order_release);
+    shard.count.store(index + 1, std::memory_order_relaxed);
+    return index;
+}
+
+StringPool::Handle StringPool::Intern(std::string_view str) {
+    const uint64_t hash = _hash(str);
+    const auto shard_no = static_cast<uint32_t>(hash >> (64 - kShardBits));
+    auto &shard = shards_[shard_no];
+
+    // The fast path: the string is already there
+    const auto found = _probe(
+        shard, *shard.table.load(std::memory_order_acquire), str, hash);
+    if (found != kNotFound) {
+        return (shard_no << kIndexBits) | found;
+    }
+
+    std::lock_guard lock{shard.mutex};
+    // Someone might have been faster, or the table might have grown
+    auto index = _probe(shard, *shard.tables.back(), str, hash);
+    if (index == kNotFound) {
+        index = _insert(shard, str, hash);
+    }
+    return (shard_no << kIndexBits) | index;
+}
+
+std::optional<StringPool::Handle>
+StringPool::Find(std::string_view str) const {
+    const uint64_t hash = _hash(str);
+    const auto shard_no = static_cast<uint32_t>(hash >> (64 - kShardBits));
+    const auto &shard = shards_[shard_no];
+
+    const auto index = _probe(
+        shard, *shard.table.load(std::memory_order_acquire), str, hash);
+    if (index == kNotFound) {
+        return std::nullopt;
+    }
+    return (shard_no << kIndexBits) | index;
+}
+
+std::string_view StringPool::View(Handle handle) const noexcept {
+    const auto &shard = shards_[handle >> kIndexBits];
+    const auto &entry =
+        _entry_at(shard, handle & ((uint32_t{1} << kIndexBits) - 1));
+    return {entry.data, entry.size};
+}
+
+std::size_t StringPool::Size(void) const {
+    std::size_t size{0};
+    for (const auto &shard : shards_) {
+        size += shard.count.load(std::memory_order_relaxed);
+    }
+    return size;
+}
+
+std::size_t StringPool::BytesUsed(void) const {
+    std::size_t bytes{sizeof(*this)};
+    for (const auto &shard : shards_) {
+        std::lock_guard lock{shard.mutex};
+        bytes += shard.arena_bytes;
+        for (const auto &table : shard.tables) {
+            bytes += (table->mask + 1) * sizeof(uint32_t);
+        }
+        for (unsigned chunk = 0; chunk < kMaxChunks; ++chunk) {
+            if (shard.chunks[chunk].load(std::memory_order_relaxed)) {
+                bytes += sizeof(_Entry) << (chunk + kFirstChunkBits);
+            }
+        }
+    }
+    return bytes;
+}
+
+StringPool &StringPool::Global(void) {
+    static StringPool pool;
+    return pool;
+}
+
+} // namespace cpp_core_sandbox
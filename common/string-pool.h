@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace cpp_core_sandbox {
+
+// A thread-safe string interning pool.
+//
+// Every distinct string is stored once and identified by a 4-byte handle.
+// Interned strings are never removed, so handles and the views returned by
+// `view()` stay valid for the lifetime of the pool.
+//
+// The pool is split into shards selected by the hash of the string. Each shard
+// has its own open addressing table (linear probing). Lookups of interned
+// strings don't lock: slots are atomics, and a grown table is published as a
+// whole while the old one is kept alive until the pool is destroyed. Only an
+// insertion takes the (per-shard) mutex. `View()` doesn't lock either.
+class StringPool final {
+  public:
+    using Handle = uint32_t;
+
+    StringPool(void);
+    ~StringPool(void);
+
+    StringPool(const StringPool &) = delete;
+    StringPool &operator=(const StringPool &) = delete;
+
+    // Returns the handle of `str`, adding it to the pool if necessary
+    Handle Intern(std::string_view str);
+
+    // Returns the handle if `str` has been interned
+    std::optional<Handle> Find(std::string_view str) const;
+
+    // Lock-free. `handle` must have been returned by this pool
+    std::string_view View(Handle handle) const noexcept;
+
+    // Number of distinct strings
+    std::size_t Size(void) const;
+
+    // Memory held by the pool: characters, entries and tables
+    std::size_t BytesUsed(void) const;
+
+    // The process-wide pool
+    static StringPool &Global(void);
+
+  private:
+    static constexpr unsigned kShardBits{4};
+    static constexpr unsigned kIndexBits{32 - kShardBits};
+    static constexpr std::size_t kShards{std::size_t{1} << kShardBits};
+
+    // Entries live in chunks of growing size (1024, 2048, 4096, ...),
+    // so their addresses never change and readers need no lock
+    static constexpr unsigned kFirstChunkBits{10};
+    static constexpr std::size_t kMaxChunks{kIndexBits - kFirstChunkBits + 1};
+
+    // Characters are copied into blocks of this size
+    static constexpr std::size_t kArenaBlockSize{64 * 1024};
+
+    struct _Entry {
+        const char *data;
+        uint32_t size;
+        uint32_t hash;
+    };
+
+    // 0 means an empty slot, local index + 1 otherwise
+    struct _Table {
+        explicit _Table(std::size_t size);
+
+        std::size_t mask;
+        std::unique_ptr<std::atomic<uint32_t>[]> slots;
+    };
+
+    struct _Shard {
+        mutable std::mutex mutex; // Writers only
+
+        std::atomic<const _Table *> table{nullptr};
+        std::vector<std::unique_ptr<_Table>> tables; // The current and retired
+        std::atomic<uint32_t> count{0};
+
+        std::array<std::atomic<_Entry *>, kMaxChunks> chunks{};
+
+        std::vector<std::unique_ptr<char[]>> arena;
+        char *arena_cursor{nullptr};
+        std::size_t arena_left{0};
+        std::size_t arena_bytes{0};
+    };
+
+    static uint64_t _hash(std::string_view str) noexcept;
+
+    const _Entry &_entry_at(const _Shard &shard, uint32_t index) const noexcept;
+
+    static constexpr uint32_t kNotFound{UINT32_MAX};
+
+    // Returns the local index or `kNotFound`
+    uint32_t _probe(const _Shard &shard, const _Table &table,
+                    std::string_view str, uint64_t hash) const noexcept;
+
+    // Require the shard mutex
+    uint32_t _insert(_Shard &shard, std::string_view str, uint64_t hash);
+    void _grow(_Shard &shard);
+    const char *_copy_chars(_Shard &shard, std::string_view str);
+
+    std::array<_Shard, kShards> shards_;
+};
+
+} // namespace cpp_core_sandbox
@@ -0,0 +1,153 @@
+#include "sync-primitives.h"
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace cpp_core_sandbox {
+
+namespace detail {
+
+#if defined(__linux__)
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "the futex is the atomic itself");
+
+void futex_wait(std::atomic<uint32_t> &word, uint32_t expected) noexcept {
+    // EAGAIN (the value has changed) and EINTR are the callers' spurious
+    // wakeups, they re-check the word anyway
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word),
+            FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+void futex_wake_one(std::atomic<uint32_t> &word) noexcept {
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word),
+            FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+}
+
+void futex_wake_all(std::atomic<uint32_t> &word) noexcept {
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word),
+            FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+}
+
+#else
+
+void futex_wait(std::atomic<uint32_t> &word, uint32_t expected) noexcept {
+    word.wait(expected, std::memory_order_relaxed);
+}
+
+void futex_wake_one(std::atomic<uint32_t> &word) noexcept {
+    word.notify_one();
+}
+
+void futex_wake_all(std::atomic<uint32_t> &word) noexcept {
+    word.notify_all();
+}
+
+#endif
+
+} // namespace detail
+
+void adaptive_mutex::_lock_contended(void) noexcept {
+    for (int spin = 0; spin < spin_limit_; ++spin) {
+        detail::cpu_relax();
+        uint32_t expected{0};
+        if (state_.load(std::memory_order_relaxed) == 0 &&
+            state_.compare_exchange_weak(expected, 1,
+                                         std::memory_order_acquire,
+                                         std::memory_order_relaxed)) {
+            return;
+        }
+    }
+    // From now on the lock is taken as "with sleepers", as there may be
+    // other ones: the unlock after ours has to wake them
+    while (state_.exchange(2, std::memory_order_acquire) != 0) {
+        detail::futex_wait(state_, 2);
+    }
+}
+
+void ticket_lock::_wait_for(uint32_t ticket) noexcept {
+    for (int spin = 0; spin < spin_limit_;) {
+        const uint32_t serving = serving_.load(std::memory_order_acquire);
+        if (serving == ticket) {
+            return;
+        }
+        // Back off in proportion to the tickets ahead
+        for (uint32_t k = ticket - serving; k > 0 && spin < spin_limit_;
+             --k, ++spin) {
+            detail::cpu_relax();
+        }
+    }
+
+    sleepers_.fetch_add(1, std::memory_order_seq_cst);
+    for (;;) {
+        const uint32_t serving = serving_.load(std::memory_order_seq_cst);
+        if (serving == ticket) {
+            break;
+        }
+        detail::futex_wait(serving_, serving);
+    }
+    sleepers_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void rw_lock::_lock_contended(void) noexcept {
+    // Registered as waiting, new readers hold off
+    state_.fetch_add(waiting_writer, std::memory_order_relaxed);
+    for (int spin = 0;;) {
+        uint32_t current = state_.load(std::memory_order_relaxed);
+        if ((current & (writer | readers_mask)) == 0) {
+            if (state_.compare_exchange_weak(
+                    current, (current - waiting_writer) | writer,
+                    std::memory_order_acquire, std::memory_order_relaxed)) {
+                return;
+            }
+            continue;
+        }
+        if (spin < spin_limit_) {
+            ++spin;
+            detail::cpu_relax();
+        } else {
+            _sleep(current);
+        }
+    }
+}
+
+void rw_lock::_lock_shared_contended(void) noexcept {
+    for (int spin = 0;;) {
+        uint32_t current = state_.load(std::memory_order_relaxed);
+        if (_can_read(current)) {
+            if (state_.compare_exchange_weak(current, current + 1,
+                                             std::memory_order_acquire,
+                                             std::memory_order_relaxed)) {
+                return;
+            }
+            continue;
+        }
+        if (spin < spin_limit_) {
+            ++spin;
+            detail::cpu_relax();
+        } else {
+            _sleep(current);
+        }
+    }
+}
+
+void rw_lock::_wake_sleepers(void) noexcept {
+    // All of them: a sleeper still blocked re-sets the bit and sleeps again,
+    // so no one depends on a wakeup from an unlock which saw the bit clear
+    state_.fetch_and(~sleepers, std::memory_order_relaxed);
+    detail::futex_wake_all(state_);
+}
+
+void rw_lock::_sleep(uint32_t current) noexcept {
+    if ((current & sleepers) == 0 &&
+        !state_.compare_exchange_strong(current, current | sleepers,
+                                        std::memory_order_relaxed)) {
+        return; // Changed meanwhile, worth another look
+    }
+    detail::futex_wait(state_, current | sleepers);
+}
+
+} // namespace cpp_core_sandbox
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace cpp_core_sandbox {
+
+namespace detail {
+
+// Blocks while `word` holds `expected`; may return spuriously. A futex on
+// Linux, `std::atomic::wait` elsewhere
+void futex_wait(std::atomic<uint32_t> &word, uint32_t expected) noexcept;
+void futex_wake_one(std::atomic<uint32_t> &word) noexcept;
+void futex_wake_all(std::atomic<uint32_t> &word) noexcept;
+
+// The spin-wait hint: `pause` on x86, `yield` on ARM
+inline void cpu_relax(void) noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+} // namespace detail
+
+// Spin a little, then sleep.
+//
+// A critical section of a few dozen instructions is over long before a
+// thread which went to sleep for it is scheduled again. So a contended lock
+// first spins `spin_limit` rounds with `pause` in between, re-checking a
+// plain load (not hammering the line with CAS), and only then parks the
+// thread in the kernel with a futex.
+//
+// The lock word is 0 unlocked, 1 locked, 2 locked with possible sleepers:
+// `unlock` makes a syscall only in the last case (Drepper, "Futexes Are
+// Tricky"). Not fair, not recursive. Meets Lockable:
+//
+//   adaptive_mutex mutex;
+//   std::lock_guard lock{mutex};
+class adaptive_mutex {
+  public:
+    static constexpr int default_spin_limit{100};
+
+    explicit adaptive_mutex(int spin_limit = default_spin_limit) noexcept
+        : spin_limit_{spin_limit} {}
+
+    adaptive_mutex(const adaptive_mutex &) = delete;
+    adaptive_mutex &operator=(const adaptive_mutex &) = delete;
+
+    void lock(void) noexcept {
+        uint32_t expected{0};
+        if (!state_.compare_exchange_strong(expected, 1,
+                                            std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+            _lock_contended();
+        }
+    }
+
+    bool try_lock(void) noexcept {
+        uint32_t expected{0};
+        return state_.compare_exchange_strong(expected, 1,
+                                              std::memory_order_acquire,
+                                              std::memory_order_relaxed);
+    }
+
+    void unlock(void) noexcept {
+        if (state_.exchange(0, std::memory_order_release) == 2) {
+            detail::futex_wake_one(state_);
+        }
+    }
+
+  private:
+    void _lock_contended(void) noexcept;
+
+    std::atomic<uint32_t> state_{0};
+    const int spin_limit_;
+};
+
+// First come, first served.
+//
+// `lock` takes the next ticket and waits till it's served; `unlock` serves
+// the next one. No thread waits forever while the others overtake it, at the
+// price of a handover to exactly that thread, even if it's asleep or
+// preempted. The waiters spin proportionally to their place in the queue,
+// then sleep on the futex of `serving_`. Meets Lockable.
+class ticket_lock {
+  public:
+    static constexpr int default_spin_limit{100};
+
+    explicit ticket_lock(int spin_limit = default_spin_limit) noexcept
+        : spin_limit_{spin_limit} {}
+
+    ticket_lock(const ticket_lock &) = delete;
+    ticket_lock &operator=(const ticket_lock &) = delete;
+
+    void lock(void) noexcept {
+        const uint32_t ticket = next_.fetch_add(1, std::memory_order_relaxed);
+        if (serving_.load(std::memory_order_acquire) != ticket) {
+            _wait_for(ticket);
+        }
+    }
+
+    // Takes a ticket only if it would be served right away
+    bool try_lock(void) noexcept {
+        uint32_t ticket = serving_.load(std::memory_order_acquire);
+        return next_.compare_exchange_strong(ticket, ticket + 1,
+                                             std::memory_order_acquire,
+                                             std::memory_order_relaxed);
+    }
+
+    void unlock(void) noexcept {
+        // seq_cst pairs with the sleepers' increment: either they see the
+        // new ticket or this sees them
+        serving_.fetch_add(1, std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_seq_cst) != 0) {
+            // The one being served may be any of them
+            detail::futex_wake_all(serving_);
+        }
+    }
+
+  private:
+    void _wait_for(uint32_t ticket) noexcept;
+
+    // Apart, so taking a ticket doesn't disturb the spinning on `serving_`
+    alignas(64) std::atomic<uint32_t> next_{0};
+    alignas(64) std::atomic<uint32_t> serving_{0};
+    std::atomic<uint32_t> sleepers_{0};
+    const int spin_limit_;
+};
+
+// A reader-writer lock which prefers writers.
+//
+// Once a writer waits, new readers wait too: a steady stream of readers can't
+// starve the writers (which it does to std::shared_mutex in some
+// implementations). One 32-bit word holds everything, so the uncontended
+// paths are a single CAS:
+//
+//   bit 31      a writer holds the lock
+//   bits 16-30  the writers waiting
+//   bit 15      somebody sleeps on the futex, unlocking wakes them
+//   bits 0-14   the readers holding the lock
+//
+// Spins like `adaptive_mutex` before sleeping. Meets Lockable and
+// SharedLockable:
+//
+//   rw_lock lock;
+//   std::shared_lock reader{lock};
+//   std::lock_guard writer{lock};
+class rw_lock {
+  public:
+    static constexpr int default_spin_limit{100};
+
+    explicit rw_lock(int spin_limit = default_spin_limit) noexcept
+        : spin_limit_{spin_limit} {}
+
+    rw_lock(const rw_lock &) = delete;
+    rw_lock &operator=(const rw_lock &) = delete;
+
+    void lock(void) noexcept {
+        uint32_t expected{0};
+        if (!state_.compare_exchange_strong(expected, writer,
+                                            std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+            _lock_contended();
+        }
+    }
+
+    bool try_lock(void) noexcept {
+        uint32_t expected{0};
+        return state_.compare_exchange_strong(expected, writer,
+                                              std::memory_order_acquire,
+                                              std::memory_order_relaxed);
+    }
+
+    void unlock(void) noexcept {
+        const uint32_t old = state_.fetch_and(~(writer | sleepers),
+                                              std::memory_order_release);
+        if ((old & sleepers) != 0) {
+            detail::futex_wake_all(state_);
+        }
+    }
+
+    void lock_shared(void) noexcept {
+        uint32_t current = state_.load(std::memory_order_relaxed);
+        if (!_can_read(current) ||
+            !state_.compare_exchange_strong(current, current + 1,
+                                            std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+            _lock_shared_contended();
+        }
+    }
+
+    bool try_lock_shared(void) noexcept {
+        uint32_t current = state_.load(std::memory_order_relaxed);
+        while (_can_read(current)) {
+            if (state_.compare_exchange_weak(current, current + 1,
+                                             std::memory_order_acquire,
+                                             std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void unlock_shared(void) noexcept {
+        const uint32_t old = state_.fetch_sub(1, std::memory_order_release);
+        // The last reader out lets a waiting writer in
+        if ((old & readers_mask) == 1 && (old & sleepers) != 0) {
+            _wake_sleepers();
+        }
+    }
+
+  private:
+    static constexpr uint32_t writer{1u << 31};
+    static constexpr uint32_t waiting_writer{1u << 16};
+    static constexpr uint32_t waiting_mask{0x7fffu << 16};
+    static constexpr uint32_t sleepers{1u << 15};
+    static constexpr uint32_t readers_mask{sleepers - 1};
+
+    static bool _can_read(uint32_t state) noexcept {
+        return (state & (writer | waiting_mask)) == 0 &&
+               (state & readers_mask) != readers_mask;
+    }
+
+    void _lock_contended(void) noexcept;
+    void _lock_shared_contended(void) noexcept;
+    void _wake_sleepers(void) noexcept;
+
+    // Sets the sleepers bit if `state_` is still `current` and sleeps
+    void _sleep(uint32_t current) noexcept;
+
+    std::atomic<uint32_t> state_{0};
+    const int spin_limit_;
+};
+
+} // namespace cpp_core_sandbox
@@ -0,0 +1,173 @@
+// Exact accounting of copies and moves on the return and throw paths of A.
+// If a compiler or a flag change adds a copy, these tests fail.
+
+#include <gtest/gtest.h>
+
+#include <class-a.h>
+#include <ostream>
+#include <thread>
+
+#include "generators.h"
+
+using namespace cpp_core_sandbox;
+
+namespace cpp_core_sandbox {
+
+// Readable failure messages
+void PrintTo( const A::Counters& c, std::ostream* os )
+{
+    *os << "{ default_ctor: " << c.default_ctor << ", value_ctor: " << c.value_ctor
+        << ", copy_ctor: " << c.copy_ctor << ", move_ctor: " << c.move_ctor
+        << ", copy_assign: " << c.copy_assign << ", move_assign: " << c.move_assign
+        << ", dtor: " << c.dtor << " }";
+}
+
+} // namespace cpp_core_sandbox
+
+namespace {
+
+// NRVO, and the elision of a thrown local, are allowed, not required:
+// without them the local is moved out (never copied) and destroyed, i.e.
+// copies + moves grow by at most one
+void ExpectAtMostOneMove( const A::Counters& delta, const A::Counters& elided )
+{
+    auto not_elided = elided;
+    not_elided.move_ctor += 1;
+    not_elided.dtor += 1;
+    EXPECT_TRUE( delta == elided || delta == not_elided ) << ::testing::PrintToString( delta );
+}
+
+} // namespace
+
+TEST( copy_elision, nrvo_local )
+{
+    A::CountersSnapshot snapshot;
+    auto var = GenerateInstanceOfA_local();
+    ExpectAtMostOneMove( snapshot.Delta(), A::Counters{ .default_ctor = 1 } );
+}
+
+TEST( copy_elision, nrvo_after_move_from_local )
+{
+    A::CountersSnapshot snapshot;
+    auto var = GenerateInstanceOfA_local_undefined();
+    ExpectAtMostOneMove( snapshot.Delta(), A::Counters{ .default_ctor = 1, .move_ctor = 1, .dtor = 1 } );
+}
+
+TEST( copy_elision, temporary )
+{
+    A::CountersSnapshot snapshot;
+    auto var = GenerateInstanceOfA_temporary();
+    EXPECT_EQ( snapshot.Delta(), ( A::Counters{ .default_ctor = 1 } ) );
+}
+
+TEST( copy_elision, via_function_call )
+{
+    A::CountersSnapshot snapshot;
+    auto var = GenerateInstanceOfA_via_function_call();
+    EXPECT_EQ( snapshot.Delta(), ( A::Counters{ .default_ctor = 1 } ) );
+}
+
+TEST( copy_elision, xvalue_prevents_elision )
+{
+    A::CountersSnapshot snapshot;
+    auto var = GenerateInstanceOfA_via_xvalue();
+    EXPECT_EQ( snapshot.Delta(), ( A::Counters{ .default_ctor = 1, .move_ctor = 1, .dtor = 1 } ) );
+}
+
+TEST( copy_elision, destruction_is_accounted )
+{
+    A::CountersSnapshot snapshot;
+    {
+        auto var = GenerateInstanceOfA_temporary();
+    }
+    EXPECT_EQ( snapshot.Delta(), ( A::Counters{ .default_ctor = 1, .dtor = 1 } ) );
+}
+
+TEST( copy_elision, throw_prvalue_rethrow_catch_by_value_copies )
+{
+    A::CountersSnapshot snapshot;
+    try {
+        try {
+            try {
+                throw GenerateInstanceOfA_via_function_call();
+            } catch( A& ) {
+                throw;
+            }
+        } catch( A& ) {
+            throw;
+        }
+    } catch( A by_val ) {
+        // The exception object and its copy are alive
+        EXPECT_EQ( snapshot.Delta(), ( A::Counters{ .default_ctor = 1, .copy_ctor = 1 } ) );
+    }
+    EXPECT_EQ( snapshot.Delta(), ( A::Counters{ .default_ctor = 1, .copy_ctor = 1, .dtor = 2 } ) );
+}
+
+TEST( copy_elision, throw_prvalue_catch_by_value_copies )
+{
+    A::CountersSnapshot snapshot;
+    try {
+        try {
+            throw GenerateInstanceOfA_via_function_call();
+        } catch( A by_val ) {
+            throw;
+        }
+    } catch( A& ) {
+        // The copy made for the `by_val` is already destroyed
+        EXPECT_EQ( snapshot.Delta(), ( A::Counters{ .default_ctor = 1, .copy_ctor = 1, .dtor = 1 } ) );
+    }
+    EXPECT_EQ( snapshot.Delta(), ( A::Counters{ .default_ctor = 1, .copy_ctor = 1, .dtor = 2 } ) );
+}
+
+TEST( copy_elision, throw_prvalue_catch_by_reference_doesnt_copy )
+{
+    A::CountersSnapshot snapshot;
+    try {
+        throw GenerateInstanceOfA_temporary();
+    } catch( A& ) {
+        EXPECT_EQ( snapshot.Delta(), ( A::Counters{ .default_ctor = 1 } ) );
+    }
+    EXPECT_EQ( snapshot.Delta(), ( A::Counters{ .default_ctor = 1, .dtor = 1 } ) );
+}
+
+TEST( copy_elision, throw_local_lvalue_moves )
+{
+    A::CountersSnapshot snapshot;
+    try {
+        try {
+            auto local = GenerateInstanceOfA_temporary();
+            throw local;
+        } catch( A& by_ref ) {
+            throw std::move( by_ref );
+        }
+    } catch( A& ) {
+        // `local` -> the first exception object -> the second one. The first
+        // move may be elided (`local` is the exception object then), the
+        // second one, of an xvalue, may not
+        ExpectAtMostOneMove( snapshot.Delta(), A::Counters{ .default_ctor = 1, .move_ctor = 1, .dtor = 1 } );
+    }
+    ExpectAtMostOneMove( snapshot.Delta(), A::Counters{ .default_ctor = 1, .move_ctor = 1, .dtor = 2 } );
+}
+
+TEST( copy_elision, counters_are_per_thread )
+{
+    A::CountersSnapshot snapshot;
+    A::Counters other_thread_delta;
+    std::thread t{ [ &other_thread_delta ] {
+        A::CountersSnapshot thread_snapshot;
+        auto var = GenerateInstanceOfA_via_xvalue();
+        other_thread_delta = thread_snapshot.Delta();
+    } };
+    t.join();
+
+    EXPECT_EQ( other_thread_delta, ( A::Counters{ .default_ctor = 1, .move_ctor = 1, .dtor = 1 } ) );
+    EXPECT_EQ( snapshot.Delta(), A::Counters{} );
+}
+
+TEST( copy_elision, expected_factory_constructs_in_place )
+{
+    A::CountersSnapshot snapshot;
+    auto var = A::TryCreate();
+    ASSERT_TRUE( var.has_value() );
+    EXPECT_EQ( snapshot.Delta(), ( A::Counters{ .default_ctor = 1 } ) );
+}
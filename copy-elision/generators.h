@@ -0,0 +1,52 @@
+#pragma once
+
+// Functions returning an instance of A in different ways.
+// Shared by the playground and its tests (cpp-core-copy-elision.g.cpp)
+
+#include <class-a.h>
+#include <utility>
+
+namespace cpp_core_sandbox {
+
+inline A GenerateInstanceOfA_local( void )
+{
+    // Non-mandatory elision of copy/move (since C++11) operations
+
+    // In a return statement, when the operand is the name of a non-volatile object
+    // with `automatic storage duration`, which isn't a function parameter or a catch clause parameter,
+    // and which is of the same class type (ignoring cv-qualification) as the function return type.
+    // This variant of copy elision is known as NRVO, "named return value optimization".
+
+    // gcc elides copy, msvc 141 [cpp 17] maybe doesn't
+    A local;
+    return local;
+}
+
+inline A GenerateInstanceOfA_local_undefined( void )
+{
+    A local;
+    A local2{ std::move( local ) };
+
+    return local;
+}
+
+inline A GenerateInstanceOfA_temporary( void )
+{
+    // Mandatory elision of copy/move operations:
+    // In a return statement, when the operand is a prvalue of the same
+    // class type (ignoring cv-qualification) as the function return type
+    return A{};
+}
+
+inline A GenerateInstanceOfA_via_function_call( void )
+{
+    return GenerateInstanceOfA_temporary();
+}
+
+inline A GenerateInstanceOfA_via_xvalue( void )
+{
+    A local;
+    return std::move( local );              // The compiler might generate -Wpessimizing-move
+}
+
+} // namespace cpp_core_sandbox
@@ -1,6 +1,7 @@
 // Observing move semantics
 
 #include <class-a.h>
+#include <string-concat.h>
 #include <iomanip>
 #include <type_traits>
 #include <cassert>
@@ -80,6 +81,13 @@ int main( void )
 
         std::cout << "s4: " << s4 << std::endl;
         std::cout << "s5: " << s5 << std::endl;
+
+        // In a chain `s1 + s2 + s3 + ...` every `+` appends to the temporary produced by
+        // the previous one, which may reallocate several times.
+        // `concat` computes the final length first and allocates once (see string-concat.h)
+        std::string s6 = cpp_core_sandbox::concat( s1, s2, '-', 42, std::string_view{ "!" } );
+        std::string s7 = cpp_core_sandbox::concat_expr{} + s1 + s2 + '-' + 42 + "!";
+        assert( s6 == "12-42!" && s6 == s7 );
     }
 
 
@@ -0,0 +1,78 @@
+// The value category rules of the playground, checked on A's counters
+// instead of read off stdout
+
+#include <gtest/gtest.h>
+
+#include <class-a.h>
+#include <type_traits>
+#include <utility>
+
+using namespace cpp_core_sandbox;
+
+namespace {
+
+enum class Overload { lvalue_ref, rvalue_ref };
+
+struct move_or_copy {
+    static Overload fn1( const A& ) { return Overload::lvalue_ref; }
+    static Overload fn1( A&& ) { return Overload::rvalue_ref; }
+};
+
+} // namespace
+
+TEST( MoveSemantics, NamedRvalueReferenceIsAnLvalue )
+{
+    A inst1;
+    A&& ref_rval = std::move( inst1 );
+    static_assert( std::is_rvalue_reference_v< decltype( ref_rval ) > );
+
+    EXPECT_EQ( move_or_copy::fn1( inst1 ), Overload::lvalue_ref );
+    EXPECT_EQ( move_or_copy::fn1( ref_rval ), Overload::lvalue_ref );
+    EXPECT_EQ( move_or_copy::fn1( std::move( ref_rval ) ), Overload::rvalue_ref );
+    EXPECT_EQ( move_or_copy::fn1( A{} ), Overload::rvalue_ref );
+
+    A::CountersSnapshot snapshot;
+    A inst2{ inst1 };
+    A inst3{ ref_rval }; // Still a copy: the reference has a name
+    EXPECT_EQ( snapshot.Delta(), ( A::Counters{ .copy_ctor = 2 } ) );
+}
+
+TEST( MoveSemantics, XvalueMoves )
+{
+    A inst1;
+    A&& ref_rval = std::move( inst1 );
+
+    A::CountersSnapshot snapshot;
+    A inst2{ std::move( ref_rval ) };
+    A inst3{ std::move( inst2 ) };
+    EXPECT_EQ( snapshot.Delta(), ( A::Counters{ .move_ctor = 2 } ) );
+}
+
+TEST( MoveSemantics, ConstRvalueReferenceCopies )
+{
+    A inst1;
+    const A&& ref_rval_const = std::move( inst1 );
+
+    A::CountersSnapshot snapshot;
+    A inst2{ std::move( ref_rval_const ) }; // A( const A& ): constness prevents moving
+    EXPECT_EQ( snapshot.Delta(), ( A::Counters{ .copy_ctor = 1 } ) );
+}
+
+TEST( MoveSemantics, PrvalueIsNeitherCopiedNorMoved )
+{
+    A::CountersSnapshot snapshot;
+    A inst1{ A{ 1 } };
+    A inst2 = A{};
+    EXPECT_EQ( snapshot.Delta(), ( A::Counters{ .default_ctor = 1, .value_ctor = 1 } ) );
+}
+
+TEST( MoveSemantics, Assignment )
+{
+    A inst1, inst2;
+
+    A::CountersSnapshot snapshot;
+    inst1 = inst2;
+    inst1 = std::move( inst2 );
+    inst1 = A{};
+    EXPECT_EQ( snapshot.Delta(), ( A::Counters{ .default_ctor = 1, .copy_assign = 1, .move_assign = 2, .dtor = 1 } ) );
+}
@@ -0,0 +1,110 @@
+// Growing a vector to N elements by push_back, no reserve: std::vector
+// versus relocating_vector
+//
+// - A: std::vector copies it on growth (the destructor is noexcept(false)),
+//   relocating_vector moves it. The copies and moves are counted. A's move
+//   constructor allocates its payload anew, so here a move costs about as
+//   much as a copy.
+// - std::string: both move it, libstdc++'s string isn't trivially
+//   relocatable (the short string points into itself).
+// - std::unique_ptr<int>: relocating_vector reallocs, the elements aren't
+//   touched, and the large blocks are remapped rather than copied.
+// - uint64_t: trivially copyable, for reference.
+//
+// Usage: relocating-vector.bench [elements = 1e7]
+
+#include <bench-utils.h>
+#include <class-a.h>
+#include <relocating-vector.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace cpp_core_sandbox;
+using namespace cpp_core_sandbox::bench;
+
+namespace {
+
+const char *name_of(relocation kind)
+{
+    switch (kind) {
+    case relocation::bitwise:
+        return "bitwise";
+    case relocation::move:
+        return "move";
+    case relocation::copy:
+        return "copy";
+    }
+    return "?";
+}
+
+// Milliseconds of filling the vector, its destruction not included
+template <class Vector, class Make> double fill(size_t count, Make make)
+{
+    Vector values;
+    Stopwatch sw;
+    for (size_t k = 0; k < count; ++k) {
+        values.push_back(make(k));
+    }
+    const double ms = sw.elapsed_ms();
+    do_not_optimize(values);
+    return ms;
+}
+
+template <class T, class Make>
+void compare(const char *name, size_t count, Make make)
+{
+    const double standard = fill<std::vector<T>>(count, make);
+    const double relocating = fill<relocating_vector<T>>(count, make);
+    std::printf("%-22s %-8s %12.1f %12.1f %8.2fx\n", name,
+                name_of(relocation_of<T>), standard, relocating,
+                standard / relocating);
+}
+
+// The copies and moves A goes through on the way
+template <class Vector> void count_a(const char *name, size_t count)
+{
+    A::CountersSnapshot snapshot;
+    {
+        Vector values;
+        for (size_t k = 0; k < count; ++k) {
+            values.emplace_back(static_cast<int>(k));
+        }
+    }
+    const auto delta = snapshot.Delta();
+    std::printf("%-22s %14llu %14llu\n", name,
+                static_cast<unsigned long long>(delta.copy_ctor),
+                static_cast<unsigned long long>(delta.move_ctor));
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const auto count = static_cast<size_t>(size_arg(argc, argv, 1, 10'000'000));
+    A::SetTraceEnabled(false);
+
+    std::printf("%zu elements, ms\n", count);
+    std::printf("%-22s %-8s %12s %12s %9s\n", "", "relocate", "std::vector",
+                "relocating", "speedup");
+    compare<A>("A", count, [](size_t k) { return A{static_cast<int>(k)}; });
+    compare<std::string>("std::string (SSO)", count, [](size_t k) {
+        return std::string(k % 16, 'x');
+    });
+    compare<std::string>("std::string (heap)", count, [](size_t k) {
+        return std::string(32 + k % 16, 'x');
+    });
+    compare<std::unique_ptr<int>>("std::unique_ptr<int>", count, [](size_t k) {
+        return std::make_unique<int>(static_cast<int>(k));
+    });
+    compare<uint64_t>("uint64_t", count, [](size_t k) { return uint64_t{k}; });
+
+    std::printf("\nA, growth only%8s %14s %14s\n", "", "copy ctors",
+                "move ctors");
+    count_a<std::vector<A>>("std::vector", count);
+    count_a<relocating_vector<A>>("relocating_vector", count);
+    return 0;
+}
@@ -0,0 +1,136 @@
+// Concatenation of 2..16 strings: a chain of `+` versus `concat` versus
+// `std::format` (when the standard library has it)
+//
+// Usage: string-concat.bench [iterations = 1e6]
+
+#include <bench-utils.h>
+#include <string-concat.h>
+
+#include <array>
+#include <cstdio>
+#include <string>
+#include <utility>
+
+#if __has_include(<format>)
+#include <format>
+#endif
+
+using namespace cpp_core_sandbox;
+using namespace cpp_core_sandbox::bench;
+
+namespace {
+
+constexpr size_t max_operands{16};
+
+// Operands of different lengths, some fit into SSO, some don't
+std::array<std::string, max_operands> make_operands(void)
+{
+    std::array<std::string, max_operands> operands;
+    for (size_t k = 0; k < max_operands; ++k) {
+        operands[k] = std::string(4 + (k * 7) % 29, static_cast<char>('a' + k));
+    }
+    return operands;
+}
+
+template <size_t... I>
+std::string plus_chain(const std::array<std::string, max_operands> &ops,
+                       std::index_sequence<I...>)
+{
+    return (std::string{} + ... + ops[I]);
+}
+
+template <size_t... I>
+std::string concat_all(const std::array<std::string, max_operands> &ops,
+                       std::index_sequence<I...>)
+{
+    return concat(ops[I]...);
+}
+
+template <size_t... I>
+std::string_view concat_to_all(std::span<char> buffer,
+                               const std::array<std::string, max_operands> &ops,
+                               std::index_sequence<I...>)
+{
+    return concat_to(buffer, ops[I]...);
+}
+
+#if defined(__cpp_lib_format)
+template <size_t... I>
+std::string format_all(const std::array<std::string, max_operands> &ops,
+                       std::index_sequence<I...>)
+{
+    constexpr auto braces = [] {
+        std::array<char, sizeof...(I) * 2 + 1> fmt{};
+        for (size_t k = 0; k < sizeof...(I); ++k) {
+            fmt[k * 2] = '{';
+            fmt[k * 2 + 1] = '}';
+        }
+        return fmt;
+    }();
+    return std::vformat(std::string_view{braces.data(), sizeof...(I) * 2},
+                        std::make_format_args(ops[I]...));
+}
+#endif
+
+template <class Fn> double ns_per_call(uint64_t iterations, Fn &&fn)
+{
+    Stopwatch sw;
+    for (uint64_t k = 0; k < iterations; ++k) {
+        auto result = fn();
+        do_not_optimize(result);
+    }
+    return sw.elapsed_ns() / static_cast<double>(iterations);
+}
+
+template <size_t N>
+void run(uint64_t iterations, const std::array<std::string, max_operands> &ops)
+{
+    constexpr auto seq = std::make_index_sequence<N>{};
+    char buffer[max_operands * 40];
+
+    const double plus_ns =
+        ns_per_call(iterations, [&] { return plus_chain(ops, seq); });
+    const double concat_ns =
+        ns_per_call(iterations, [&] { return concat_all(ops, seq); });
+    const double buffer_ns = ns_per_call(
+        iterations, [&] { return concat_to_all(buffer, ops, seq); });
+#if defined(__cpp_lib_format)
+    const double format_ns =
+        ns_per_call(iterations, [&] { return format_all(ops, seq); });
+    std::printf("%8zu %12.1f %12.1f %12.1f %12.1f\n", N, plus_ns, concat_ns,
+                buffer_ns, format_ns);
+#else
+    std::printf("%8zu %12.1f %12.1f %12.1f %12s\n", N, plus_ns, concat_ns,
+                buffer_ns, "n/a");
+#endif
+}
+
+template <size_t... N>
+void run_all(uint64_t iterations,
+             const std::array<std::string, max_operands> &ops,
+             std::index_sequence<N...>)
+{
+    (run<N + 2>(iterations, ops), ...);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const uint64_t iterations = size_arg(argc, argv, 1, 1'000'000);
+    const auto ops = make_operands();
+
+    // Sanity check: all the approaches produce the same string
+    if (plus_chain(ops, std::make_index_sequence<max_operands>{}) !=
+        concat_all(ops, std::make_index_sequence<max_operands>{})) {
+        std::printf("MISMATCH\n");
+        return 1;
+    }
+
+    std::printf("ns per concatenation\n");
+    std::printf("%8s %12s %12s %12s %12s\n", "operands", "a + b + ..",
+                "concat", "concat_to", "std::format");
+    run_all(iterations, ops, std::make_index_sequence<max_operands - 1>{});
+
+    return 0;
+}
@@ -0,0 +1,135 @@
+// Virtual diamond versus the static (CRTP + mixins) diamond.
+//
+// Both hierarchies have the same shape and the same quiet `meth1()` payload as
+// static-diamond.h. The benchmark calls `meth1` and reads `base_field1` through
+// the most derived object and through a base view, then prints a
+// devirtualization report: object sizes and the cost of a single access.
+//
+// Usage: multiple-inheritance.bench [iterations = 1e9]
+
+#include <bench-utils.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+#include "static-diamond.h"
+
+using namespace cpp_core_sandbox::bench;
+
+namespace {
+
+// A quiet copy of the demo hierarchy from multiple-inheritance.cpp
+class Top {
+  public:
+    virtual ~Top() = default;
+    virtual std::size_t meth1(void) { return 0; }
+
+    const std::string &base_field(void) const noexcept { return base_field1; }
+
+  protected:
+    std::string base_field1;
+};
+
+class Left : virtual public Top {
+  public:
+    Left() { base_field1 = "L"; }
+    std::size_t meth1(void) override { return 1; }
+};
+
+class Right : virtual public Top {
+  public:
+    Right() { base_field1 = "R"; }
+    std::size_t meth1(void) override { return 2; }
+};
+
+class Bottom final : public Left, public Right {
+  public:
+    std::size_t meth1(void) override { return 3 + base_field1.size(); }
+};
+
+// Hide the dynamic type of the object from the optimizer, as it would be in a
+// real program where the object comes from somewhere else
+template <class T> [[gnu::noinline]] T &launder_ref(T &ref) {
+    T *ptr = &ref;
+    do_not_optimize(ptr);
+    return *ptr;
+}
+
+template <class Fn> double ns_per_iteration(uint64_t iterations, Fn &&fn) {
+    std::size_t sink{0};
+    Stopwatch sw;
+    for (uint64_t k = 0; k < iterations; ++k) {
+        sink += fn();
+        do_not_optimize(sink);
+    }
+    return sw.elapsed_ns() / static_cast<double>(iterations);
+}
+
+struct Row {
+    const char *what;
+    double virtual_ns;
+    double static_ns;
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const uint64_t iterations = size_arg(argc, argv, 1, 1'000'000'000);
+
+    Bottom vb;
+    static_diamond::Bottom sb;
+
+    Bottom &v_final = launder_ref(vb);
+    Left &v_left = launder_ref<Left>(vb);
+    Top &v_top = launder_ref<Top>(vb);
+
+    using SLeft = static_diamond::Left<static_diamond::Top<static_diamond::Bottom>>;
+    using STop = static_diamond::Top<static_diamond::Bottom>;
+    static_diamond::Bottom &s_final = launder_ref(sb);
+    SLeft &s_left = launder_ref<SLeft>(sb);
+    STop &s_top = launder_ref<STop>(sb);
+
+    const Row rows[] = {
+        {"meth1() via final object",
+         ns_per_iteration(iterations, [&] { return v_final.meth1(); }),
+         ns_per_iteration(iterations, [&] { return s_final.meth1(); })},
+        {"meth1() via Left&",
+         ns_per_iteration(iterations, [&] { return v_left.meth1(); }),
+         ns_per_iteration(iterations, [&] { return s_left.meth1(); })},
+        {"meth1() via Top&",
+         ns_per_iteration(iterations, [&] { return v_top.meth1(); }),
+         ns_per_iteration(iterations, [&] { return s_top.meth1(); })},
+        {"base_field1 via Left&",
+         ns_per_iteration(iterations,
+                          [&] { return v_left.base_field().size(); }),
+         ns_per_iteration(iterations,
+                          [&] { return s_left.base_field().size(); })},
+        {"base_field1 via Top&",
+         ns_per_iteration(iterations,
+                          [&] { return v_top.base_field().size(); }),
+         ns_per_iteration(iterations,
+                          [&] { return s_top.base_field().size(); })},
+    };
+
+    std::printf("Devirtualization report, %llu iterations per row\n\n",
+                static_cast<unsigned long long>(iterations));
+
+    std::printf("%-28s %10s %10s\n", "object size, bytes", "virtual",
+                "static");
+    std::printf("%-28s %10zu %10zu\n", "Top", sizeof(Top), sizeof(STop));
+    std::printf("%-28s %10zu %10zu\n", "Left", sizeof(Left), sizeof(SLeft));
+    std::printf("%-28s %10zu %10zu\n", "Right", sizeof(Right),
+                sizeof(static_diamond::Right<SLeft>));
+    std::printf("%-28s %10zu %10zu\n\n", "Bottom", sizeof(Bottom),
+                sizeof(static_diamond::Bottom));
+
+    std::printf("%-28s %10s %10s %8s\n", "access cost, ns", "virtual", "static",
+                "ratio");
+    for (const auto &row : rows) {
+        std::printf("%-28s %10.3f %10.3f %8.2f\n", row.what, row.virtual_ns,
+                    row.static_ns, row.virtual_ns / row.static_ns);
+    }
+
+    return 0;
+}
@@ -1,6 +1,8 @@
 #include <iostream>
 #include <string>
 
+#include "static-diamond.h"
+
 
 /*
 
@@ -84,6 +86,29 @@ public:
     }
 };
 
+void static_diamond_main( void )
+{
+    // The same diamond built from mixins (see static-diamond.h).
+    // Every view of the object dispatches to `Bottom::meth1_impl` at compile time
+    // Note: don't pull the namespace in, its `Top`/`Left`/`Right` would clash with the classes above
+    namespace sd = static_diamond;
+
+    sd::Bottom b;
+    std::cout << "static Bottom::meth1 -> " << b.meth1() << std::endl;
+
+    sd::Left< sd::Top< sd::Bottom > >& as_left = b;
+    sd::Right< sd::Left< sd::Top< sd::Bottom > > >& as_right = b;
+    std::cout << "static Left view -> " << sd::call_meth1( as_left ) << std::endl;
+    std::cout << "static Right view -> " << sd::call_meth1( as_right ) << std::endl;
+
+    // There is only one `Top` subobject, so both views read the same field ("R")
+    std::cout << "base_field1 via Left: " << as_left.base_field()
+              << "; via Right: " << as_right.base_field() << std::endl;
+
+    std::cout << "sizeof( virtual bottom ) = " << sizeof( bottom )
+              << "; sizeof( static Bottom ) = " << sizeof( sd::Bottom ) << std::endl;
+}
+
 int main( void )
 {
     bottom b;
@@ -99,5 +124,9 @@ int main( void )
     // The second important notice is that if we had invoked the constructor for `A` inside the inheritor classes, it would be only invoked in constructor of `Bottom`
     // and ignored in `Left` and `Right`.
 
+    // Compare with the static (CRTP + mixins) version of the same diamond.
+    // See multiple-inheritance.bench.cpp for the cost of both designs
+    static_diamond_main();
+
     return 0;
 }
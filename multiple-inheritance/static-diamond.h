@@ -0,0 +1,97 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <string>
+
+/*
+
+The same rhombus(diamond) as in multiple-inheritance.cpp, but without virtual
+functions and virtual bases.
+
+Instead of joining two branches at the bottom, the branches are stacked on top
+of each other as mixins. Every mixin takes its parent as a template parameter,
+so the whole chain has exactly one `Top` subobject:
+
+          Top< Bottom >
+               ^
+               |
+      Left< Top< Bottom > >
+               ^
+               |
+  Right< Left< Top< Bottom > > >
+               ^
+               |
+             Bottom
+
+`meth1()` is dispatched at compile time (CRTP): `Top` knows the final type and
+calls `meth1_impl()` of the most derived class. There is no vptr and no vbase
+offset, and every call is inlinable.
+
+Unlike the demo hierarchy, `meth1()` doesn't print anything, it returns a tag
+of the override that has been executed. That keeps it usable in a benchmark.
+
+*/
+
+namespace static_diamond {
+
+// The most derived class must provide the implementation of `meth1`
+template <class T>
+concept Meth1Capable = requires(T &t) {
+    { t.meth1_impl() } -> std::convertible_to<std::size_t>;
+};
+
+// Anything that looks like a node of the diamond: can be called and has a
+// field to read
+template <class T>
+concept DiamondNode = requires(T &t) {
+    { t.meth1() } -> std::convertible_to<std::size_t>;
+    { t.base_field() } -> std::convertible_to<const std::string &>;
+};
+
+template <class Derived> class Top {
+  public:
+    std::size_t meth1(void)
+        requires Meth1Capable<Derived>
+    {
+        return static_cast<Derived &>(*this).meth1_impl();
+    }
+
+    const std::string &base_field(void) const noexcept { return base_field1; }
+
+    // Used when the final class doesn't override `meth1`
+    std::size_t meth1_impl(void) const noexcept { return 0; }
+
+  protected:
+    Top(void) = default; // Only a part of a final class
+
+    std::string base_field1;
+};
+
+template <class Base> class Left : public Base {
+  public:
+    Left(void) { this->base_field1 = "L"; }
+
+    std::size_t meth1_impl(void) const noexcept { return 1; }
+};
+
+template <class Base> class Right : public Base {
+  public:
+    Right(void) { this->base_field1 = "R"; }
+
+    std::size_t meth1_impl(void) const noexcept { return 2; }
+};
+
+class Bottom final : public Right<Left<Top<Bottom>>> {
+  public:
+    // Left and Right views of the object share the same `base_field1`, there
+    // is no way to have two copies of it
+    std::size_t meth1_impl(void) const noexcept {
+        return 3 + base_field1.size();
+    }
+};
+
+// Call through a "base" view without any dispatch cost
+template <DiamondNode T> std::size_t call_meth1(T &node) { return node.meth1(); }
+
+} // namespace static_diamond
@@ -1,5 +1,6 @@
 ﻿#include <cassert>
 #include <chrono>
+#include <cstdint>
 #include <future>
 #include <iostream>
 #include <memory>
@@ -8,6 +9,9 @@
 #include <thread>
 #include <vector>
 
+#include <bench-utils.h>
+#include <hdr-histogram.h>
+
 using namespace std::chrono_literals;
 
 void future_promise_playground(void)
@@ -134,8 +138,53 @@ void future_promise_playground(void)
     }
 }
 
-int main(void)
+// How long a value takes from `set_value` on one thread to `get` on another.
+// Two threads ping-pong through pairs of promises, every value is the
+// steady_clock time it was set at, and the receiver records the difference
+void handoff_latency(size_t round_trips)
+{
+    using clock = std::chrono::steady_clock;
+    using cpp_core_sandbox::PerThreadHistograms;
+
+    auto now_ns = [] {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                clock::now().time_since_epoch())
+                .count());
+    };
+
+    std::vector<std::promise<uint64_t>> pings(round_trips);
+    std::vector<std::promise<uint64_t>> pongs(round_trips);
+    PerThreadHistograms latencies;
+
+    std::thread ponger{[&] {
+        auto &local = latencies.Local();
+        for (size_t k = 0; k < round_trips; ++k) {
+            const auto sent = pings[k].get_future().get();
+            local.Record(now_ns() - sent);
+            pongs[k].set_value(now_ns());
+        }
+    }};
+
+    auto &local = latencies.Local();
+    for (size_t k = 0; k < round_trips; ++k) {
+        auto pong = pongs[k].get_future();
+        pings[k].set_value(now_ns());
+        const auto sent = pong.get();
+        local.Record(now_ns() - sent);
+    }
+    ponger.join();
+
+    const auto merged = latencies.Merged();
+    merged.PrintSummary(std::cout, "promise -> future handoff");
+    merged.PrintDistribution(std::cout);
+}
+
+// Usage: multithreading-sandbox [handoff round trips = 1e4]
+int main(int argc, char** argv)
 {
     future_promise_playground();
+    handoff_latency(static_cast<size_t>(
+        cpp_core_sandbox::bench::size_arg(argc, argv, 1, 10'000)));
     return 0;
 }
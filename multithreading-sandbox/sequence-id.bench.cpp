@@ -0,0 +1,90 @@
+// Sequence numbers of A constructed on 1..64 threads
+//
+// Block size 1 is a plain shared atomic: every number is a `fetch_add` on
+// the same cache line. Larger blocks touch it once per block.
+//
+// 1. `sequence_ids::next()` alone, the cost of the counter itself.
+// 2. Constructing and destroying A, where the counter is one of the costs.
+//
+// Usage: sequence-id.bench [instances = 1e7] [max threads = 64]
+
+#include <bench-utils.h>
+#include <class-a.h>
+#include <sequence-id.h>
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace cpp_core_sandbox;
+using namespace cpp_core_sandbox::bench;
+
+namespace {
+
+constexpr int block_sizes[]{1, 64, 1024};
+
+// Runs `fn(count)` on `threads` threads, `total` iterations between them.
+// Returns nanoseconds per iteration
+template <class Fn> double run_threads(unsigned threads, size_t total, Fn fn)
+{
+    const size_t per_thread = total / threads;
+    std::vector<std::thread> workers;
+    Stopwatch sw;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&fn, per_thread] { fn(per_thread); });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    return sw.elapsed_ns() / static_cast<double>(per_thread * threads);
+}
+
+template <class Fn>
+void run_table(const char *title, size_t total, unsigned max_threads, Fn fn)
+{
+    std::printf("\n%s, %zu in total, ns each\n%8s", title, total, "threads");
+    for (const int size : block_sizes) {
+        std::printf("  block %6d", size);
+    }
+    std::printf("\n");
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        std::printf("%8u", threads);
+        for (const int size : block_sizes) {
+            A::SetSeqNoBlockSize(size);
+            std::printf("  %12.2f", run_threads(threads, total, fn));
+        }
+        std::printf("\n");
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const auto count = static_cast<size_t>(size_arg(argc, argv, 1, 10'000'000));
+    const auto max_threads = static_cast<unsigned>(size_arg(argc, argv, 2, 64));
+
+    A::SetTraceEnabled(false);
+    std::printf("%u hardware threads\n", std::thread::hardware_concurrency());
+
+    // The same counter A uses
+    run_table("sequence_ids<A>::next()", count, max_threads,
+              [](size_t n) {
+                  int last{0};
+                  for (size_t k = 0; k < n; ++k) {
+                      last = sequence_ids<A>::next();
+                  }
+                  do_not_optimize(last);
+              });
+
+    run_table("A construction", count, max_threads, [](size_t n) {
+        for (size_t k = 0; k < n; ++k) {
+            A a;
+            do_not_optimize(a);
+        }
+    });
+
+    A::SetSeqNoBlockSize(sequence_ids<A>::default_block_size);
+    return 0;
+}
@@ -0,0 +1,135 @@
+// Lock contention on 1..64 threads, for a few critical section lengths
+//
+// Every thread takes the lock, does `cs` steps of work on shared state,
+// unlocks, and does 50 steps of its own before the next round. The total
+// number of rounds is fixed and split between the threads.
+//
+// 1. Exclusive: std::mutex versus adaptive_mutex, ticket_lock and rw_lock.
+// 2. Read-mostly, 1 write in 10: std::shared_mutex versus rw_lock.
+//
+// With more threads than cores expect the ticket lock to collapse: the lock
+// goes to the next ticket even when its holder is preempted, and everybody
+// waits for the scheduler.
+//
+// Usage: sync-primitives.bench [rounds = 2e6] [max threads = 64]
+
+#include <bench-utils.h>
+#include <sync-primitives.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+using namespace cpp_core_sandbox;
+using namespace cpp_core_sandbox::bench;
+
+namespace {
+
+constexpr int cs_lengths[]{0, 20, 200};
+constexpr int private_work{50};
+
+// `steps` rounds of an LCG, the work the compiler can't skip
+inline uint64_t work(uint64_t state, int steps)
+{
+    for (int k = 0; k < steps; ++k) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        do_not_optimize(state);
+    }
+    return state;
+}
+
+// Shared state on its own line, away from the lock
+struct alignas(64) shared_state {
+    uint64_t value{0};
+};
+
+// Runs `round(state, k)` `total` times in all on `threads` threads.
+// Returns nanoseconds per round
+template <class Round>
+double run_threads(unsigned threads, size_t total, Round round)
+{
+    const size_t per_thread = total / threads;
+    std::vector<std::thread> workers;
+    Stopwatch sw;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&round, per_thread, t] {
+            uint64_t state{t};
+            for (size_t k = 0; k < per_thread; ++k) {
+                state = work(round(state, k), private_work);
+            }
+            do_not_optimize(state);
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    return sw.elapsed_ns() / static_cast<double>(per_thread * threads);
+}
+
+template <class Lock>
+double exclusive(unsigned threads, size_t total, int cs)
+{
+    Lock lock;
+    shared_state shared;
+    return run_threads(threads, total, [&](uint64_t state, size_t) {
+        std::lock_guard guard{lock};
+        shared.value = work(shared.value + state, cs);
+        return shared.value;
+    });
+}
+
+template <class Lock>
+double read_mostly(unsigned threads, size_t total, int cs)
+{
+    Lock lock;
+    shared_state shared;
+    return run_threads(threads, total, [&](uint64_t state, size_t k) {
+        if (k % 10 == 0) {
+            std::lock_guard guard{lock};
+            shared.value = work(shared.value + state, cs);
+            return shared.value;
+        }
+        std::shared_lock guard{lock};
+        return work(shared.value ^ state, cs);
+    });
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const auto total = static_cast<size_t>(size_arg(argc, argv, 1, 2'000'000));
+    const auto max_threads = static_cast<unsigned>(size_arg(argc, argv, 2, 64));
+
+    std::printf("%u hardware threads, %zu rounds, ns per round\n",
+                std::thread::hardware_concurrency(), total);
+
+    for (const int cs : cs_lengths) {
+        std::printf("\nexclusive, critical section %d steps\n", cs);
+        std::printf("%8s %12s %12s %12s %12s\n", "threads", "std::mutex",
+                    "adaptive", "ticket", "rw_lock");
+        for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+            std::printf("%8u %12.1f %12.1f %12.1f %12.1f\n", threads,
+                        exclusive<std::mutex>(threads, total, cs),
+                        exclusive<adaptive_mutex>(threads, total, cs),
+                        exclusive<ticket_lock>(threads, total, cs),
+                        exclusive<rw_lock>(threads, total, cs));
+        }
+    }
+
+    for (const int cs : cs_lengths) {
+        std::printf("\nread-mostly (10%% writes), critical section %d steps\n",
+                    cs);
+        std::printf("%8s %18s %12s\n", "threads", "std::shared_mutex",
+                    "rw_lock");
+        for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+            std::printf("%8u %18.1f %12.1f\n", threads,
+                        read_mostly<std::shared_mutex>(threads, total, cs),
+                        read_mostly<rw_lock>(threads, total, cs));
+        }
+    }
+    return 0;
+}
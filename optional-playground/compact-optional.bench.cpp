@@ -0,0 +1,71 @@
+// Scanning an array of `std::optional< int >` versus `compact_optional< int >`
+//
+// The compact variant keeps the "empty" state in the value itself (-1 here),
+// so the array is half the size and the scan moves half the bytes.
+//
+// Usage: compact-optional.bench [optionals = 1e8]
+
+#include <bench-utils.h>
+
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "compact-optional.h"
+
+using namespace cpp_core_sandbox::bench;
+
+namespace
+{
+
+template <class Optional> void run(const char* name, size_t count)
+{
+    std::vector<Optional> values(count);
+
+    // Every 10th optional is empty
+    std::mt19937 rng{42};
+    for (auto& value : values) {
+        const auto n = static_cast<int>(rng() % 1000);
+        if (n % 10 != 0) {
+            value.emplace(n);
+        }
+    }
+
+    double best_ms{0};
+    long long sum{0};
+    size_t present{0};
+    for (int pass = 0; pass < 5; ++pass) {
+        sum = 0;
+        present = 0;
+        Stopwatch sw;
+        for (const auto& value : values) {
+            if (value.has_value()) {
+                sum += *value;
+                ++present;
+            }
+        }
+        do_not_optimize(sum);
+        const double ms = sw.elapsed_ms();
+        best_ms = (pass == 0 || ms < best_ms) ? ms : best_ms;
+    }
+
+    const double bytes = static_cast<double>(count * sizeof(Optional));
+    std::printf("%-36s sizeof %2zu; %8.1f MB; scan %8.1f ms; %6.2f GB/s; "
+                "present %zu; sum %lld\n",
+                name, sizeof(Optional), bytes / 1e6, best_ms,
+                bytes / (best_ms * 1e6), present, sum);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto count = static_cast<size_t>(size_arg(argc, argv, 1, 100'000'000));
+
+    run<std::optional<int>>("std::optional< int >", count);
+    run<compact_optional<int, sentinel_niche_traits<int, -1>>>(
+        "compact_optional< int, niche = -1 >", count);
+
+    return 0;
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <cassert>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// An optional without the `has_value` flag.
+//
+// `std::optional< T >` stores a bool next to T, and with padding that often
+// doubles the size of small objects, so arrays of optionals waste half of the
+// memory bandwidth. Many types have a value which is never used as a real
+// value: a null pointer, -1 for an index, a moved-from state. Such a value (a
+// "niche") can represent the empty optional, then
+// `sizeof( compact_optional< T > ) == sizeof( T )`.
+//
+// The niche is described by the `Traits` type:
+//
+//   struct Traits {
+//       static T empty_value() noexcept;            // creates the niche value
+//       static bool is_empty(const T&) noexcept;    // detects it
+//   };
+//
+// The storage always holds an instance of T: either the real value or the niche.
+// Note the consequence: if a value is moved out and the moved-from state of T is
+// the niche itself (see `Movable`), the optional becomes empty.
+
+// Niche at a fixed value of an integral (or enum) type
+template <class T, T Sentinel> struct sentinel_niche_traits {
+    static constexpr T empty_value(void) noexcept { return Sentinel; }
+    static constexpr bool is_empty(const T& value) noexcept
+    {
+        return value == Sentinel;
+    }
+};
+
+// The default traits. There are no defaults for arbitrary types: whatever the
+// value is, it might be in use
+template <class T> struct compact_optional_traits;
+
+// Pointers use `nullptr` as the niche
+template <class T> struct compact_optional_traits<T*> {
+    static constexpr T* empty_value(void) noexcept { return nullptr; }
+    static constexpr bool is_empty(const T* value) noexcept
+    {
+        return value == nullptr;
+    }
+};
+
+template <class T, class Traits = compact_optional_traits<T>>
+class compact_optional
+{
+    static_assert(std::is_nothrow_invocable_r_v<T, decltype(&Traits::empty_value)>,
+                  "Creating the niche value must not throw");
+
+  public:
+    using value_type = T;
+
+    compact_optional(void) noexcept { _construct_empty(); }
+    compact_optional(std::nullopt_t) noexcept { _construct_empty(); }
+
+    template <class... Args>
+    explicit compact_optional(std::in_place_t, Args&&... args)
+    {
+        ::new (static_cast<void*>(&storage_.value)) T(std::forward<Args>(args)...);
+        assert(has_value() && "The niche value can't be stored");
+    }
+
+    compact_optional(const compact_optional& rh)
+    {
+        ::new (static_cast<void*>(&storage_.value)) T(rh.storage_.value);
+    }
+
+    compact_optional(compact_optional&& rh) noexcept(
+        std::is_nothrow_move_constructible_v<T>)
+    {
+        if (rh.has_value()) {
+            ::new (static_cast<void*>(&storage_.value))
+                T(std::move(rh.storage_.value));
+        } else {
+            _construct_empty();
+        }
+    }
+
+    compact_optional& operator=(std::nullopt_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    compact_optional& operator=(const compact_optional& rh)
+    {
+        if (this != &rh) {
+            if (rh.has_value()) {
+                emplace(rh.storage_.value);
+            } else {
+                reset();
+            }
+        }
+        return *this;
+    }
+
+    compact_optional& operator=(compact_optional&& rh) noexcept(
+        std::is_nothrow_move_constructible_v<T>)
+    {
+        if (this != &rh) {
+            if (rh.has_value()) {
+                emplace(std::move(rh.storage_.value));
+            } else {
+                reset();
+            }
+        }
+        return *this;
+    }
+
+    ~compact_optional() { storage_.value.~T(); }
+
+    template <class... Args> T& emplace(Args&&... args)
+    {
+        storage_.value.~T();
+        try {
+            ::new (static_cast<void*>(&storage_.value))
+                T(std::forward<Args>(args)...);
+        } catch (...) {
+            _construct_empty(); // The storage must always hold an object
+            throw;
+        }
+        assert(has_value() && "The niche value can't be stored");
+        return storage_.value;
+    }
+
+    void reset(void) noexcept
+    {
+        if (has_value()) {
+            storage_.value.~T();
+            _construct_empty();
+        }
+    }
+
+    bool has_value(void) const noexcept
+    {
+        return !Traits::is_empty(storage_.value);
+    }
+    explicit operator bool(void) const noexcept { return has_value(); }
+
+    T& value(void) &
+    {
+        _check();
+        return storage_.value;
+    }
+    const T& value(void) const&
+    {
+        _check();
+        return storage_.value;
+    }
+    T&& value(void) &&
+    {
+        _check();
+        return std::move(storage_.value);
+    }
+
+    template <class U> T value_or(U&& default_value) const&
+    {
+        return has_value() ? storage_.value
+                           : static_cast<T>(std::forward<U>(default_value));
+    }
+
+    T& operator*(void) & noexcept { return storage_.value; }
+    const T& operator*(void) const& noexcept { return storage_.value; }
+    T&& operator*(void) && noexcept { return std::move(storage_.value); }
+
+    T* operator->(void) noexcept { return &storage_.value; }
+    const T* operator->(void) const noexcept { return &storage_.value; }
+
+    friend bool operator==(const compact_optional& opt, std::nullopt_t) noexcept
+    {
+        return !opt.has_value();
+    }
+    friend bool operator!=(const compact_optional& opt, std::nullopt_t) noexcept
+    {
+        return opt.has_value();
+    }
+
+  private:
+    void _construct_empty(void) noexcept
+    {
+        ::new (static_cast<void*>(&storage_.value)) T(Traits::empty_value());
+    }
+
+    void _check(void) const
+    {
+        if (!has_value()) {
+            throw std::bad_optional_access{};
+        }
+    }
+
+    union _Storage {
+        _Storage(void) noexcept {}
+        ~_Storage() {}
+
+        T value;
+    } storage_;
+};
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <functional>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// An `std::optional`-like wrapper which never moves the value it holds unless
+// explicitly asked to.
+//
+// `std::optional` can construct the value in place only from constructor
+// arguments (`emplace`, `std::in_place`). If the value comes out of a function,
+// it is materialized as a temporary first and then moved inside. Here the
+// value can be produced by a factory: the prvalue returned from the callable
+// initializes the storage directly (guaranteed copy elision), so no move
+// happens at all.
+//
+// Monadic `and_then`/`transform`/`or_else` (C++23 in `std::optional`) are built
+// on top of that, so a chain of transformations doesn't move intermediate
+// values either.
+
+// Tag selecting the factory constructor
+struct from_factory_t {
+    explicit from_factory_t(void) = default;
+};
+inline constexpr from_factory_t from_factory{};
+
+template <class T> class inplace_optional
+{
+    static_assert(!std::is_reference_v<T>, "T can't be a reference");
+
+    // Never constructed: the bodies taking it are never instantiated
+    struct _not_copyable {};
+    using _copy_arg_t =
+        std::conditional_t<std::is_copy_constructible_v<T>,
+                           const inplace_optional&, const _not_copyable&>;
+
+  public:
+    using value_type = T;
+
+    inplace_optional(void) noexcept {}
+    inplace_optional(std::nullopt_t) noexcept {}
+
+    template <class... Args>
+    explicit inplace_optional(std::in_place_t, Args&&... args)
+    {
+        emplace(std::forward<Args>(args)...);
+    }
+
+    // Construct the value from the result of `factory()` without moving it
+    template <class F> inplace_optional(from_factory_t, F&& factory)
+    {
+        emplace_from(std::forward<F>(factory));
+    }
+
+    // Copyable if T is: otherwise this isn't a copy constructor, and the
+    // implicit one is deleted (there's a user-declared move constructor)
+    inplace_optional(_copy_arg_t rh)
+    {
+        if (rh.has_value_) {
+            emplace(*rh);
+        }
+    }
+
+    inplace_optional(inplace_optional&& rh) noexcept(
+        std::is_nothrow_move_constructible_v<T>)
+    {
+        if (rh.has_value_) {
+            emplace(std::move(*rh));
+        }
+    }
+
+    inplace_optional& operator=(std::nullopt_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    inplace_optional& operator=(_copy_arg_t rh)
+    {
+        if (this != &rh) {
+            if (rh.has_value_) {
+                emplace(*rh);
+            } else {
+                reset();
+            }
+        }
+        return *this;
+    }
+
+    inplace_optional& operator=(inplace_optional&& rh) noexcept(
+        std::is_nothrow_move_constructible_v<T>)
+    {
+        if (this != &rh) {
+            if (rh.has_value_) {
+                emplace(std::move(*rh));
+            } else {
+                reset();
+            }
+        }
+        return *this;
+    }
+
+    ~inplace_optional() { reset(); }
+
+    template <class... Args> T& emplace(Args&&... args)
+    {
+        reset();
+        T* value = ::new (static_cast<void*>(&storage_.value))
+            T(std::forward<Args>(args)...);
+        has_value_ = true;
+        return *value;
+    }
+
+    // The result of `factory()` initializes the storage directly: zero moves
+    template <class F> T& emplace_from(F&& factory)
+    {
+        static_assert(
+            std::is_same_v<std::invoke_result_t<F>, T>,
+            "The factory must return T by value (a prvalue) to be elided");
+        reset();
+        T* value = ::new (static_cast<void*>(&storage_.value))
+            T(std::invoke(std::forward<F>(factory)));
+        has_value_ = true;
+        return *value;
+    }
+
+    void reset(void) noexcept
+    {
+        if (has_value_) {
+            storage_.value.~T();
+            has_value_ = false;
+        }
+    }
+
+    bool has_value(void) const noexcept { return has_value_; }
+    explicit operator bool(void) const noexcept { return has_value_; }
+
+    T& value(void) &
+    {
+        _check();
+        return storage_.value;
+    }
+    const T& value(void) const&
+    {
+        _check();
+        return storage_.value;
+    }
+    T&& value(void) &&
+    {
+        _check();
+        return std::move(storage_.value);
+    }
+
+    T& operator*(void) & noexcept { return storage_.value; }
+    const T& operator*(void) const& noexcept { return storage_.value; }
+    T&& operator*(void) && noexcept { return std::move(storage_.value); }
+
+    T* operator->(void) noexcept { return &storage_.value; }
+    const T* operator->(void) const noexcept { return &storage_.value; }
+
+    // `f( value ) -> inplace_optional< U >`. The returned optional is a prvalue,
+    // so it's elided as well
+    template <class F> auto and_then(F&& f) &
+    {
+        return _and_then(*this, std::forward<F>(f));
+    }
+    template <class F> auto and_then(F&& f) const&
+    {
+        return _and_then(*this, std::forward<F>(f));
+    }
+    template <class F> auto and_then(F&& f) &&
+    {
+        return _and_then(std::move(*this), std::forward<F>(f));
+    }
+
+    // `f( value ) -> U`. U is constructed right inside the resulting optional
+    template <class F> auto transform(F&& f) &
+    {
+        return _transform(*this, std::forward<F>(f));
+    }
+    template <class F> auto transform(F&& f) const&
+    {
+        return _transform(*this, std::forward<F>(f));
+    }
+    template <class F> auto transform(F&& f) &&
+    {
+        return _transform(std::move(*this), std::forward<F>(f));
+    }
+
+    // `f() -> inplace_optional< T >` is only called if there is no value.
+    // Note that the existing value has to be moved (or copied) to the result
+    template <class F> inplace_optional or_else(F&& f) const&
+    {
+        return has_value_ ? *this : std::invoke(std::forward<F>(f));
+    }
+    template <class F> inplace_optional or_else(F&& f) &&
+    {
+        return has_value_ ? std::move(*this) : std::invoke(std::forward<F>(f));
+    }
+
+    friend bool operator==(const inplace_optional& opt, std::nullopt_t) noexcept
+    {
+        return !opt.has_value_;
+    }
+    friend bool operator!=(const inplace_optional& opt, std::nullopt_t) noexcept
+    {
+        return opt.has_value_;
+    }
+    friend bool operator==(std::nullopt_t, const inplace_optional& opt) noexcept
+    {
+        return !opt.has_value_;
+    }
+    friend bool operator!=(std::nullopt_t, const inplace_optional& opt) noexcept
+    {
+        return opt.has_value_;
+    }
+
+  private:
+    template <class Self, class F> static auto _and_then(Self&& self, F&& f)
+    {
+        using result_type = std::remove_cv_t<std::remove_reference_t<
+            std::invoke_result_t<F, decltype(*std::forward<Self>(self))>>>;
+        if (self.has_value_) {
+            return std::invoke(std::forward<F>(f), *std::forward<Self>(self));
+        }
+        return result_type{};
+    }
+
+    template <class Self, class F> static auto _transform(Self&& self, F&& f)
+    {
+        using result_type = std::remove_cv_t<
+            std::invoke_result_t<F, decltype(*std::forward<Self>(self))>>;
+        if (self.has_value_) {
+            auto factory = [&]() {
+                return std::invoke(std::forward<F>(f), *std::forward<Self>(self));
+            };
+            return inplace_optional<result_type>{from_factory, factory};
+        }
+        return inplace_optional<result_type>{};
+    }
+
+    void _check(void) const
+    {
+        if (!has_value_) {
+            throw std::bad_optional_access{};
+        }
+    }
+
+    // A union doesn't construct its member, so we're free to do it ourselves
+    union _Storage {
+        _Storage(void) noexcept {}
+        ~_Storage() {}
+
+        char empty;
+        T value;
+    } storage_;
+
+    bool has_value_{false};
+};
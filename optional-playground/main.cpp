@@ -3,48 +3,12 @@
 #include <iostream>
 #include <optional>
 
+#include "inplace-optional.h"
+#include "movable.h"
+
 // The example below demonstrates the wrapping a non-copyable movable object by
 // std::optional
 
-class Movable
-{
-    int n{1};
-
-  public:
-    Movable(void) = default;
-    Movable(const Movable&) = delete;
-    Movable(Movable&& rh) noexcept
-    {
-        n = rh.n + 1;
-        rh.n = -1;
-
-        std::cout << "Move constructed [" << std::hex << &rh << "] -> [" << this
-                  << std::resetiosflags(std::ios_base::basefield)
-                  << "] n = " << n << std::endl;
-    }
-    Movable& operator=(const Movable&) = delete;
-    Movable& operator=(Movable&& rh) noexcept
-    {
-        if (this != &rh) {
-            n = rh.n + 1;
-            rh.n = -1;
-
-            std::cout << "Move assigned [" << std::hex << &rh << "] -> ["
-                      << this << std::resetiosflags(std::ios_base::basefield)
-                      << "] n = " << n << std::endl;
-        }
-        return *this;
-    }
-    ~Movable()
-    {
-        if (n != -1) {
-            std::cout << "~Movable(); n = " << n << std::endl;
-        }
-    }
-
-    void print(void) const noexcept { std::cout << n << std::endl; }
-};
-
 void foo(std::optional<Movable> local_copy)
 {
     if (local_copy.has_value()) {
@@ -87,5 +51,11 @@ int main(void)
 
     foo(std::move(e));
 
+    // `inplace_optional` can take the value straight from a function result.
+    // Nothing is printed here: no moves at all
+    inplace_optional<Movable> f{from_factory, [] { return Movable(); }};
+    auto g = f.transform([](const Movable&) { return Movable(); });
+    assert(g->moves_count() == 0);
+
     return 0;
 }
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <iomanip>
+#include <iostream>
+
+// A non-copyable movable object tracing its moves.
+//
+// `n` starts at 1 and is incremented by every move, so `n - 1` is the number
+// of moves the current value went through. A moved-from instance has `n == -1`.
+class Movable
+{
+    int n{1};
+
+    // The moved-from state is used as the niche by `compact_optional`
+    friend struct MovableNicheTraits;
+    struct _MovedFrom {
+    };
+    explicit Movable(_MovedFrom) noexcept : n{-1} {}
+
+  public:
+    Movable(void) = default;
+    Movable(const Movable&) = delete;
+    Movable(Movable&& rh) noexcept
+    {
+        n = rh.n + 1;
+        rh.n = -1;
+
+        std::cout << "Move constructed [" << std::hex << &rh << "] -> [" << this
+                  << std::resetiosflags(std::ios_base::basefield)
+                  << "] n = " << n << std::endl;
+    }
+    Movable& operator=(const Movable&) = delete;
+    Movable& operator=(Movable&& rh) noexcept
+    {
+        if (this != &rh) {
+            n = rh.n + 1;
+            rh.n = -1;
+
+            std::cout << "Move assigned [" << std::hex << &rh << "] -> ["
+                      << this << std::resetiosflags(std::ios_base::basefield)
+                      << "] n = " << n << std::endl;
+        }
+        return *this;
+    }
+    ~Movable()
+    {
+        if (n != -1) {
+            std::cout << "~Movable(); n = " << n << std::endl;
+        }
+    }
+
+    void print(void) const noexcept { std::cout << n << std::endl; }
+
+    int get_n(void) const noexcept { return n; }
+    int moves_count(void) const noexcept { return n - 1; }
+};
+
+// `compact_optional< Movable, MovableNicheTraits >` treats a moved-from
+// `Movable` as an empty optional
+struct MovableNicheTraits {
+    static Movable empty_value(void) noexcept
+    {
+        return Movable{Movable::_MovedFrom{}};
+    }
+    static bool is_empty(const Movable& value) noexcept { return value.n == -1; }
+};
@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+#include "compact-optional.h"
+#include "inplace-optional.h"
+#include "movable.h"
+
+// `Movable::n - 1` is the number of moves performed on the value
+
+namespace {
+
+Movable make_movable(void) { return Movable{}; }
+
+std::optional<Movable> make_std_optional(void) { return make_movable(); }
+
+} // namespace
+
+TEST(std_optional, assignment_from_temporary_moves)
+{
+    std::optional<Movable> a;
+    a = Movable();
+    EXPECT_EQ(a->moves_count(), 1);
+
+    // A value returned from a function can't be constructed in place either
+    auto b = make_std_optional();
+    EXPECT_EQ(b->moves_count(), 1);
+
+    // `emplace` is move-free, but only when the constructor arguments are known
+    a.emplace();
+    EXPECT_EQ(a->moves_count(), 0);
+}
+
+// Copyable only if the value is
+static_assert(std::is_copy_constructible_v<inplace_optional<int>>);
+static_assert(std::is_copy_assignable_v<inplace_optional<int>>);
+static_assert(
+    !std::is_copy_constructible_v<inplace_optional<std::unique_ptr<int>>>);
+static_assert(!std::is_copy_assignable_v<inplace_optional<std::unique_ptr<int>>>);
+static_assert(
+    std::is_nothrow_move_constructible_v<inplace_optional<std::unique_ptr<int>>>);
+
+TEST(inplace_optional, in_place_construction)
+{
+    inplace_optional<Movable> a{std::in_place};
+    ASSERT_TRUE(a.has_value());
+    EXPECT_EQ(a->get_n(), 1);
+    EXPECT_EQ(a->moves_count(), 0);
+}
+
+TEST(inplace_optional, emplace_from_factory_doesnt_move)
+{
+    inplace_optional<Movable> a;
+    EXPECT_EQ(a, std::nullopt);
+
+    a.emplace_from(make_movable);
+    ASSERT_TRUE(a.has_value());
+    EXPECT_EQ(a->get_n(), 1);
+
+    inplace_optional<Movable> b{from_factory, [] { return make_movable(); }};
+    ASSERT_TRUE(b.has_value());
+    EXPECT_EQ(b->get_n(), 1);
+}
+
+TEST(inplace_optional, transform_chain_doesnt_move)
+{
+    inplace_optional<Movable> a{from_factory, make_movable};
+
+    auto result = a.transform([](const Movable& m) { return m.get_n() * 10; })
+                      .transform([](int n) {
+                          EXPECT_EQ(n, 10);
+                          return make_movable();
+                      })
+                      .transform([](Movable&& m) {
+                          EXPECT_EQ(m.get_n(), 1);
+                          return make_movable();
+                      });
+
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->get_n(), 1);
+
+    // The source is untouched
+    EXPECT_EQ(a->get_n(), 1);
+}
+
+TEST(inplace_optional, and_then_chain_doesnt_move)
+{
+    auto step = [](const Movable& m) -> inplace_optional<Movable> {
+        if (m.get_n() != 1) {
+            return std::nullopt;
+        }
+        return {from_factory, make_movable};
+    };
+
+    inplace_optional<Movable> a{from_factory, make_movable};
+    auto result = a.and_then(step).and_then(step).and_then(step);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->get_n(), 1);
+
+    // Empty optionals short-circuit the chain
+    inplace_optional<Movable> empty;
+    EXPECT_FALSE(empty.and_then(step).has_value());
+    EXPECT_FALSE(empty.transform([](Movable&) { return 1; }).has_value());
+}
+
+TEST(inplace_optional, or_else)
+{
+    inplace_optional<Movable> empty;
+    auto filled = std::move(empty).or_else([] {
+        return inplace_optional<Movable>{from_factory, make_movable};
+    });
+    ASSERT_TRUE(filled.has_value());
+    EXPECT_EQ(filled->get_n(), 1);
+}
+
+TEST(inplace_optional, moves_are_explicit)
+{
+    inplace_optional<Movable> a{std::in_place};
+    inplace_optional<Movable> b{std::move(a)};
+    ASSERT_TRUE(b.has_value());
+    EXPECT_EQ(b->moves_count(), 1);
+
+    // Like std::optional, the source keeps a moved-from value
+    ASSERT_TRUE(a.has_value());
+    EXPECT_EQ(a->get_n(), -1);
+
+    a.reset();
+    EXPECT_FALSE(a.has_value());
+    EXPECT_THROW(a.value(), std::bad_optional_access);
+}
+
+using MovableOptional = compact_optional<Movable, MovableNicheTraits>;
+
+TEST(compact_optional, movable_niche)
+{
+    static_assert(sizeof(MovableOptional) == sizeof(Movable));
+    static_assert(sizeof(std::optional<Movable>) > sizeof(Movable));
+
+    MovableOptional a;
+    EXPECT_FALSE(a.has_value());
+    EXPECT_EQ(a, std::nullopt);
+
+    a.emplace();
+    ASSERT_TRUE(a.has_value());
+    EXPECT_EQ(a->moves_count(), 0);
+
+    MovableOptional b{std::move(a)};
+    ASSERT_TRUE(b.has_value());
+    EXPECT_EQ(b->moves_count(), 1);
+
+    // Unlike std::optional, the moved-from value is the niche itself
+    EXPECT_FALSE(a.has_value());
+
+    // Stealing the value empties the optional as well
+    Movable c{std::move(*b)};
+    EXPECT_EQ(c.moves_count(), 2);
+    EXPECT_FALSE(b.has_value());
+    EXPECT_THROW(b.value(), std::bad_optional_access);
+}
+
+TEST(compact_optional, integer_niche)
+{
+    using Index = compact_optional<int, sentinel_niche_traits<int, -1>>;
+    static_assert(sizeof(Index) == sizeof(int));
+
+    Index idx;
+    EXPECT_FALSE(idx.has_value());
+    EXPECT_EQ(idx.value_or(42), 42);
+
+    idx.emplace(0);
+    ASSERT_TRUE(idx.has_value());
+    EXPECT_EQ(*idx, 0);
+
+    Index copy{idx};
+    EXPECT_EQ(copy.value(), 0);
+
+    idx = std::nullopt;
+    EXPECT_FALSE(idx.has_value());
+    copy = idx;
+    EXPECT_FALSE(copy.has_value());
+
+    using Byte = compact_optional<unsigned char,
+                                  sentinel_niche_traits<unsigned char, 0xff>>;
+    static_assert(sizeof(Byte) == 1);
+    Byte byte{std::in_place, static_cast<unsigned char>(7)};
+    EXPECT_EQ(byte.value(), 7);
+}
+
+TEST(compact_optional, pointer_niche)
+{
+    static_assert(sizeof(compact_optional<const int*>) == sizeof(const int*));
+
+    const int value{5};
+    compact_optional<const int*> ptr;
+    EXPECT_FALSE(ptr.has_value());
+
+    ptr.emplace(&value);
+    ASSERT_TRUE(ptr.has_value());
+    EXPECT_EQ(**ptr, 5);
+
+    ptr.reset();
+    EXPECT_EQ(ptr, std::nullopt);
+}
@@ -0,0 +1,138 @@
+// The count-126 scan of the traversal program over a packed_column in every
+// encoding which fits the data, versus the std::vector<int> it uses
+//
+// 1. The traversal dataset, `(++generator) % 256`: 4, 2 and 1 bytes per
+//    value (the last one is what `encode` picks).
+// 2. `120 + (++generator) % 16`, the same scan where frame of reference
+//    pays off: 4 bits per value.
+//
+// `count_equal` runs on the packed codes, `operator[]` decodes every value
+// one by one. The vectors and the columns are built one at a time, so 1e9
+// values need about 4 GB, the std::vector<int>.
+//
+// Usage: packed-column.bench [values = 1e9]
+
+#include <bench-utils.h>
+#include <packed-column.h>
+
+#include <bit>
+#include <cstdio>
+#include <vector>
+
+using namespace cpp_core_sandbox;
+using namespace cpp_core_sandbox::bench;
+
+namespace {
+
+constexpr int needle{126};
+
+struct Dataset {
+    const char *name;
+    int min;
+    int max;
+    int (*value)(size_t k);
+};
+
+const Dataset datasets[]{
+    {"(++generator) % 256", 0, 255,
+     [](size_t k) { return static_cast<int>((k + 1) % 256); }},
+    {"120 + (++generator) % 16", 120, 135,
+     [](size_t k) { return 120 + static_cast<int>((k + 1) % 16); }},
+};
+
+struct Encoding {
+    const char *name;
+    packed_encoding encoding;
+    unsigned bits;
+};
+
+constexpr Encoding encodings[]{
+    {"bytes4", packed_encoding::bytes4, 32},
+    {"bytes2", packed_encoding::bytes2, 16},
+    {"bytes1", packed_encoding::bytes1, 8},
+    {"bits4", packed_encoding::bits4, 4},
+};
+
+void print_row(const char *name, double bytes, double scan_ms, size_t count)
+{
+    std::printf("  %-18s %10.1f %10.1f %8.2f %12zu", name, bytes / (1 << 20),
+                scan_ms, bytes / 1e6 / scan_ms, count);
+}
+
+// The traversal program's loop, a plain one the compiler may vectorize.
+// Returns the count, the one the columns must match
+size_t run_vector(const Dataset &dataset, size_t size)
+{
+    std::vector<int> values(size);
+    for (size_t k = 0; k < size; ++k) {
+        values[k] = dataset.value(k);
+    }
+    Stopwatch sw;
+    size_t count{0};
+    for (const int value : values) {
+        count += value == needle;
+    }
+    do_not_optimize(count);
+    print_row("std::vector<int>", static_cast<double>(size * sizeof(int)),
+              sw.elapsed_ms(), count);
+    std::printf(" %12s\n", "-");
+    return count;
+}
+
+// False if the column counts differently from `expected` or from itself
+bool run_column(const Dataset &dataset, size_t size, const char *name,
+                packed_encoding encoding, size_t expected)
+{
+    packed_column<int> column{dataset.min, dataset.max, encoding};
+    column.reserve(size);
+    for (size_t k = 0; k < size; ++k) {
+        column.push_back(dataset.value(k));
+    }
+
+    Stopwatch sw;
+    size_t count = column.count_equal(needle);
+    do_not_optimize(count);
+    const double scan_ms = sw.elapsed_ms();
+
+    sw.restart();
+    size_t decoded{0};
+    for (size_t k = 0; k < column.size(); ++k) {
+        decoded += column[k] == needle;
+    }
+    do_not_optimize(decoded);
+    const double decode_ms = sw.elapsed_ms();
+
+    const bool matches = count == expected && decoded == expected;
+    if (!matches) {
+        std::printf("MISMATCH: %zu, %zu decoded, %zu expected\n", count,
+                    decoded, expected);
+    }
+    print_row(name, static_cast<double>(column.memory_bytes()), scan_ms,
+              count);
+    std::printf(" %12.1f\n", decode_ms);
+    return matches;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const auto size =
+        static_cast<size_t>(size_arg(argc, argv, 1, 1'000'000'000));
+
+    std::printf("%zu values, count of %d\n", size, needle);
+    int result{0};
+    for (const auto &dataset : datasets) {
+        std::printf("\n%s\n  %-18s %10s %10s %8s %12s %12s\n", dataset.name,
+                    "", "MB", "scan ms", "GB/s", "count", "decode ms");
+        const size_t expected = run_vector(dataset, size);
+        const auto range = static_cast<unsigned>(dataset.max - dataset.min);
+        for (const auto &[name, encoding, bits] : encodings) {
+            if (std::bit_width(range) <= bits &&
+                !run_column(dataset, size, name, encoding, expected)) {
+                result = 1;
+            }
+        }
+    }
+    return result;
+}
@@ -1,28 +1,32 @@
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <deque>
-#include <chrono>
 #include <algorithm>
-
-int main( void )
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <span>
+
+#include <bench-utils.h>
+#include <huge-page-allocator.h>
+#include <perf-counters.h>
+#include <segmented-vector.h>
+
+struct TraversalResult {
+    const char* name;
+    double ms;
+    std::optional< uint64_t > dtlb_misses;
+};
+
+template< class container_type, class... Args >
+std::vector< TraversalResult > run_traversals( size_t array_size, Args&&... container_args )
 {
-    // We have two random access containers in STL: `std::vector` and `std::deque`.
-    // The following code demonstrates that it doesn't matter which way you traverse a `std::array`.
-    // But on the contrary it is preferred to use iterators or `range-based for` in case of `std::deque` traversal
-    //
-    // I also found that the code compiled with GCC 11.2 performs slightly better than compiled with Clang 13.0
-    constexpr size_t array_size{ 1'000'000'000 };
-
-    // Uncomment one of:
-    using container_type = std::vector< int >;
-    // using container_type = std::deque< int >;
-    // using container_type = std::string;
-    // using container_type = std::wstring;
-
-    container_type s1;
+    container_type s1( std::forward< Args >( container_args )... );
     int generator{ 0 };
     std::generate_n( std::back_inserter( s1 ), array_size, [&generator]{ return (++generator) % 256; } );
+    std::cout << "transparent huge pages in use: " << cpp_core_sandbox::anon_huge_pages_kb() / 1024 << " MB" << std::endl;
 
     size_t count{ 0 };
     auto fn_perform_traverse_var1 = [&s1, &count] {
@@ -42,7 +46,7 @@ int main( void )
 
         // Index-based array traversal
         const auto size = s1.size();
-        for( decltype( s1 )::size_type k = 0; k < size; ++k ) {
+        for( typename container_type::size_type k = 0; k < size; ++k ) {
             if( s1.at( k ) == 126 ) {
                 ++count;
             }
@@ -70,31 +74,149 @@ int main( void )
         }
     };
 
+    // Contiguous chunks: a plain loop over each of them, which the compiler
+    // is free to vectorize. Not available for `std::deque`
+    bool has_segments{ true };
+    auto fn_perform_traverse_var5 = [&s1, &count, &has_segments] {
 
-    auto tp_start1 = std::chrono::high_resolution_clock::now();
-    fn_perform_traverse_var1();
-    auto tp_end1 = std::chrono::high_resolution_clock::now();
+        has_segments = cpp_core_sandbox::for_each_segment( s1, [&count]( auto segment ) {
+            size_t segment_count{ 0 };
+            for( const auto val : segment ) {
+                segment_count += ( val == 126 );
+            }
+            count += segment_count;
+        } );
+    };
+
+
+    // IPC and cache / TLB misses per element tell why the variants differ,
+    // the milliseconds only tell that they do
+    std::vector< TraversalResult > results;
+    auto measure = [&results, array_size]( const char* name, auto&& fn ) {
 
-    auto tp_start2 = std::chrono::high_resolution_clock::now();
-    fn_perform_traverse_var2();
-    auto tp_end2 = std::chrono::high_resolution_clock::now();
+        cpp_core_sandbox::ScopedPerfCounters probe{ name, array_size };
+        fn();
+        const auto& values = probe.Stop();
+        probe.Print( std::cout );
+        results.push_back( { name, values.elapsed_ms, values.Get( cpp_core_sandbox::PerfEvent::kDtlbMisses ) } );
+    };
+
+    measure( "#1 iterators", fn_perform_traverse_var1 );
+    measure( "#2 index, at()", fn_perform_traverse_var2 );
+    measure( "#3 range-for, copy", fn_perform_traverse_var3 );
+    measure( "#4 range-for, reference", fn_perform_traverse_var4 );
+    measure( "#5 contiguous segments", fn_perform_traverse_var5 );
+    if( !has_segments ) {
+        results.pop_back();
+    }
+
+    std::cout << count << ";" << std::endl;
+    for( size_t k = 0; k < results.size(); ++k ) {
+        std::cout << "time consumed #" << k + 1 << ": " << static_cast< int64_t >( results[ k ].ms ) << std::endl;
+    }
+
+    return results;
+}
 
-    auto tp_start3 = std::chrono::high_resolution_clock::now();
-    fn_perform_traverse_var3();
-    auto tp_end3 = std::chrono::high_resolution_clock::now();
+// Runs the traversals over `std::basic_string`, `std::vector` or `std::deque` of `value_type`,
+// with the default allocator ("4k" pages) or the huge page one. "4k+populate" is the huge page allocator with
+// regular pages, so the prefaulting is the same as with "thp+populate"
+template< template< class, class > class container_template, class value_type >
+std::vector< TraversalResult > run_with_pages( size_t array_size, std::string_view pages )
+{
+    using huge_allocator = cpp_core_sandbox::huge_page_allocator< value_type >;
+
+    if( pages == "4k" ) {
+        return run_traversals< container_template< value_type, std::allocator< value_type > > >( array_size );
+    }
+    cpp_core_sandbox::huge_page_options options;
+    options.use_hugetlb = pages.starts_with( "hugetlb" );
+    options.populate = pages.ends_with( "+populate" );
+    options.transparent_huge_pages = !pages.starts_with( "4k" );
+    auto results = run_traversals< container_template< value_type, huge_allocator > >( array_size, huge_allocator{ options } );
+
+    const auto stats = cpp_core_sandbox::get_huge_page_stats();
+    std::cout << "huge page allocations: " << ( stats.mapped_bytes >> 20 ) << " MB mapped, "
+              << ( stats.hugetlb_bytes >> 20 ) << " MB of them MAP_HUGETLB, "
+              << stats.hugetlb_fallbacks << " MAP_HUGETLB fallbacks" << std::endl;
+    return results;
+}
 
-    auto tp_start4 = std::chrono::high_resolution_clock::now();
-    fn_perform_traverse_var4();
-    auto tp_end4 = std::chrono::high_resolution_clock::now();
+template< class value_type, class allocator_type >
+using string_container = std::basic_string< value_type, std::char_traits< value_type >, allocator_type >;
 
+std::vector< TraversalResult > run_container( size_t array_size, std::string_view container, std::string_view pages )
+{
+    if( container == "vector" ) {
+        return run_with_pages< std::vector, int >( array_size, pages );
+    } else if( container == "deque" ) {
+        // Note: deque blocks are 512 bytes, too small for the huge page allocator
+        return run_with_pages< std::deque, int >( array_size, pages );
+    } else if( container == "string" ) {
+        return run_with_pages< string_container, char >( array_size, pages );
+    } else if( container == "wstring" ) {
+        return run_with_pages< string_container, wchar_t >( array_size, pages );
+    } else if( container == "segmented" ) {
+        if( pages != "4k" ) {
+            std::cerr << "segmented_vector allocates its own blocks, only 4k pages" << std::endl;
+            return {};
+        }
+        return run_traversals< cpp_core_sandbox::segmented_vector< int > >( array_size );
+    }
 
+    std::cerr << "Unknown container: " << container << std::endl;
+    return {};
+}
 
-    std::cout << count << ";" << std::endl
-              << "time consumed #1: " << std::chrono::duration_cast< std::chrono::milliseconds >( tp_end1 - tp_start1 ).count() << std::endl
-              << "time consumed #2: " << std::chrono::duration_cast< std::chrono::milliseconds >( tp_end2 - tp_start2 ).count() << std::endl
-              << "time consumed #3: " << std::chrono::duration_cast< std::chrono::milliseconds >( tp_end3 - tp_start3 ).count() << std::endl
-              << "time consumed #4: " << std::chrono::duration_cast< std::chrono::milliseconds >( tp_end4 - tp_start4 ).count() << std::endl
-    ;
+// Regular pages versus transparent huge pages, side by side
+int compare_pages( size_t array_size, std::string_view container )
+{
+    const auto regular = run_container( array_size, container, "4k" );
+    const auto huge = run_container( array_size, container, "thp" );
+    if( regular.empty() || regular.size() != huge.size() ) {
+        return 1;
+    }
+    auto per_element = [array_size]( const std::optional< uint64_t >& misses ) {
+        return misses ? static_cast< double >( *misses ) / static_cast< double >( array_size ) : -1.0;
+    };
 
+    std::printf( "\n%-26s %10s %10s %8s %14s %14s\n", "", "4k ms", "huge ms", "delta", "4k dTLB/elem", "huge dTLB/elem" );
+    for( size_t k = 0; k < regular.size(); ++k ) {
+        std::printf( "%-26s %10.1f %10.1f %+7.1f%% %14.6f %14.6f\n", regular[ k ].name, regular[ k ].ms, huge[ k ].ms,
+                     ( huge[ k ].ms / regular[ k ].ms - 1.0 ) * 100.0, per_element( regular[ k ].dtlb_misses ),
+                     per_element( huge[ k ].dtlb_misses ) );
+    }
+    std::printf( "(dTLB -1: hardware counters unavailable)\n" );
     return 0;
 }
+
+// Usage: random-access-containers-traversal [array size = 1e9] [container = vector] [pages = 4k]
+//   container: vector, deque, segmented, string, wstring
+//   pages:     4k, thp, hugetlb (each may be followed by "+populate"), compare (4k versus thp)
+int main( int argc, char** argv )
+{
+    // We have two random access containers in STL: `std::vector` and `std::deque`.
+    // The following code demonstrates that it doesn't matter which way you traverse a `std::array`.
+    // But on the contrary it is preferred to use iterators or `range-based for` in case of `std::deque` traversal
+    //
+    // `cpp_core_sandbox::segmented_vector` is a deque with large power-of-two blocks: the index is split with
+    // a shift and a mask, and every block is a contiguous span for variant #5
+    //
+    // With 4 KB pages a scan over gigabytes misses the TLB every 1024 ints. `huge_page_allocator` maps
+    // the storage with 2 MB pages
+    //
+    // I also found that the code compiled with GCC 11.2 performs slightly better than compiled with Clang 13.0
+    const size_t array_size{ cpp_core_sandbox::bench::size_arg( argc, argv, 1, 1'000'000'000 ) };
+    const std::string_view container{ argc > 2 ? argv[ 2 ] : "vector" };
+    const std::string_view pages{ argc > 3 ? argv[ 3 ] : "4k" };
+
+    if( pages == "compare" ) {
+        return compare_pages( array_size, container );
+    }
+    const auto kind = pages.substr( 0, pages.find( '+' ) );
+    if( ( kind != "4k" && kind != "thp" && kind != "hugetlb" ) || ( kind != pages && !pages.ends_with( "+populate" ) ) ) {
+        std::cerr << "Unknown pages: " << pages << std::endl;
+        return 1;
+    }
+    return run_container( array_size, container, pages ).empty() ? 1 : 0;
+}
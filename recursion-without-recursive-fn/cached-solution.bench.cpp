@@ -0,0 +1,164 @@
+// Memoized removeInvalidParentheses on a Zipf-distributed stream of inputs
+//
+// `distinct` random expressions are ranked, and every request picks rank k
+// with probability proportional to 1/k: a few inputs repeat all the time,
+// most of them rarely. Pairs of neighbouring ranks differ only in letters,
+// so they share the canonical form and the cached result.
+//
+// Solution2 without a cache versus CachedSolution with a small and a large
+// ResultsCache, all the threads sharing one.
+//
+// Usage: cached-solution.bench [requests = 1e6] [distinct = 1e5]
+//                              [threads = cores]
+
+#include <bench-utils.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cached-solution.h"
+
+using namespace cpp_core_sandbox::bench;
+
+namespace {
+
+std::vector<std::string> make_inputs(size_t distinct)
+{
+    std::mt19937 rng{42};
+    std::vector<std::string> inputs;
+    inputs.reserve(distinct);
+    while (inputs.size() < distinct) {
+        std::string str;
+        const auto size = 8 + rng() % 13;
+        for (size_t c = 0; c < size; ++c) {
+            const auto dice = rng() % 5;
+            str += dice == 0 ? static_cast<char>('a' + rng() % 26)
+                             : (dice < 3 ? '(' : ')');
+        }
+        inputs.push_back(str);
+
+        // The same with other letters
+        for (auto &c : str) {
+            if (c != '(' && c != ')') {
+                c = static_cast<char>('a' + rng() % 26);
+            }
+        }
+        inputs.push_back(std::move(str));
+    }
+    inputs.resize(distinct);
+    return inputs;
+}
+
+// Indices of the inputs, Zipf with the exponent 1
+std::vector<uint32_t> make_requests(size_t count, size_t distinct)
+{
+    std::vector<double> cdf(distinct);
+    double sum{0};
+    for (size_t k = 0; k < distinct; ++k) {
+        sum += 1.0 / static_cast<double>(k + 1);
+        cdf[k] = sum;
+    }
+
+    std::mt19937_64 rng{7};
+    std::uniform_real_distribution<double> uniform{0.0, sum};
+    std::vector<uint32_t> requests(count);
+    for (auto &request : requests) {
+        const auto it = std::lower_bound(cdf.begin(), cdf.end(), uniform(rng));
+        const auto rank = static_cast<size_t>(it - cdf.begin());
+        request = static_cast<uint32_t>(std::min(rank, distinct - 1));
+    }
+    return requests;
+}
+
+// Returns requests per second
+template <class MakeSolution>
+double run(const std::vector<std::string> &inputs,
+           const std::vector<uint32_t> &requests, unsigned threads,
+           MakeSolution make_solution)
+{
+    std::vector<std::thread> workers;
+    Stopwatch sw;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            auto solution = make_solution();
+            size_t results{0};
+            for (size_t k = t; k < requests.size(); k += threads) {
+                results += solution
+                               .removeInvalidParentheses(inputs[requests[k]])
+                               .size();
+            }
+            do_not_optimize(results);
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    return static_cast<double>(requests.size()) / (sw.elapsed_ms() / 1e3);
+}
+
+// The cached results must be the same as computed from scratch
+bool verify(const std::vector<std::string> &inputs, size_t count)
+{
+    ResultsCache cache{1 << 20};
+    CachedSolution<> cached{cache};
+    Solution2<> plain;
+    for (size_t k = 0; k < std::min(count, inputs.size()); ++k) {
+        auto expected = plain.removeInvalidParentheses(inputs[k]);
+        auto actual = cached.removeInvalidParentheses(inputs[k]);
+        std::sort(expected.begin(), expected.end());
+        std::sort(actual.begin(), actual.end());
+        if (expected != actual) {
+            std::printf("MISMATCH for %s\n", inputs[k].c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const auto count = static_cast<size_t>(size_arg(argc, argv, 1, 1'000'000));
+    const auto distinct = std::max<size_t>(
+        2, static_cast<size_t>(size_arg(argc, argv, 2, 100'000)));
+    const auto threads = static_cast<unsigned>(size_arg(
+        argc, argv, 3, std::max(1u, std::thread::hardware_concurrency())));
+
+    const auto inputs = make_inputs(distinct);
+    const auto requests = make_requests(count, distinct);
+    if (!verify(inputs, 2000)) {
+        return 1;
+    }
+
+    std::printf("%zu requests of %zu distinct inputs (Zipf), %u threads\n",
+                count, distinct, threads);
+    std::printf("%-24s %12s %8s %10s %10s %10s\n", "", "requests/s",
+                "hits", "entries", "evictions", "cache MB");
+
+    const double plain = run(inputs, requests, threads, [] {
+        return Solution2<std::deque, cpp_core_sandbox::flat_string_set>{};
+    });
+    std::printf("%-24s %12.0f\n", "Solution2, no cache", plain);
+
+    for (const size_t capacity : {size_t{1} << 20, size_t{64} << 20}) {
+        ResultsCache cache{capacity};
+        const double cached = run(inputs, requests, threads, [&cache] {
+            return CachedSolution<
+                Solution2<std::deque, cpp_core_sandbox::flat_string_set>>{
+                cache};
+        });
+        const auto stats = cache.get_stats();
+        char name[32];
+        std::snprintf(name, sizeof(name), "cached, %zu MB", capacity >> 20);
+        std::printf("%-24s %12.0f %7.1f%% %10zu %10llu %10.1f\n", name, cached,
+                    stats.hit_ratio() * 100.0, stats.entries,
+                    static_cast<unsigned long long>(stats.evictions),
+                    static_cast<double>(stats.bytes) / (1 << 20));
+    }
+    return 0;
+}
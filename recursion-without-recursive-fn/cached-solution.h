@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <clock-cache.h>
+
+#include "solutions.h"
+
+// Estimates the memory of a cached result: the strings and their headers
+struct ResultsWeigher {
+    size_t operator()(const std::vector<std::string> &results) const noexcept
+    {
+        size_t bytes{sizeof(results)};
+        for (const auto &str : results) {
+            bytes += sizeof(str) + str.capacity();
+        }
+        return bytes;
+    }
+};
+
+// Results of `removeInvalidParentheses` shared by the threads
+using ResultsCache =
+    cpp_core_sandbox::clock_cache<std::vector<std::string>, ResultsWeigher>;
+
+// Memoizes a solution across calls.
+//
+// Only the parentheses are ever removed, every other character stays where
+// it is. So the input is solved in its canonical form, where each run of
+// other characters is collapsed into a single placeholder:
+//
+//   "(a)bc)(" -> "(*)*)("  -> { "(*)*" } -> { "(a)bc" }
+//   "(x)y)("  -> "(*)*)("  -> the same cached result -> { "(x)y" }
+//
+// The placeholders of a result are expanded back into the runs of the input,
+// in order: a result keeps every one of them.
+//
+// The cache is shared and thread-safe, the instance is not (the solver isn't):
+// one per thread.
+template <class Solver = Solution2<>> class CachedSolution
+{
+  public:
+    explicit CachedSolution(ResultsCache &cache) : cache_{cache} {}
+
+    std::vector<std::string> removeInvalidParentheses(std::string s)
+    {
+        _canonicalize(s);
+        if (const auto cached = cache_.find(key_)) {
+            return _expand(*cached, s);
+        }
+        auto results = std::make_shared<const std::vector<std::string>>(
+            solver_.removeInvalidParentheses(key_));
+        cache_.insert(key_, results);
+        return _expand(*results, s);
+    }
+
+    // The placeholder of a run of characters other than parentheses
+    static constexpr char kPlaceholder{'*'};
+
+  private:
+    void _canonicalize(const std::string &s)
+    {
+        key_.clear();
+        runs_.clear();
+        for (size_t pos = 0; pos < s.size();) {
+            if (s[pos] == '(' || s[pos] == ')') {
+                key_ += s[pos++];
+                continue;
+            }
+            const size_t start = pos;
+            while (pos < s.size() && s[pos] != '(' && s[pos] != ')') {
+                ++pos;
+            }
+            key_ += kPlaceholder;
+            runs_.emplace_back(start, pos - start);
+        }
+    }
+
+    std::vector<std::string> _expand(const std::vector<std::string> &results,
+                                     const std::string &s) const
+    {
+        std::vector<std::string> expanded;
+        expanded.reserve(results.size());
+        for (const auto &result : results) {
+            std::string str;
+            str.reserve(s.size());
+            size_t run{0};
+            for (const char c : result) {
+                if (c == kPlaceholder) {
+                    str.append(s, runs_[run].first, runs_[run].second);
+                    ++run;
+                } else {
+                    str += c;
+                }
+            }
+            expanded.push_back(std::move(str));
+        }
+        return expanded;
+    }
+
+    ResultsCache &cache_;
+    Solver solver_;
+    std::string key_;                             // Canonical form of `s`
+    std::vector<std::pair<size_t, size_t>> runs_; // Offset and size in `s`
+};
@@ -0,0 +1,135 @@
+// The sets of strings of the solutions: `std::unordered_set` versus
+// `flat_string_set`, both probed with string_view
+//  1. inserts, lookups of present and absent strings;
+//  2. the solutions with either set.
+//
+// Usage: flat-hash-set.bench [strings = 1e6] [solve repetitions = 5]
+
+#include <bench-utils.h>
+#include <flat-hash-set.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "solutions.h"
+
+using namespace cpp_core_sandbox;
+using namespace cpp_core_sandbox::bench;
+
+namespace {
+
+// Strings like the solutions produce: parentheses with a few letters
+std::vector<std::string> make_strings(size_t count, std::mt19937 &rng)
+{
+    std::vector<std::string> strings(count);
+    for (auto &str : strings) {
+        str.resize(16 + rng() % 24);
+        for (auto &ch : str) {
+            const auto dice = rng() % 8;
+            ch = dice == 0 ? 'a' : (dice < 5 ? '(' : ')');
+        }
+    }
+    return strings;
+}
+
+template <class Set>
+void bench_set(const char *name, const std::vector<std::string> &present,
+               const std::vector<std::string> &absent)
+{
+    Set set;
+    Stopwatch sw;
+    for (const auto &str : present) {
+        set.insert(str);
+    }
+    const double insert_ns = sw.elapsed_ns() / static_cast<double>(present.size());
+
+    // Probed through a scratch buffer, as the solutions do
+    std::string scratch;
+    size_t found{0};
+    sw.restart();
+    for (const auto &str : present) {
+        scratch.assign(str);
+        found += set.find(std::string_view{scratch}) != set.end() ? 1 : 0;
+    }
+    const double hit_ns = sw.elapsed_ns() / static_cast<double>(present.size());
+
+    sw.restart();
+    for (const auto &str : absent) {
+        scratch.assign(str);
+        found += set.find(std::string_view{scratch}) != set.end() ? 1 : 0;
+    }
+    const double miss_ns = sw.elapsed_ns() / static_cast<double>(absent.size());
+    do_not_optimize(found);
+
+    std::printf("%-24s %10.1f %10.1f %10.1f %10zu\n", name, insert_ns, hit_ns,
+                miss_ns, set.size());
+}
+
+template <class Solution>
+double ms_per_solve(std::string_view input, uint64_t repetitions,
+                    std::vector<std::string> &result)
+{
+    Solution solution;
+    Stopwatch sw;
+    for (uint64_t k = 0; k < repetitions; ++k) {
+        result = solution.removeInvalidParentheses(std::string{input});
+        do_not_optimize(result);
+    }
+    std::sort(result.begin(), result.end());
+    return sw.elapsed_ms() / static_cast<double>(repetitions);
+}
+
+template <template <template <class> class, class> class Solution>
+bool bench_solution(const char *name, std::string_view input,
+                    uint64_t repetitions)
+{
+    std::vector<std::string> unordered_result;
+    std::vector<std::string> flat_result;
+    const double unordered_ms =
+        ms_per_solve<Solution<std::deque, unordered_string_set>>(
+            input, repetitions, unordered_result);
+    const double flat_ms = ms_per_solve<Solution<std::deque, flat_string_set>>(
+        input, repetitions, flat_result);
+    std::printf("%-10s %-36.*s %12.3f %12.3f %8.2f\n", name,
+                static_cast<int>(input.size()), input.data(), unordered_ms,
+                flat_ms, unordered_ms / flat_ms);
+    return unordered_result == flat_result;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const size_t count = size_arg(argc, argv, 1, 1'000'000);
+    const uint64_t repetitions = size_arg(argc, argv, 2, 5);
+
+    std::mt19937 rng{42};
+    const auto present = make_strings(count, rng);
+    const auto absent = make_strings(count, rng);
+
+    std::printf("1. ns per operation, string_view lookups\n");
+    std::printf("%-24s %10s %10s %10s %10s\n", "set", "insert", "hit", "miss",
+                "size");
+    bench_set<unordered_string_set>("std::unordered_set", present, absent);
+    bench_set<flat_string_set>("flat_string_set", present, absent);
+
+    std::printf("\n2. ms per solve\n");
+    std::printf("%-10s %-36s %12s %12s %8s\n", "solution", "input",
+                "unordered", "flat", "ratio");
+    bool same = bench_solution<Solution1>("Solution1", ")((())))))()(((l((((",
+                                          repetitions);
+    same &= bench_solution<Solution2>("Solution2", ")((())))))()(((l((((",
+                                      repetitions);
+    same &= bench_solution<Solution2>(
+        "Solution2", "((()((()(()a)((()()(()((()a)())", repetitions);
+    if (!same) {
+        std::printf("MISMATCH\n");
+        return 1;
+    }
+
+    return 0;
+}
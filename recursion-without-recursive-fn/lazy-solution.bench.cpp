@@ -0,0 +1,137 @@
+// Solution2 versus LazySolution2: the time and the heap until the first
+// result, and for all of them
+//
+// Solution2 returns when it has everything; its heap is measured right then:
+// the memoized candidates and the results (the queue is empty by then, so
+// its peak was higher). LazySolution2 is measured when the first result is
+// in the caller's hands, and then pulled to the end.
+//
+// Usage: lazy-solution.bench [repetitions = 20]
+
+#include <bench-utils.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "lazy-solution.h"
+#include "solutions.h"
+
+using namespace cpp_core_sandbox::bench;
+
+namespace {
+
+// clang-format off
+constexpr std::string_view inputs[]{
+    "(((((((((((((((((((((((((((((((((((aaaaa",
+    ")((())))))()(((l((((",
+    ")()()(a)((()(((a)()",
+    "((()((()(()a)((()()(()((()a)())",
+};
+// clang-format on
+
+// Bytes malloc has handed out and not got back, 0 if unknown
+size_t heap_in_use(void)
+{
+#if defined(__GLIBC__)
+    const auto info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+double kb_since(size_t before)
+{
+    const size_t now = heap_in_use();
+    return now > before ? static_cast<double>(now - before) / 1024.0 : 0.0;
+}
+
+// The same results, in any order
+bool verify(size_t count)
+{
+    std::mt19937 rng{3};
+    Solution2<> eager;
+    LazySolution2<> lazy;
+    for (size_t k = 0; k < count; ++k) {
+        std::string str;
+        const auto size = 4 + rng() % 17;
+        for (size_t c = 0; c < size; ++c) {
+            const auto dice = rng() % 5;
+            str += dice == 0 ? 'a' : (dice < 3 ? '(' : ')');
+        }
+        auto expected = eager.removeInvalidParentheses(str);
+        std::vector<std::string> actual;
+        for (auto &result : lazy.removeInvalidParentheses(str)) {
+            actual.push_back(std::move(result));
+        }
+        std::sort(expected.begin(), expected.end());
+        std::sort(actual.begin(), actual.end());
+        if (expected != actual) {
+            std::printf("MISMATCH for %s\n", str.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const auto repetitions = size_arg(argc, argv, 1, 20);
+    if (!verify(2000)) {
+        return 1;
+    }
+
+    std::printf("%-32s %8s | %10s %10s | %10s %10s %10s\n", "", "results",
+                "eager ms", "eager KB", "first ms", "first KB", "lazy ms");
+    for (const auto input : inputs) {
+        size_t results{0};
+        double eager_ms{0};
+        double eager_kb{0};
+        double first_ms{0};
+        double first_kb{0};
+        double lazy_ms{0};
+        for (uint64_t k = 0; k < repetitions; ++k) {
+            {
+                const size_t before = heap_in_use();
+                Solution2<> eager;
+                Stopwatch sw;
+                auto result =
+                    eager.removeInvalidParentheses(std::string{input});
+                eager_ms += sw.elapsed_ms();
+                eager_kb += kb_since(before);
+                results = result.size();
+            }
+            {
+                const size_t before = heap_in_use();
+                LazySolution2<> lazy;
+                Stopwatch sw;
+                auto generator =
+                    lazy.removeInvalidParentheses(std::string{input});
+                auto it = generator.begin();
+                first_ms += sw.elapsed_ms();
+                first_kb += kb_since(before);
+                do_not_optimize(*it);
+                while (it != generator.end()) {
+                    ++it;
+                }
+                lazy_ms += sw.elapsed_ms();
+            }
+        }
+        const auto n = static_cast<double>(repetitions);
+        std::printf("%-32.*s %8zu | %10.3f %10.1f | %10.4f %10.1f %10.3f\n",
+                    static_cast<int>(input.size()), input.data(), results,
+                    eager_ms / n, eager_kb / n, first_ms / n, first_kb / n,
+                    lazy_ms / n);
+    }
+    return 0;
+}
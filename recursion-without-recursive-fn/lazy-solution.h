@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <generator.h>
+
+#include "parentheses.h"
+#include "solutions.h"
+
+// Solution2 handing out the results one by one, as they are found.
+//
+//   LazySolution2<> sol;
+//   for (auto &result : sol.removeInvalidParentheses(s)) {
+//       if (good_enough(result)) break; // The search stops here
+//   }
+//
+// Solution2 goes breadth first: it finds a result only after it has
+// expanded every shorter candidate, and keeps all of them till it returns.
+// Here the search goes depth first, a real stack instead of a queue, so the
+// first result comes after `min_mods_req` removals. No result set either:
+// the candidates are memoized, so each of them, a result included, is
+// reached once.
+//
+// The results are the same, in a different order. The solution must outlive
+// the generator, and runs one search at a time.
+template <class Set = unordered_string_set> class LazySolution2
+{
+    struct _RecursionContext {
+        size_t start_from{0};
+        std::string modified_string;
+    };
+
+    Set already_visited_;
+    std::string candidate_; // Reused, so probing the set doesn't allocate
+
+  public:
+    cpp_core_sandbox::generator<std::string>
+    removeInvalidParentheses(std::string s)
+    {
+        already_visited_.clear();
+
+        auto min_mods_req = parentheses::find_min_modifications_required(s);
+        if (0 == min_mods_req) {
+            co_yield s;
+            co_return;
+        }
+
+        std::vector<_RecursionContext> _stack;
+        _stack.push_back(_RecursionContext{0, s});
+        while (!_stack.empty()) {
+            auto ctx = std::move(_stack.back());
+            _stack.pop_back();
+
+            // a. Deep enough, a result or a dead end
+            auto modifications_count = s.size() - ctx.modified_string.size();
+            if (modifications_count == min_mods_req) {
+                if (parentheses::is_well_formed_fast(ctx.modified_string)) {
+                    co_yield std::move(ctx.modified_string);
+                }
+                continue;
+            }
+
+            // b. One more removal, in the same way as Solution2. Pushed in
+            // reverse, so the leftmost removal is tried first
+            const size_t first = _stack.size();
+            for (size_t pos = ctx.start_from; pos < ctx.modified_string.size();
+                 ++pos) {
+
+                if (ctx.modified_string[pos] != '(' &&
+                    ctx.modified_string[pos] != ')') {
+                    continue;
+                }
+
+                candidate_.assign(ctx.modified_string, 0, pos);
+                candidate_.append(ctx.modified_string, pos + 1);
+
+                if (already_visited_.find(std::string_view{candidate_}) ==
+                    already_visited_.end()) {
+                    already_visited_.insert(candidate_);
+                    _stack.push_back(_RecursionContext{pos, candidate_});
+                }
+            }
+            std::reverse(_stack.begin() + static_cast<std::ptrdiff_t>(first),
+                         _stack.end());
+        }
+    }
+};
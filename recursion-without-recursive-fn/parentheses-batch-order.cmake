@@ -0,0 +1,43 @@
+# The batch driver writes the results in the input order, whatever the
+# number of workers: the outputs with 1 and 4 threads must be identical.
+# 20000 lines make a few batches, so the order is restored across batch
+# boundaries.
+#
+#   cmake -DBATCH=<parentheses-batch> -DWORK_DIR=<dir> -P parentheses-batch-order.cmake
+
+set( input ${WORK_DIR}/parentheses-batch-order.in )
+
+execute_process( COMMAND ${BATCH} --generate 20000
+                 OUTPUT_FILE ${input} RESULT_VARIABLE status )
+if (NOT status EQUAL 0)
+    message( FATAL_ERROR "--generate failed: ${status}" )
+endif()
+
+foreach( threads 1 4 )
+    execute_process( COMMAND ${BATCH} -j ${threads} -o ${WORK_DIR}/parentheses-batch-order.j${threads} ${input}
+                     RESULT_VARIABLE status )
+    if (NOT status EQUAL 0)
+        message( FATAL_ERROR "-j ${threads} failed: ${status}" )
+    endif()
+endforeach()
+
+# A line per input line
+function( count_lines file result )
+    file( READ ${file} text )
+    string( REGEX REPLACE "[^\n]" "" newlines "${text}" )
+    string( LENGTH "${newlines}" count )
+    set( ${result} ${count} PARENT_SCOPE )
+endfunction()
+
+count_lines( ${input} input_count )
+count_lines( ${WORK_DIR}/parentheses-batch-order.j1 output_count )
+if (NOT input_count EQUAL output_count)
+    message( FATAL_ERROR "${input_count} input lines, ${output_count} output lines" )
+endif()
+
+execute_process( COMMAND ${CMAKE_COMMAND} -E compare_files
+                 ${WORK_DIR}/parentheses-batch-order.j1 ${WORK_DIR}/parentheses-batch-order.j4
+                 RESULT_VARIABLE status )
+if (NOT status EQUAL 0)
+    message( FATAL_ERROR "the outputs of -j 1 and -j 4 differ" )
+endif()
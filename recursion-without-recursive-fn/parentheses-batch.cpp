@@ -0,0 +1,430 @@
+// Batch driver: removeInvalidParentheses over newline-delimited inputs
+//
+// The input is read in large blocks and cut into batches of whole lines.
+// Worker threads solve the batches with their own long-lived solver, so the
+// capacity of its sets survives from one line to the next. Solved batches go
+// to a writer which restores the input order and writes through a large
+// buffer. For every input line one output line is written: the results,
+// sorted and separated by tabs.
+//
+// Usage: parentheses-batch [options] [input file, '-' for stdin (default)]
+//   -o <file>        the output file (default: stdout)
+//   -j <threads>     worker threads (default: all cores)
+//   --generate <n>   print <n> random expressions and exit
+//   --synthetic <n>  solve <n> random expressions instead of reading the input
+//   --scaling        solve the input with 1, 2, 4, ... all cores and report
+//                    lines/s; the output is discarded
+
+#include <bench-utils.h>
+#include <flat-hash-set.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <semaphore>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "solutions.h"
+
+using namespace cpp_core_sandbox;
+
+namespace {
+
+constexpr size_t block_size{1 << 20}; // A single read
+constexpr size_t batch_size{1 << 16}; // A unit of work
+
+struct Options {
+    const char *input{"-"};
+    const char *output{nullptr};
+    unsigned threads{std::max(1u, std::thread::hardware_concurrency())};
+    uint64_t generate{0};
+    uint64_t synthetic{0};
+    bool scaling{false};
+};
+
+struct Batch {
+    uint64_t seq{0};
+    std::string text; // Whole lines, each ends with '\n'
+    std::string output;
+    uint64_t lines{0};
+};
+
+// Bounded by the number of batches in flight, see `run_pipeline`
+class BatchQueue
+{
+  public:
+    void Push(std::unique_ptr<Batch> batch)
+    {
+        {
+            std::lock_guard lock{mutex_};
+            batches_.push_back(std::move(batch));
+        }
+        not_empty_.notify_one();
+    }
+
+    // nullptr when closed and drained
+    std::unique_ptr<Batch> Pop(void)
+    {
+        std::unique_lock lock{mutex_};
+        not_empty_.wait(lock, [this] { return closed_ || !batches_.empty(); });
+        if (batches_.empty()) {
+            return nullptr;
+        }
+        auto batch = std::move(batches_.front());
+        batches_.pop_front();
+        return batch;
+    }
+
+    void Close(void)
+    {
+        {
+            std::lock_guard lock{mutex_};
+            closed_ = true;
+        }
+        not_empty_.notify_all();
+    }
+
+  private:
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::deque<std::unique_ptr<Batch>> batches_;
+    bool closed_{false};
+};
+
+// Writes the batches in the order of `seq`, whatever order they come in
+class OrderedWriter
+{
+  public:
+    explicit OrderedWriter(FILE *out) : out_(out) {}
+
+    void Put(std::unique_ptr<Batch> batch)
+    {
+        {
+            std::lock_guard lock{mutex_};
+            pending_.emplace(batch->seq, std::move(batch));
+        }
+        ready_.notify_one();
+    }
+
+    void Finish(uint64_t batches)
+    {
+        {
+            std::lock_guard lock{mutex_};
+            total_ = batches;
+        }
+        ready_.notify_one();
+    }
+
+    // Runs in its own thread; `written` is signalled for every batch written
+    uint64_t Run(std::counting_semaphore<> &written)
+    {
+        uint64_t lines{0};
+        for (uint64_t next = 0;; ++next) {
+            std::unique_ptr<Batch> batch;
+            {
+                std::unique_lock lock{mutex_};
+                ready_.wait(lock, [this, next] {
+                    return next == total_ || pending_.count(next) != 0;
+                });
+                if (next == total_) {
+                    break;
+                }
+                auto it = pending_.find(next);
+                batch = std::move(it->second);
+                pending_.erase(it);
+            }
+            std::fwrite(batch->output.data(), 1, batch->output.size(), out_);
+            lines += batch->lines;
+            written.release();
+        }
+        std::fflush(out_);
+        return lines;
+    }
+
+  private:
+    FILE *out_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::map<uint64_t, std::unique_ptr<Batch>> pending_;
+    uint64_t total_{UINT64_MAX};
+};
+
+using Solver = Solution2<std::deque, flat_string_set>;
+
+void solve_batch(Solver &solver, Batch &batch)
+{
+    std::string_view text{batch.text};
+    while (!text.empty()) {
+        const auto eol = text.find('\n');
+        auto line = text.substr(0, eol);
+        text.remove_prefix(eol + 1);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+
+        auto results = solver.removeInvalidParentheses(std::string{line});
+        std::sort(results.begin(), results.end());
+        for (size_t k = 0; k < results.size(); ++k) {
+            if (k != 0) {
+                batch.output += '\t';
+            }
+            batch.output += results[k];
+        }
+        batch.output += '\n';
+        ++batch.lines;
+    }
+}
+
+// Reads `in` to the end, returns the number of lines solved
+uint64_t run_pipeline(FILE *in, FILE *out, unsigned threads)
+{
+    // Caps the memory: the reader waits when that many batches are unwritten
+    const auto max_in_flight = static_cast<std::ptrdiff_t>(threads) * 4;
+    std::counting_semaphore<> in_flight{max_in_flight};
+
+    BatchQueue queue;
+    OrderedWriter writer{out};
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&queue, &writer] {
+            Solver solver; // Reused for every line this worker gets
+            while (auto batch = queue.Pop()) {
+                solve_batch(solver, *batch);
+                writer.Put(std::move(batch));
+            }
+        });
+    }
+    uint64_t lines{0};
+    std::thread writer_thread{
+        [&writer, &in_flight, &lines] { lines = writer.Run(in_flight); }};
+
+    // Reader: blocks of `block_size`, cut into batches at line boundaries
+    uint64_t seq{0};
+    auto emit = [&](std::string_view text) {
+        in_flight.acquire();
+        auto batch = std::make_unique<Batch>();
+        batch->seq = seq++;
+        batch->text.assign(text);
+        if (batch->text.back() != '\n') {
+            batch->text += '\n'; // The last line of the input
+        }
+        queue.Push(std::move(batch));
+    };
+    std::string block(block_size, '\0');
+    size_t carried{0}; // An incomplete line from the previous block
+    for (;;) {
+        const size_t read =
+            std::fread(block.data() + carried, 1, block.size() - carried, in);
+        const size_t filled = carried + read;
+        const bool eof = read == 0;
+        std::string_view text{block.data(), filled};
+        while (text.size() > batch_size || (eof && !text.empty())) {
+            auto cut = text.rfind('\n', std::min(batch_size, text.size() - 1));
+            if (cut == std::string_view::npos) {
+                cut = text.find('\n');
+            }
+            if (cut == std::string_view::npos) {
+                if (!eof) {
+                    break; // A line longer than a batch: read more
+                }
+                cut = text.size() - 1;
+            }
+            emit(text.substr(0, cut + 1));
+            text.remove_prefix(cut + 1);
+        }
+        if (eof) {
+            break;
+        }
+        // Keep the tail for the next block
+        carried = text.size();
+        std::memmove(block.data(), text.data(), carried);
+        if (carried == block.size()) {
+            block.resize(block.size() * 2); // A giant line
+        }
+    }
+
+    queue.Close();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    writer.Finish(seq);
+    writer_thread.join();
+    return lines;
+}
+
+std::string make_synthetic_input(uint64_t count)
+{
+    std::mt19937 rng{42};
+    std::string text;
+    for (uint64_t k = 0; k < count; ++k) {
+        const auto size = 4 + rng() % 13;
+        for (size_t c = 0; c < size; ++c) {
+            const auto dice = rng() % 5;
+            text += dice == 0 ? static_cast<char>('a' + rng() % 26)
+                              : (dice < 3 ? '(' : ')');
+        }
+        text += '\n';
+    }
+    return text;
+}
+
+[[noreturn]] void usage(const char *message)
+{
+    std::fprintf(stderr, "parentheses-batch: %s\n", message);
+    std::fprintf(stderr, "usage: parentheses-batch [-o <file>] [-j <threads>] "
+                         "[--generate <n>] [--synthetic <n>] [--scaling] "
+                         "[input file | -]\n");
+    std::exit(2);
+}
+
+Options parse_options(int argc, char **argv)
+{
+    Options options;
+    for (int k = 1; k < argc; ++k) {
+        const std::string_view arg{argv[k]};
+        auto value = [&] {
+            if (k + 1 >= argc) {
+                usage("missing option value");
+            }
+            return bench::size_arg(argc, argv, ++k, 0);
+        };
+        if (arg == "-o") {
+            if (k + 1 >= argc) {
+                usage("missing output file");
+            }
+            options.output = argv[++k];
+        } else if (arg == "-j") {
+            options.threads = std::max<unsigned>(1, static_cast<unsigned>(value()));
+        } else if (arg == "--generate") {
+            options.generate = value();
+        } else if (arg == "--synthetic") {
+            options.synthetic = value();
+        } else if (arg == "--scaling") {
+            options.scaling = true;
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            usage("unknown option");
+        } else {
+            options.input = argv[k];
+        }
+    }
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const auto options = parse_options(argc, argv);
+
+    if (options.generate != 0) {
+        const auto text = make_synthetic_input(options.generate);
+        std::fwrite(text.data(), 1, text.size(), stdout);
+        return 0;
+    }
+
+    // The input: synthetic, a file or stdin
+    std::string synthetic;
+    FILE *in = stdin;
+    if (options.synthetic != 0) {
+        synthetic = make_synthetic_input(options.synthetic);
+    } else if (std::strcmp(options.input, "-") != 0) {
+        in = std::fopen(options.input, "rb");
+        if (in == nullptr) {
+            std::fprintf(stderr, "parentheses-batch: can't open %s: %s\n",
+                         options.input, std::strerror(errno));
+            return 1;
+        }
+    }
+
+    if (options.scaling) {
+        // Every run needs the same input, keep it in memory
+        if (synthetic.empty()) {
+            char chunk[1 << 16];
+            for (size_t read; (read = std::fread(chunk, 1, sizeof(chunk), in));) {
+                synthetic.append(chunk, read);
+            }
+        }
+        if (synthetic.empty()) {
+            std::fprintf(stderr, "parentheses-batch: the input is empty\n");
+            return 1;
+        }
+        FILE *null_out = std::fopen("/dev/null", "wb");
+        if (null_out == nullptr) {
+            std::fprintf(stderr, "parentheses-batch: can't open /dev/null\n");
+            return 1;
+        }
+        std::vector<unsigned> counts;
+        for (unsigned threads = 1; threads < options.threads; threads *= 2) {
+            counts.push_back(threads);
+        }
+        counts.push_back(options.threads);
+
+        std::printf("%8s %12s %14s %8s\n", "threads", "lines", "lines/s",
+                    "speedup");
+        double single_rate{0};
+        for (const auto threads : counts) {
+            FILE *mem_in = fmemopen(synthetic.data(), synthetic.size(), "rb");
+            if (mem_in == nullptr) {
+                std::fprintf(stderr, "parentheses-batch: fmemopen: %s\n",
+                             std::strerror(errno));
+                return 1;
+            }
+            bench::Stopwatch sw;
+            const auto lines = run_pipeline(mem_in, null_out, threads);
+            const double rate = static_cast<double>(lines) * 1e3 / sw.elapsed_ms();
+            std::fclose(mem_in);
+            single_rate = single_rate == 0 ? rate : single_rate;
+            std::printf("%8u %12llu %14.0f %8.2f\n", threads,
+                        static_cast<unsigned long long>(lines), rate,
+                        rate / single_rate);
+        }
+        std::fclose(null_out);
+        return 0;
+    }
+
+    if (!synthetic.empty()) {
+        in = fmemopen(synthetic.data(), synthetic.size(), "rb");
+        if (in == nullptr) {
+            std::fprintf(stderr, "parentheses-batch: fmemopen: %s\n",
+                         std::strerror(errno));
+            return 1;
+        }
+    }
+    FILE *out = stdout;
+    if (options.output != nullptr) {
+        out = std::fopen(options.output, "wb");
+        if (out == nullptr) {
+            std::fprintf(stderr, "parentheses-batch: can't create %s: %s\n",
+                         options.output, std::strerror(errno));
+            return 1;
+        }
+    }
+    static char out_buffer[block_size]; // Must outlive the stream
+    std::setvbuf(out, out_buffer, _IOFBF, sizeof(out_buffer));
+
+    bench::Stopwatch sw;
+    const auto lines = run_pipeline(in, out, options.threads);
+    const double ms = sw.elapsed_ms();
+    std::fprintf(stderr, "%llu lines, %u threads, %.1f ms, %.0f lines/s\n",
+                 static_cast<unsigned long long>(lines), options.threads, ms,
+                 static_cast<double>(lines) * 1e3 / ms);
+
+    if (out != stdout) {
+        std::fclose(out);
+    }
+    if (in != stdin) {
+        std::fclose(in);
+    }
+    return 0;
+}
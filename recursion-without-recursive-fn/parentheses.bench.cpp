@@ -0,0 +1,95 @@
+// Scalar `is_well_formed` versus the 64-characters-at-a-time fast path
+//
+// Usage: parentheses.bench [string size = 1 MB] [repetitions = 200]
+
+#include <bench-utils.h>
+
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "parentheses.h"
+
+using namespace cpp_core_sandbox::bench;
+
+namespace {
+
+// A well-formed expression: a random walk over the parentheses balance which
+// never goes below zero, interleaved with letters
+std::string make_expression(size_t size, std::mt19937 &rng)
+{
+    std::string s;
+    s.reserve(size);
+    size_t balance{0};
+    while (s.size() < size) {
+        const auto remaining = size - s.size();
+        const auto dice = rng() % 4;
+        if (balance >= remaining) {
+            s.push_back(')');
+            --balance;
+        } else if (dice == 0) {
+            s.push_back('a' + static_cast<char>(rng() % 26));
+        } else if (dice == 1 || balance == 0) {
+            s.push_back('(');
+            ++balance;
+        } else {
+            s.push_back(')');
+            --balance;
+        }
+    }
+    return s;
+}
+
+template <class Fn>
+void run(const char *name, const std::string &s, size_t repetitions, Fn &&fn)
+{
+    size_t well_formed{0};
+    Stopwatch sw;
+    for (size_t k = 0; k < repetitions; ++k) {
+        const char *data = s.data();
+        do_not_optimize(data);
+        well_formed += fn(std::string_view{data, s.size()}) ? 1 : 0;
+    }
+    const double ms = sw.elapsed_ms();
+    const double bytes = static_cast<double>(s.size() * repetitions);
+    std::printf("%-24s %8.2f ms; %6.2f GB/s; well-formed %zu/%zu\n", name, ms,
+                bytes / (ms * 1e6), well_formed, repetitions);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const auto size = static_cast<size_t>(size_arg(argc, argv, 1, 1 << 20));
+    const auto repetitions = static_cast<size_t>(size_arg(argc, argv, 2, 200));
+
+    std::mt19937 rng{42};
+
+    // Cross-check both implementations on short random strings first
+    for (int k = 0; k < 100'000; ++k) {
+        std::string s(rng() % 300, 'a');
+        for (auto &ch : s) {
+            ch = "()a"[rng() % 3];
+        }
+        if (k % 2 == 0) {
+            s = make_expression(s.size() & ~size_t{1}, rng);
+            if (!s.empty()) {
+                s[rng() % s.size()] = "()a"[rng() % 3];
+            }
+        }
+        if (parentheses::is_well_formed(s) !=
+            parentheses::is_well_formed_fast(s)) {
+            std::printf("MISMATCH on \"%s\"\n", s.c_str());
+            return 1;
+        }
+    }
+
+    const std::string good = make_expression(size, rng);
+    std::printf("well-formed input, %zu bytes x %zu\n", size, repetitions);
+    run("scalar", good, repetitions,
+        [](std::string_view s) { return parentheses::is_well_formed(s); });
+    run("fast (64 per step)", good, repetitions,
+        [](std::string_view s) { return parentheses::is_well_formed_fast(s); });
+
+    return 0;
+}
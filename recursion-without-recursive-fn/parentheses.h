@@ -0,0 +1,177 @@
+#pragma once
+
+// Building blocks of the "remove invalid parentheses" solutions.
+//
+// The scalar functions are constexpr, so literal inputs can be verified at
+// compile time. `is_well_formed_fast` is a runtime fast path classifying 64
+// characters at a time.
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PARENTHESES_HAVE_SSE2 1
+#endif
+
+namespace parentheses {
+
+constexpr bool is_well_formed(std::string_view s) noexcept
+{
+    int number_of_open_p{0};
+
+    for (auto const ch : s) {
+        if (ch == '(') {
+            ++number_of_open_p;
+        } else if (ch == ')') {
+            --number_of_open_p;
+            if (number_of_open_p < 0) {
+                return false;
+            }
+        }
+    }
+
+    return number_of_open_p == 0;
+}
+
+// The same check, but characters at `skip_indices` (sorted) are ignored
+constexpr bool is_well_formed(std::string_view s,
+                              std::span<const size_t> skip_indices) noexcept
+{
+    int number_of_open_p{0};
+    auto it_pos = skip_indices.begin();
+
+    size_t pos = 0;
+    for (auto const ch : s) {
+
+        if ((it_pos != skip_indices.end() && *it_pos == pos++)) [[unlikely]] {
+            ++it_pos;
+            continue;
+        }
+        if (ch == '(') {
+            ++number_of_open_p;
+        } else if (ch == ')') {
+            --number_of_open_p;
+            if (number_of_open_p < 0) {
+                return false;
+            }
+        }
+    }
+
+    return number_of_open_p == 0;
+}
+
+constexpr size_t find_min_modifications_required(std::string_view s) noexcept
+{
+    size_t violating_closures{0};
+    size_t number_of_open_p{0};
+
+    for (auto const ch : s) {
+        if (ch == '(') {
+            ++number_of_open_p;
+        } else if (ch == ')') {
+            if (number_of_open_p > 0) {
+                --number_of_open_p;
+            } else {
+                violating_closures++;
+            }
+        }
+    }
+
+    // At the end we have:
+    // `violating_closures` - number of closing parentheses that violate the
+    // correctness of the expression;
+    // `number_of_open_p` - number of non-closed parentheses.
+    return violating_closures + number_of_open_p;
+}
+
+namespace detail {
+
+// Bit k of the masks is set if `chunk[ k ]` is '(' or ')' respectively
+struct ChunkMasks {
+    uint64_t open{0};
+    uint64_t close{0};
+};
+
+inline ChunkMasks classify64(const char *chunk) noexcept
+{
+    ChunkMasks masks;
+#if defined(PARENTHESES_HAVE_SSE2)
+    const __m128i open = _mm_set1_epi8('(');
+    const __m128i close = _mm_set1_epi8(')');
+    for (int k = 0; k < 4; ++k) {
+        const __m128i v = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(chunk + 16 * k));
+        const auto shift = 16 * k;
+        masks.open |= static_cast<uint64_t>(static_cast<uint32_t>(
+                          _mm_movemask_epi8(_mm_cmpeq_epi8(v, open))))
+                      << shift;
+        masks.close |= static_cast<uint64_t>(static_cast<uint32_t>(
+                           _mm_movemask_epi8(_mm_cmpeq_epi8(v, close))))
+                       << shift;
+    }
+#else
+    for (int k = 0; k < 64; ++k) {
+        masks.open |= static_cast<uint64_t>(chunk[k] == '(') << k;
+        masks.close |= static_cast<uint64_t>(chunk[k] == ')') << k;
+    }
+#endif
+    return masks;
+}
+
+} // namespace detail
+
+// Runtime version of `is_well_formed( s )`.
+//
+// Every 64 characters are turned into two bit masks. If the balance before the
+// chunk is at least the number of ')' in it, the balance can't go negative
+// inside, and the chunk is accounted with two popcounts. Otherwise the balance
+// is checked at every ')' as a prefix sum: opened before it minus closed up to
+// and including it.
+inline bool is_well_formed_fast(std::string_view s) noexcept
+{
+    const char *data = s.data();
+    const size_t size = s.size();
+
+    int64_t balance{0};
+    size_t pos = 0;
+    for (; pos + 64 <= size; pos += 64) {
+        const auto masks = detail::classify64(data + pos);
+        const int opened = std::popcount(masks.open);
+        const int closed = std::popcount(masks.close);
+
+        if (balance < closed) [[unlikely]] {
+            int closed_so_far{0};
+            for (uint64_t close = masks.close; close != 0;
+                 close &= close - 1) {
+                const int bit = std::countr_zero(close);
+                const uint64_t before = (uint64_t{1} << bit) - 1;
+                ++closed_so_far;
+                if (balance + std::popcount(masks.open & before) -
+                        closed_so_far <
+                    0) {
+                    return false;
+                }
+            }
+        }
+        balance += opened - closed;
+    }
+
+    // The tail is shorter than a chunk
+    for (; pos < size; ++pos) {
+        if (data[pos] == '(') {
+            ++balance;
+        } else if (data[pos] == ')') {
+            if (--balance < 0) {
+                return false;
+            }
+        }
+    }
+
+    return balance == 0;
+}
+
+} // namespace parentheses
@@ -0,0 +1,79 @@
+// The search stack of the solutions: `std::deque` versus `segmented_vector`
+//
+// Usage: solutions.bench [repetitions = 20]
+
+#include <bench-utils.h>
+#include <segmented-vector.h>
+
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <string_view>
+
+#include "solutions.h"
+
+using namespace cpp_core_sandbox;
+using namespace cpp_core_sandbox::bench;
+
+namespace {
+
+template <class T> using deque_stack = std::deque<T>;
+template <class T> using segmented_stack = segmented_vector<T>;
+
+struct Input {
+    std::string_view str;
+    bool for_solution1; // Solution1 tries every subset, it's slow on some
+};
+
+// clang-format off
+constexpr Input inputs[]{
+    {")((())))))()(((l((((", true},
+    {")()()(a)((()(((a)()", true},
+    {"(((((((((((((((((((((((((((((((((((aaaaa", false},
+    {"((()((()(()a)((()()(()((()a)())", false},
+};
+// clang-format on
+
+template <class Solution>
+double ms_per_solve(std::string_view input, uint64_t repetitions)
+{
+    Solution solution;
+    Stopwatch sw;
+    for (uint64_t k = 0; k < repetitions; ++k) {
+        auto result = solution.removeInvalidParentheses(std::string{input});
+        do_not_optimize(result);
+    }
+    return sw.elapsed_ms() / static_cast<double>(repetitions);
+}
+
+template <template <template <class> class> class Solution>
+void run(const char *name, bool solution1, uint64_t repetitions)
+{
+    for (const auto &input : inputs) {
+        if (solution1 && !input.for_solution1) {
+            continue;
+        }
+        const double deque_ms =
+            ms_per_solve<Solution<deque_stack>>(input.str, repetitions);
+        const double segmented_ms =
+            ms_per_solve<Solution<segmented_stack>>(input.str, repetitions);
+        std::printf("%-10s %-44.*s %12.3f %12.3f %8.2f\n", name,
+                    static_cast<int>(input.str.size()), input.str.data(),
+                    deque_ms, segmented_ms, deque_ms / segmented_ms);
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const uint64_t repetitions = size_arg(argc, argv, 1, 20);
+
+    std::printf("ms per solve\n");
+    std::printf("%-10s %-44s %12s %12s %8s\n", "solution", "input", "deque",
+                "segmented", "ratio");
+    run<Solution1>("Solution1", true, repetitions);
+    run<Solution2>("Solution2", false, repetitions);
+
+    return 0;
+}
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <flat-hash-set.h>
+
+#include "parentheses.h"
+
+// The search stack (a queue in fact, see the notes below) is a template
+// parameter: anything with push_back, front, pop_front and empty.
+//   Solution2<> sol;                                  // std::deque
+//   Solution2<cpp_core_sandbox::segmented_vector> sol;
+//
+// So is the set of strings. It must accept a string_view in `find`:
+//   Solution2<std::deque, cpp_core_sandbox::flat_string_set> sol;
+using unordered_string_set =
+    std::unordered_set<std::string, cpp_core_sandbox::string_hash,
+                       std::equal_to<>>;
+
+// Ideas for optimization:
+// - We can count a minimum number of changes required to make string valid,
+// so we don't need to proces those strings that contain differrent number of
+// changes.
+// - different removals may result in the same string to process. Use
+// memoization in order to skip already processed strings.
+// - there is no need to test removals of non-parentheses chars
+
+template <template <class> class Stack = std::deque,
+          class Set = unordered_string_set>
+class Solution1
+{
+    struct _RecursionContext {
+        size_t start_from{0};
+        std::vector<size_t> indices_removed;
+    };
+
+    size_t iterations_count_{0};
+    std::string candidate_; // Reused, so probing the set doesn't allocate
+
+  public:
+    std::vector<std::string> removeInvalidParentheses(std::string s)
+    {
+        iterations_count_ = 0;
+
+        // Two different modifications may result in the same result
+        Set result_set;
+
+        // Find minimum modifications required
+        auto min_mods_req = parentheses::find_min_modifications_required(s);
+        if (0 == min_mods_req) {
+            return {s};
+        }
+
+        // Prepare for recursive brute force
+        Stack<_RecursionContext> _stack;
+        _stack.push_back(_RecursionContext{});
+        for (; !_stack.empty();) {
+
+            ++iterations_count_;
+
+            // note. change stack to queue and you will have BFS instead of DFS
+            auto ctx = std::move(_stack.front());
+            _stack.pop_front();
+
+            // a. check if we are happy with current modifications
+            // Process only those modifications that are potentially good
+            if (ctx.indices_removed.size() == min_mods_req) {
+                if (parentheses::is_well_formed(s, ctx.indices_removed)) {
+                    _remove_indices(s, ctx.indices_removed, candidate_);
+                    if (result_set.find(std::string_view{candidate_}) ==
+                        result_set.end()) {
+                        result_set.insert(candidate_);
+                    }
+                }
+            }
+
+            // b. Check if we didn't exceed the count of modifications
+            if (ctx.indices_removed.size() < min_mods_req) {
+
+                // We are going to test every available position where we have a
+                // parenthesis char
+                for (size_t pos = ctx.start_from; pos < s.size(); ++pos) {
+
+                    if (s[pos] != '(' && s[pos] != ')') {
+                        continue;
+                    }
+
+                    // Push to stack further possible modifications
+                    _RecursionContext new_ctx;
+                    new_ctx.indices_removed = ctx.indices_removed;
+                    new_ctx.indices_removed.push_back(pos);
+                    new_ctx.start_from = pos + 1;
+
+                    _stack.push_back(std::move(new_ctx));
+                }
+            }
+        }
+
+        std::vector<std::string> result;
+        for (const auto &str : result_set) {
+            result.push_back(std::move(str));
+        }
+        return result;
+    }
+
+  private:
+    static void _remove_indices(const std::string &s,
+                                const std::vector<size_t> &indices,
+                                std::string &result)
+    {
+        // `indices` are considered to be sorted
+        result.clear();
+        size_t from{0};
+        for (const auto index : indices) {
+            result.append(s, from, index - from);
+            from = index + 1;
+        }
+        result.append(s, from);
+    }
+};
+
+template <template <class> class Stack = std::deque,
+          class Set = unordered_string_set>
+class Solution2
+{
+    struct _RecursionContext {
+        size_t start_from{0};
+        std::string modified_string;
+    };
+
+    Set already_visited_;
+    std::string candidate_; // Reused, so probing the set doesn't allocate
+
+  public:
+    std::vector<std::string> removeInvalidParentheses(std::string s)
+    {
+        already_visited_.clear();
+
+        // Two different modifications may result in the same result
+        Set result_set;
+
+        // Find minimum modifications required
+        auto min_mods_req = parentheses::find_min_modifications_required(s);
+        if (0 == min_mods_req) {
+            return {s};
+        }
+
+        // Prepare for recursive brute force
+        Stack<_RecursionContext> _stack;
+        _stack.push_back(_RecursionContext{0, s});
+        for (; !_stack.empty();) {
+
+            // note. change stack to queue and you will have BFS instead of DFS
+            auto ctx = std::move(_stack.front());
+            _stack.pop_front();
+
+            // a. check if we are happy with current modifications
+            // Process only those modifications that are potentially good
+            auto modifications_count = s.size() - ctx.modified_string.size();
+            if (modifications_count == min_mods_req) {
+                // Don't waste time processing strings with different
+                // modifications count
+                if (parentheses::is_well_formed_fast(ctx.modified_string)) {
+                    result_set.insert(ctx.modified_string);
+                }
+            }
+
+            // b. Check if we didn't exceed the number of modifications
+            if (modifications_count < min_mods_req) {
+
+                // We are going to test every available position where we have a
+                // parenthesis char
+                for (size_t pos = ctx.start_from;
+                     pos < ctx.modified_string.size(); ++pos) {
+
+                    if (ctx.modified_string[pos] != '(' &&
+                        ctx.modified_string[pos] != ')') {
+                        continue;
+                    }
+
+                    // The candidate is built in the scratch buffer, a new
+                    // string is allocated only for an unseen one
+                    candidate_.assign(ctx.modified_string, 0, pos);
+                    candidate_.append(ctx.modified_string, pos + 1);
+
+                    // Memoization in work. Skip those variants which were
+                    // already processed
+                    if (already_visited_.find(std::string_view{candidate_}) ==
+                        already_visited_.end()) {
+                        already_visited_.insert(candidate_);
+
+                        // Push to stack further possible modifications
+                        _stack.push_back(_RecursionContext{pos, candidate_});
+                    }
+                }
+            }
+        }
+
+        std::vector<std::string> result;
+        for (const auto &str : result_set) {
+            result.push_back(std::move(str));
+        }
+        return result;
+    }
+};
@@ -92,5 +92,28 @@ int main( void )
 
     }
 
+    {
+        // The same construction failure without exceptions.
+        // `A::TryCreate` returns either an instance or an error, nothing is thrown, so there
+        // is no unwinding at all. See unwind.bench.cpp for the price of both approaches
+
+        // The instances above have consumed sequence numbers 1..5,
+        // so the fifth instance created here is going to fail
+        A::SetCtorThrowCondition( 10 );
+        std::cout << std::dec;      // `std::hex` is still active since the first block
+
+        for( int k = 0; k < 10; ++k ) {
+            auto seq_no = A::TryCreate()
+                              .transform( [] ( const A& ) { return true; } )
+                              .transform_error( [] ( const A::CtorError& error ) { return error.seq_no; } );
+            if( !seq_no ) {
+                std::cout << "construction of A [ " << seq_no.error() << " ] has failed" << std::endl;
+                break;
+            }
+        }
+
+        A::SetCtorThrowCondition();
+    }
+
     return 0;
 }
@@ -0,0 +1,203 @@
+// The price of throwing versus returning `expected`
+//
+// An error is raised `depth` frames below the handler. Every frame holds an
+// object with a destructor, so both paths do the same cleanup. Measured:
+//  1. stack depth 1..1000, `int` payload;
+//  2. payload: an instance of A caught by value versus by reference;
+//  3. concurrent throwing from 1..N threads.
+//
+// Usage: unwind.bench [frames per measurement = 2e7] [max threads = cores]
+
+#include <bench-utils.h>
+#include <class-a.h>
+#include <expected.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace cpp_core_sandbox;
+using namespace cpp_core_sandbox::bench;
+
+namespace {
+
+thread_local uint64_t frames_cleaned{0};
+
+struct FrameGuard {
+    ~FrameGuard() { ++frames_cleaned; }
+};
+
+struct Error {
+    int code;
+};
+
+// 1. int payload
+
+[[gnu::noinline]] int throw_at_depth(int depth) {
+    FrameGuard guard;
+    if (depth == 0) {
+        throw Error{depth};
+    }
+    return throw_at_depth(depth - 1) + 1;
+}
+
+[[gnu::noinline]] expected<int, Error> fail_at_depth(int depth) {
+    FrameGuard guard;
+    if (depth == 0) {
+        return unexpected{Error{depth}};
+    }
+    auto inner = fail_at_depth(depth - 1);
+    if (!inner) {
+        return inner;
+    }
+    return *inner + 1;
+}
+
+// 2. A as the payload
+
+[[gnu::noinline]] int throw_a_at_depth(int depth) {
+    FrameGuard guard;
+    if (depth == 0) {
+        throw A{};
+    }
+    return throw_a_at_depth(depth - 1) + 1;
+}
+
+// Note: a frame returning either `inner` or a new value can't apply NRVO, so
+// the error is moved once per frame. That's the price of a fat error type
+[[gnu::noinline]] expected<int, A> fail_a_at_depth(int depth) {
+    FrameGuard guard;
+    if (depth == 0) {
+        return unexpected<A>{std::in_place};
+    }
+    auto inner = fail_a_at_depth(depth - 1);
+    if (!inner) {
+        return inner;
+    }
+    return *inner + 1;
+}
+
+// Nanoseconds per raised error
+template <class Fn> double measure(uint64_t iterations, Fn &&fn) {
+    Stopwatch sw;
+    for (uint64_t k = 0; k < iterations; ++k) {
+        fn();
+    }
+    return sw.elapsed_ns() / static_cast<double>(iterations);
+}
+
+uint64_t iterations_for(uint64_t frames_budget, int depth) {
+    return std::max<uint64_t>(100, frames_budget / static_cast<uint64_t>(depth + 1));
+}
+
+void bench_depth(uint64_t frames_budget) {
+    std::printf("1. error raised N frames deep, ns per error\n");
+    std::printf("%8s %14s %14s %8s\n", "depth", "throw/catch", "expected",
+                "ratio");
+    for (const int depth : {1, 10, 100, 1000}) {
+        const auto iterations = iterations_for(frames_budget, depth);
+        const double throw_ns = measure(iterations, [depth] {
+            try {
+                int result = throw_at_depth(depth);
+                do_not_optimize(result);
+            } catch (const Error &error) {
+                int code = error.code;
+                do_not_optimize(code);
+            }
+        });
+        const double expected_ns = measure(iterations, [depth] {
+            auto result = fail_at_depth(depth);
+            int code = result ? *result : result.error().code;
+            do_not_optimize(code);
+        });
+        std::printf("%8d %14.1f %14.1f %8.1f\n", depth, throw_ns, expected_ns,
+                    throw_ns / expected_ns);
+    }
+}
+
+void bench_payload(uint64_t frames_budget) {
+    std::printf("\n2. A as the payload, 10 frames deep, ns per error\n");
+    const int depth{10};
+    const auto iterations = iterations_for(frames_budget, depth);
+
+    const double by_value_ns = measure(iterations, [] {
+        try {
+            int result = throw_a_at_depth(depth);
+            do_not_optimize(result);
+        } catch (A by_value) { // The exception object is copied
+            do_not_optimize(by_value);
+        }
+    });
+    const double by_ref_ns = measure(iterations, [] {
+        try {
+            int result = throw_a_at_depth(depth);
+            do_not_optimize(result);
+        } catch (A &by_ref) {
+            do_not_optimize(by_ref);
+        }
+    });
+    const double expected_ns = measure(iterations, [] {
+        auto result = fail_a_at_depth(depth);
+        do_not_optimize(result);
+    });
+    std::printf("%-32s %10.1f\n", "throw A, catch by value", by_value_ns);
+    std::printf("%-32s %10.1f\n", "throw A, catch by reference", by_ref_ns);
+    std::printf("%-32s %10.1f\n", "expected< int, A >", expected_ns);
+}
+
+void bench_threads(uint64_t frames_budget, unsigned max_threads) {
+    std::printf("\n3. concurrent errors, 10 frames deep, ns per error "
+                "(per thread)\n");
+    std::printf("%8s %14s %14s\n", "threads", "throw/catch", "expected");
+    const int depth{10};
+    const auto iterations = iterations_for(frames_budget, depth);
+
+    auto run_threads = [iterations](unsigned threads, auto fn) {
+        std::vector<double> results(threads);
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&results, t, iterations, fn] {
+                results[t] = measure(iterations, fn);
+            });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        return *std::max_element(results.cbegin(), results.cend());
+    };
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        const double throw_ns = run_threads(threads, [] {
+            try {
+                int result = throw_at_depth(depth);
+                do_not_optimize(result);
+            } catch (const Error &error) {
+                int code = error.code;
+                do_not_optimize(code);
+            }
+        });
+        const double expected_ns = run_threads(threads, [] {
+            auto result = fail_at_depth(depth);
+            int code = result ? *result : result.error().code;
+            do_not_optimize(code);
+        });
+        std::printf("%8u %14.1f %14.1f\n", threads, throw_ns, expected_ns);
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const uint64_t frames_budget = size_arg(argc, argv, 1, 20'000'000);
+    const auto max_threads = static_cast<unsigned>(size_arg(
+        argc, argv, 2, std::max(1u, std::thread::hardware_concurrency())));
+
+    A::SetTraceEnabled(false);
+
+    bench_depth(frames_budget);
+    bench_payload(frames_budget);
+    bench_threads(frames_budget, max_threads);
+
+    return 0;
+}
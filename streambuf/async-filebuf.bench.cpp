@@ -0,0 +1,123 @@
+// Formatted output to a file: std::ofstream versus async_filebuf
+//
+// Every `operator<<` chain (one record) is timed on its own. std::ofstream
+// calls write(2) whenever its 8 KB buffer fills up, so that record waits for
+// the page cache; async_filebuf hands a full buffer to io_uring or to its
+// writer thread and continues into the next one.
+//
+// Throughput includes close(), i.e. all the data written to the file.
+//
+// Usage: async-filebuf.bench [records = 1e7] [file = <temp dir>/...]
+
+#include <bench-utils.h>
+
+#include "async-filebuf.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace cpp_core_sandbox;
+using namespace cpp_core_sandbox::bench;
+
+namespace {
+
+struct Latencies {
+    std::vector<uint32_t> ns;
+
+    double percentile(double p)
+    {
+        const auto k =
+            static_cast<size_t>(p * static_cast<double>(ns.size() - 1));
+        std::nth_element(ns.begin(), ns.begin() + static_cast<ptrdiff_t>(k),
+                         ns.end());
+        return ns[k];
+    }
+};
+
+// Returns the latency of every record
+template <class Stream> Latencies write_records(Stream &out, size_t records)
+{
+    using clock = std::chrono::steady_clock;
+    Latencies result;
+    result.ns.reserve(records);
+
+    for (uint64_t k = 0; k < records; ++k) {
+        const auto start = clock::now();
+        out << "record " << k << " value " << static_cast<double>(k) * 0.25
+            << '\n';
+        const auto stop = clock::now();
+        result.ns.push_back(static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start)
+                .count()));
+    }
+    return result;
+}
+
+void report(const char *name, Latencies latencies, double ms,
+            const std::filesystem::path &path, uint64_t stalls)
+{
+    const auto size = std::filesystem::file_size(path);
+    std::printf("%-22s %9.1f MB/s %8.0f %8.0f %8.0f %10.0f %8llu\n", name,
+                static_cast<double>(size) / 1e3 / ms, latencies.percentile(0.5),
+                latencies.percentile(0.99), latencies.percentile(0.999),
+                latencies.percentile(1.0),
+                static_cast<unsigned long long>(stalls));
+}
+
+void run_ofstream(size_t records, const std::filesystem::path &path)
+{
+    Stopwatch sw;
+    std::ofstream out{path};
+    auto latencies = write_records(out, records);
+    out.close();
+    report("std::ofstream", std::move(latencies), sw.elapsed_ms(), path, 0);
+}
+
+void run_async(const char *name, async_filebuf::backend kind, size_t records,
+               const std::filesystem::path &path)
+{
+    Stopwatch sw;
+    async_filebuf buf{{.kind = kind}};
+    if (buf.open(path.c_str()) == nullptr) {
+        std::printf("%-22s unavailable\n", name);
+        return;
+    }
+    std::ostream out{&buf};
+    auto latencies = write_records(out, records);
+    const uint64_t stalls = buf.stalls();
+    if (buf.close() == nullptr) {
+        std::printf("%-22s write error %d\n", name, buf.error());
+        return;
+    }
+    report(name, std::move(latencies), sw.elapsed_ms(), path, stalls);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const auto records =
+        static_cast<size_t>(size_arg(argc, argv, 1, 10'000'000));
+    const std::filesystem::path path{
+        argc > 2 ? std::filesystem::path{argv[2]}
+                 : std::filesystem::temp_directory_path() /
+                       "async-filebuf.bench.out"};
+
+    std::printf("%zu records to %s, async_filebuf with 4 x 1 MB buffers\n",
+                records, path.c_str());
+    std::printf("%-22s %14s %8s %8s %8s %10s %8s\n", "", "throughput",
+                "p50 ns", "p99 ns", "p99.9 ns", "max ns", "stalls");
+    run_ofstream(records, path);
+    run_async("async_filebuf thread", async_filebuf::backend::writer_thread,
+              records, path);
+    run_async("async_filebuf io_uring", async_filebuf::backend::io_uring,
+              records, path);
+
+    std::filesystem::remove(path);
+    return 0;
+}
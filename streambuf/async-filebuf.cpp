@@ -0,0 +1,586 @@
+#include "async-filebuf.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#define SANDBOX_HAVE_IO_URING 1
+#endif
+
+namespace cpp_core_sandbox {
+
+namespace detail {
+
+class async_writer {
+  public:
+    virtual ~async_writer(void) = default;
+
+    virtual async_filebuf::backend kind(void) const noexcept = 0;
+
+    // Starts writing `size` bytes of `data` at `offset`; never waits for the
+    // file. Returns errno, 0 on success
+    virtual int submit(unsigned id, const char *data, std::size_t size,
+                       uint64_t offset) = 0;
+
+    // Appends the ids of the finished writes to `finished`, waiting for at
+    // least one if `wait`. A failed write sets `error` unless it's set
+    // already. Returns the number of the finished writes
+    virtual std::size_t reap(bool wait, std::vector<unsigned> &finished,
+                             int &error) = 0;
+};
+
+} // namespace detail
+
+namespace {
+
+using detail::async_writer;
+
+void set_error(int &error, int value) noexcept {
+    if (error == 0) {
+        error = value;
+    }
+}
+
+// pwrite(2) on a background thread, in the order of submission
+class thread_writer final : public async_writer {
+  public:
+    explicit thread_writer(int fd) : fd_(fd), thread_([this] { _run(); }) {}
+
+    ~thread_writer(void) override {
+        {
+            std::lock_guard lock{mutex_};
+            stop_ = true;
+        }
+        work_cv_.notify_one();
+        thread_.join();
+    }
+
+    async_filebuf::backend kind(void) const noexcept override {
+        return async_filebuf::backend::writer_thread;
+    }
+
+    int submit(unsigned id, const char *data, std::size_t size,
+               uint64_t offset) override {
+        {
+            std::lock_guard lock{mutex_};
+            pending_.push_back({id, data, size, offset});
+        }
+        work_cv_.notify_one();
+        return 0;
+    }
+
+    std::size_t reap(bool wait, std::vector<unsigned> &finished,
+                     int &error) override {
+        std::unique_lock lock{mutex_};
+        if (wait) {
+            done_cv_.wait(lock, [this] { return !done_.empty(); });
+        }
+        for (const auto &completion : done_) {
+            finished.push_back(completion.id);
+            if (completion.error != 0) {
+                set_error(error, completion.error);
+            }
+        }
+        const std::size_t count = done_.size();
+        done_.clear();
+        return count;
+    }
+
+  private:
+    struct request {
+        unsigned id;
+        const char *data;
+        std::size_t size;
+        uint64_t offset;
+    };
+
+    struct completion {
+        unsigned id;
+        int error;
+    };
+
+    // Everything submitted before `stop_` is still written
+    void _run(void) {
+        std::unique_lock lock{mutex_};
+        for (;;) {
+            work_cv_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+            if (pending_.empty()) {
+                return;
+            }
+            const request next = pending_.front();
+            pending_.pop_front();
+
+            lock.unlock();
+            const int error = _write(next);
+            lock.lock();
+
+            done_.push_back({next.id, error});
+            done_cv_.notify_one();
+        }
+    }
+
+    int _write(request req) const noexcept {
+        while (req.size > 0) {
+            const ssize_t written = ::pwrite(fd_, req.data, req.size,
+                                             static_cast<off_t>(req.offset));
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return errno;
+            }
+            if (written == 0) {
+                return EIO;
+            }
+            req.data += written;
+            req.size -= static_cast<std::size_t>(written);
+            req.offset += static_cast<uint64_t>(written);
+        }
+        return 0;
+    }
+
+    int fd_;
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    std::deque<request> pending_;
+    std::vector<completion> done_;
+    bool stop_{false};
+
+    // The last one: starts after the rest is initialized
+    std::thread thread_;
+};
+
+#if defined(SANDBOX_HAVE_IO_URING)
+
+// io_uring through the raw system calls, no liburing.
+//
+// One submission queue entry per buffer, so the queue never overflows: at
+// most `entries` writes are in flight, and `io_uring_enter` consumes the
+// entries right away. The buffered writes the kernel can't complete at once
+// are finished by its own workers, the submitting thread doesn't wait
+class uring_writer final : public async_writer {
+  public:
+    // nullptr with `error` set if io_uring or IORING_OP_WRITE is unavailable
+    static std::unique_ptr<uring_writer> create(int fd, unsigned entries,
+                                                int &error) {
+        std::unique_ptr<uring_writer> result{new uring_writer{fd, entries}};
+        error = result->_setup(entries);
+        if (error != 0) {
+            result.reset();
+        }
+        return result;
+    }
+
+    ~uring_writer(void) override {
+        if (sqes_map_ != MAP_FAILED) {
+            ::munmap(sqes_map_, sqes_size_);
+        }
+        if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+            ::munmap(cq_ring_, cq_ring_size_);
+        }
+        if (sq_ring_ != MAP_FAILED) {
+            ::munmap(sq_ring_, sq_ring_size_);
+        }
+        if (ring_fd_ >= 0) {
+            ::close(ring_fd_);
+        }
+    }
+
+    async_filebuf::backend kind(void) const noexcept override {
+        return async_filebuf::backend::io_uring;
+    }
+
+    int submit(unsigned id, const char *data, std::size_t size,
+               uint64_t offset) override {
+        requests_[id] = {data, size, offset};
+        return _push(id);
+    }
+
+    std::size_t reap(bool wait, std::vector<unsigned> &finished,
+                     int &error) override {
+        std::size_t count{0};
+        for (;;) {
+            unsigned head = *cq_head_;
+            const unsigned tail =
+                std::atomic_ref{*cq_tail_}.load(std::memory_order_acquire);
+            for (; head != tail; ++head) {
+                const io_uring_cqe &cqe = cqes_[head & *cq_mask_];
+                const auto id = static_cast<unsigned>(cqe.user_data);
+                if (_complete(id, cqe.res, error)) {
+                    finished.push_back(id);
+                    ++count;
+                }
+            }
+            std::atomic_ref{*cq_head_}.store(head, std::memory_order_release);
+
+            if (count > 0 || !wait) {
+                return count;
+            }
+            if (_enter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+                set_error(error, errno);
+                return count;
+            }
+        }
+    }
+
+  private:
+    struct request {
+        const char *data;
+        std::size_t size;
+        uint64_t offset;
+    };
+
+    // The most write(2) does at once (MAX_RW_COUNT), sqe.len is 32-bit anyway
+    static constexpr std::size_t max_write{0x7ffff000};
+
+    uring_writer(int fd, unsigned entries) : fd_(fd), requests_(entries) {}
+
+    int _setup(unsigned entries) {
+        io_uring_params params{};
+        ring_fd_ = static_cast<int>(
+            ::syscall(__NR_io_uring_setup, entries, &params));
+        if (ring_fd_ < 0) {
+            return errno;
+        }
+        if (!_supports_write()) {
+            return EOPNOTSUPP;
+        }
+
+        sq_ring_size_ =
+            params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size_ =
+            params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap) {
+            sq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+            cq_ring_size_ = sq_ring_size_;
+        }
+        sq_ring_ = _map(sq_ring_size_, IORING_OFF_SQ_RING);
+        cq_ring_ =
+            single_mmap ? sq_ring_ : _map(cq_ring_size_, IORING_OFF_CQ_RING);
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_map_ = _map(sqes_size_, IORING_OFF_SQES);
+        if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED ||
+            sqes_map_ == MAP_FAILED) {
+            return errno;
+        }
+        sqes_ = static_cast<io_uring_sqe *>(sqes_map_);
+
+        auto *sq = static_cast<char *>(sq_ring_);
+        sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        auto *cq = static_cast<char *>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+        return 0;
+    }
+
+    // IORING_OP_WRITE came with Linux 5.6, as did the probe
+    bool _supports_write(void) const {
+        constexpr unsigned ops{IORING_OP_LAST};
+        std::vector<uint64_t> storage(
+            (sizeof(io_uring_probe) + ops * sizeof(io_uring_probe_op)) /
+                sizeof(uint64_t) +
+            1);
+        auto *probe = reinterpret_cast<io_uring_probe *>(storage.data());
+        if (::syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_PROBE,
+                      probe, ops) < 0) {
+            return false;
+        }
+        return probe->last_op >= IORING_OP_WRITE &&
+               (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED);
+    }
+
+    void *_map(std::size_t size, uint64_t offset) const noexcept {
+        return ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd_,
+                      static_cast<off_t>(offset));
+    }
+
+    int _enter(unsigned to_submit, unsigned min_complete,
+               unsigned flags) const noexcept {
+        return static_cast<int>(::syscall(__NR_io_uring_enter, ring_fd_,
+                                          to_submit, min_complete, flags,
+                                          nullptr, 0));
+    }
+
+    // The single producer: no one else moves the tail
+    int _push(unsigned id) {
+        const request &req = requests_[id];
+        const unsigned tail = *sq_tail_;
+        const unsigned index = tail & *sq_mask_;
+
+        io_uring_sqe &sqe = sqes_[index];
+        sqe = io_uring_sqe{};
+        sqe.opcode = IORING_OP_WRITE;
+        sqe.fd = fd_;
+        sqe.addr = reinterpret_cast<uint64_t>(req.data);
+        // A longer write completes short and the rest is resubmitted
+        sqe.len = static_cast<uint32_t>(std::min(req.size, max_write));
+        sqe.off = req.offset;
+        sqe.user_data = id;
+        sq_array_[index] = index;
+        std::atomic_ref{*sq_tail_}.store(tail + 1, std::memory_order_release);
+
+        while (_enter(1, 0, 0) < 0) {
+            if (errno != EINTR) {
+                return errno;
+            }
+        }
+        return 0;
+    }
+
+    // Whether the write `id` is over; a short one is resubmitted
+    bool _complete(unsigned id, int result, int &error) {
+        request &req = requests_[id];
+        if (result == -EAGAIN || result == -EINTR) {
+            result = 0;
+        } else if (result < 0) {
+            set_error(error, -result);
+            return true;
+        } else if (result == 0) {
+            set_error(error, EIO);
+            return true;
+        }
+
+        const auto written = static_cast<std::size_t>(result);
+        req.data += written;
+        req.size -= written;
+        req.offset += written;
+        if (req.size == 0) {
+            return true;
+        }
+        if (const int push_error = _push(id); push_error != 0) {
+            set_error(error, push_error);
+            return true;
+        }
+        return false;
+    }
+
+    int fd_;
+    int ring_fd_{-1};
+    std::vector<request> requests_;
+
+    void *sq_ring_{MAP_FAILED};
+    void *cq_ring_{MAP_FAILED};
+    void *sqes_map_{MAP_FAILED};
+    std::size_t sq_ring_size_{0};
+    std::size_t cq_ring_size_{0};
+    std::size_t sqes_size_{0};
+
+    unsigned *sq_tail_{nullptr};
+    unsigned *sq_mask_{nullptr};
+    unsigned *sq_array_{nullptr};
+    unsigned *cq_head_{nullptr};
+    unsigned *cq_tail_{nullptr};
+    unsigned *cq_mask_{nullptr};
+    io_uring_sqe *sqes_{nullptr};
+    io_uring_cqe *cqes_{nullptr};
+};
+
+#endif
+
+std::unique_ptr<async_writer> make_writer(async_filebuf::backend kind, int fd,
+                                          unsigned entries) {
+#if defined(SANDBOX_HAVE_IO_URING)
+    if (kind != async_filebuf::backend::writer_thread) {
+        int error{0};
+        if (auto writer = uring_writer::create(fd, entries, error)) {
+            return writer;
+        }
+        if (kind == async_filebuf::backend::io_uring) {
+            return nullptr;
+        }
+    }
+#else
+    (void)entries;
+    if (kind == async_filebuf::backend::io_uring) {
+        return nullptr;
+    }
+#endif
+    return std::make_unique<thread_writer>(fd);
+}
+
+} // namespace
+
+async_filebuf::async_filebuf(void) : async_filebuf(options{}) {}
+
+async_filebuf::async_filebuf(const options &opts) : options_(opts) {
+    options_.buffer_size = std::max<std::size_t>(options_.buffer_size, 1);
+    options_.buffers = std::max<std::size_t>(options_.buffers, 1);
+    buffers_.reserve(options_.buffers);
+    for (std::size_t k = 0; k < options_.buffers; ++k) {
+        buffers_.push_back(
+            std::make_unique_for_overwrite<char[]>(options_.buffer_size));
+    }
+    free_.reserve(options_.buffers);
+}
+
+async_filebuf::~async_filebuf(void) { close(); }
+
+async_filebuf *async_filebuf::open(const char *path) {
+    if (is_open()) {
+        return nullptr;
+    }
+    fd_ = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        return nullptr;
+    }
+    writer_ = make_writer(options_.kind, fd_,
+                          static_cast<unsigned>(options_.buffers));
+    if (!writer_) {
+        ::close(fd_);
+        fd_ = -1;
+        return nullptr;
+    }
+
+    free_.clear();
+    for (auto k = static_cast<unsigned>(options_.buffers); k-- > 0;) {
+        free_.push_back(k);
+    }
+    has_current_ = false;
+    in_flight_ = 0;
+    offset_ = 0;
+    stalls_ = 0;
+    error_ = 0;
+    setp(nullptr, nullptr);
+    return this;
+}
+
+async_filebuf *async_filebuf::close(void) {
+    if (!is_open()) {
+        return nullptr;
+    }
+    const bool written = _drain();
+    if (in_flight_ > 0) {
+        _abandon_in_flight();
+    }
+    writer_.reset();
+    const bool closed = ::close(fd_) == 0;
+    fd_ = -1;
+    return written && closed ? this : nullptr;
+}
+
+async_filebuf::backend async_filebuf::active_backend(void) const noexcept {
+    return writer_ ? writer_->kind() : backend::automatic;
+}
+
+async_filebuf::int_type async_filebuf::overflow(int_type ch) {
+    if (!is_open() || error_ != 0 || !_submit_current() || !_acquire_buffer()) {
+        return traits_type::eof();
+    }
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+        return traits_type::not_eof(ch);
+    }
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+    return ch;
+}
+
+int async_filebuf::sync(void) {
+    if (!is_open()) {
+        return 0;
+    }
+    return _drain() ? 0 : -1;
+}
+
+bool async_filebuf::_submit_current(void) {
+    if (!has_current_) {
+        return true;
+    }
+    const auto size = static_cast<std::size_t>(pptr() - pbase());
+    has_current_ = false;
+    setp(nullptr, nullptr);
+    if (size == 0) {
+        free_.push_back(current_);
+        return true;
+    }
+
+    const int error =
+        writer_->submit(current_, buffers_[current_].get(), size, offset_);
+    if (error != 0) {
+        error_ = error;
+        free_.push_back(current_);
+        return false;
+    }
+    offset_ += size;
+    ++in_flight_;
+    return true;
+}
+
+bool async_filebuf::_acquire_buffer(void) {
+    // Pick up whatever has finished, it costs no system call with io_uring
+    _reap(false);
+    if (free_.empty()) {
+        ++stalls_;
+        while (free_.empty() && error_ == 0) {
+            _reap(true);
+        }
+    }
+    if (free_.empty()) {
+        return false;
+    }
+
+    current_ = free_.back();
+    free_.pop_back();
+    has_current_ = true;
+    char *buffer = buffers_[current_].get();
+    setp(buffer, buffer + options_.buffer_size);
+    return error_ == 0;
+}
+
+void async_filebuf::_reap(bool wait) {
+    if (in_flight_ == 0) {
+        return;
+    }
+    in_flight_ -= writer_->reap(wait, free_, error_);
+}
+
+// The kernel may still read the buffers of the writes whose completions are
+// lost, and tearing the ring down doesn't wait for them. Those buffers are
+// leaked on purpose, fresh ones take their place
+void async_filebuf::_abandon_in_flight(void) {
+    std::vector<bool> in_flight(buffers_.size(), true);
+    for (const unsigned k : free_) {
+        in_flight[k] = false;
+    }
+    for (std::size_t k = 0; k < buffers_.size(); ++k) {
+        if (in_flight[k]) {
+            (void)buffers_[k].release();
+            buffers_[k] =
+                std::make_unique_for_overwrite<char[]>(options_.buffer_size);
+        }
+    }
+    in_flight_ = 0;
+}
+
+bool async_filebuf::_drain(void) {
+    _submit_current();
+    while (in_flight_ > 0) {
+        const std::size_t before = in_flight_;
+        _reap(true);
+        if (in_flight_ == before && error_ != 0) {
+            // The ring itself has failed, nothing more will complete: see
+            // _abandon_in_flight
+            break;
+        }
+    }
+    return error_ == 0;
+}
+
+} // namespace cpp_core_sandbox
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <streambuf>
+#include <vector>
+
+namespace cpp_core_sandbox {
+
+namespace detail {
+// Submits the writes and receives their completions: io_uring or a thread
+class async_writer;
+} // namespace detail
+
+// An output file buffer which doesn't block the formatting thread on write(2).
+//
+// The put area is one of N buffers. When it fills up (or on `sync()`), the
+// buffer is handed to the kernel as a single write at its own file offset,
+// and formatting continues into the next free buffer right away. The
+// formatting thread waits only when all N buffers are in flight.
+//
+// The writes go through io_uring when the kernel allows it, otherwise a
+// background thread issues `pwrite(2)` for them. Either way completions may
+// come in any order, every buffer knows where it belongs in the file.
+//
+//   async_filebuf buf;
+//   buf.open("out.txt");
+//   std::ostream out{&buf};
+//   out << "value: " << 42 << '\n';
+//
+// Like `std::filebuf`, `sync()` (std::flush) waits until the data is written
+// to the file (not to the disk: no fsync), and a write error makes `overflow`
+// and `sync` fail, which sets badbit on the stream.
+class async_filebuf : public std::streambuf {
+  public:
+    enum class backend {
+        automatic, // io_uring, the thread if io_uring is unavailable
+        io_uring,
+        writer_thread,
+    };
+
+    struct options {
+        std::size_t buffer_size{std::size_t{1} << 20};
+        std::size_t buffers{4};
+        backend kind{backend::automatic};
+    };
+
+    async_filebuf(void);
+    explicit async_filebuf(const options &opts);
+    ~async_filebuf(void) override;
+
+    async_filebuf(const async_filebuf &) = delete;
+    async_filebuf &operator=(const async_filebuf &) = delete;
+
+    // Creates or truncates the file. Returns nullptr on failure, including
+    // an explicitly requested backend which can't be used
+    async_filebuf *open(const char *path);
+
+    // Writes out everything and closes the file. Returns nullptr if a write
+    // has failed or the file isn't open
+    async_filebuf *close(void);
+
+    bool is_open(void) const noexcept { return fd_ >= 0; }
+
+    // The one in use, `automatic` when the file isn't open
+    backend active_backend(void) const noexcept;
+
+    // How many times the formatting thread had to wait for a free buffer
+    uint64_t stalls(void) const noexcept { return stalls_; }
+
+    // errno of the first failed write, 0 if none
+    int error(void) const noexcept { return error_; }
+
+  protected:
+    int_type overflow(int_type ch) override;
+    int sync(void) override;
+
+  private:
+    // Submits the put area if it has anything and switches to a free buffer
+    bool _submit_current(void);
+    bool _acquire_buffer(void);
+    // Collects the finished writes, waiting for at least one if `wait`
+    void _reap(bool wait);
+    // Submits the put area and waits for all the writes
+    bool _drain(void);
+    // Gives up on the writes which will never complete
+    void _abandon_in_flight(void);
+
+    options options_;
+    std::vector<std::unique_ptr<char[]>> buffers_;
+    std::vector<unsigned> free_; // Indices of buffers_
+    unsigned current_{0};
+    bool has_current_{false};
+    std::size_t in_flight_{0};
+
+    std::unique_ptr<detail::async_writer> writer_;
+    int fd_{-1};
+    uint64_t offset_{0};
+    uint64_t stalls_{0};
+    int error_{0};
+};
+
+} // namespace cpp_core_sandbox
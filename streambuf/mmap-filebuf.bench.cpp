@@ -0,0 +1,161 @@
+// Parsing a large text file of integers
+//
+// 1. std::ifstream >> int: `underflow` copies the file into the stream buffer
+//    and `num_get` parses with the locale, one virtual call after another.
+// 2. std::istream >> int over mmap_filebuf: no copies, the same `num_get`.
+// 3. number_reader over mmap_filebuf: no copies, `std::from_chars`.
+//
+// The file is generated first, so it is in the page cache as long as it fits
+// in memory; otherwise every variant also waits for the disk.
+//
+// Usage: mmap-filebuf.bench [bytes = 5e9] [file = <temp dir>/...]
+
+#include <bench-utils.h>
+
+#include "mmap-filebuf.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <system_error>
+
+using namespace cpp_core_sandbox;
+using namespace cpp_core_sandbox::bench;
+
+namespace {
+
+// Integers of every length from -1e9 to 1e9, separated by spaces and newlines
+bool generate(const std::filesystem::path &path, size_t bytes)
+{
+    FILE *file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    constexpr size_t chunk_size{1 << 20};
+    auto chunk = std::make_unique<char[]>(chunk_size + 32);
+
+    uint64_t state{0x9e3779b97f4a7c15};
+    size_t written{0};
+    while (written < bytes) {
+        size_t used{0};
+        while (used < chunk_size && written + used < bytes) {
+            state = state * 6364136223846793005 + 1442695040888963407;
+            const auto digits = static_cast<int>((state >> 60) % 10);
+            int value{static_cast<int>((state >> 20) % 1'000'000'000)};
+            for (int k = 9; k > digits; --k) {
+                value /= 10;
+            }
+            if (state & 0x100) {
+                value = -value;
+            }
+            char *end =
+                std::to_chars(&chunk[used], &chunk[used + 16], value).ptr;
+            *end++ = (state & 0x1f00) == 0 ? '\n' : ' ';
+            used = static_cast<size_t>(end - chunk.get());
+        }
+        if (std::fwrite(chunk.get(), 1, used, file) != used) {
+            std::fclose(file);
+            return false;
+        }
+        written += used;
+    }
+    return std::fclose(file) == 0;
+}
+
+void report(const char *name, double ms, size_t bytes, size_t count,
+            int64_t sum)
+{
+    std::printf("%-32s %9.1f ms %9.1f MB/s %12zu numbers, sum %lld\n", name, ms,
+                static_cast<double>(bytes) / 1e3 / ms, count,
+                static_cast<long long>(sum));
+}
+
+// Removes the generated file however main() returns
+struct TempFile {
+    std::filesystem::path path;
+
+    ~TempFile()
+    {
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+};
+
+template <class Stream>
+void run_stream(const char *name, Stream &in, size_t bytes)
+{
+    Stopwatch sw;
+    int64_t sum{0};
+    size_t count{0};
+    for (int value; in >> value;) {
+        sum += value;
+        ++count;
+    }
+    report(name, sw.elapsed_ms(), bytes, count, sum);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const auto bytes =
+        static_cast<size_t>(size_arg(argc, argv, 1, 5'000'000'000));
+    const std::filesystem::path path{
+        argc > 2 ? std::filesystem::path{argv[2]}
+                 : std::filesystem::temp_directory_path() /
+                       "mmap-filebuf.bench.txt"};
+    const TempFile temp_file{path};
+
+    Stopwatch sw;
+    if (!generate(path, bytes)) {
+        std::perror(path.c_str());
+        return 1;
+    }
+    const auto size = static_cast<size_t>(std::filesystem::file_size(path));
+    std::printf("%s: %zu MB generated in %.0f ms\n", path.c_str(), size >> 20,
+                sw.elapsed_ms());
+
+    {
+        std::ifstream in{path};
+        run_stream("std::ifstream >> int", in, size);
+    }
+    {
+        mmap_filebuf buf;
+        if (buf.open(path.c_str()) == nullptr) {
+            std::perror(path.c_str());
+            return 1;
+        }
+        std::istream in{&buf};
+        run_stream("std::istream(mmap_filebuf) >> int", in, size);
+    }
+    {
+        Stopwatch parse;
+        mmap_filebuf buf;
+        if (buf.open(path.c_str()) == nullptr) {
+            std::perror(path.c_str());
+            return 1;
+        }
+        number_reader reader{buf.view()};
+        int64_t sum{0};
+        size_t count{0};
+        for (int value; reader >> value;) {
+            sum += value;
+            ++count;
+        }
+        if (!reader.eof()) {
+            // Not null-terminated: the view may end where the mapping does
+            const auto rest = reader.rest();
+            std::printf("parse error at: %.*s\n",
+                        static_cast<int>(std::min<size_t>(rest.size(), 20)),
+                        rest.data());
+        }
+        report("number_reader(mmap_filebuf)", parse.elapsed_ms(), size, count,
+               sum);
+    }
+
+    return 0;
+}
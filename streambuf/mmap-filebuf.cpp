@@ -0,0 +1,92 @@
+#include "mmap-filebuf.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cpp_core_sandbox {
+
+mmap_filebuf::~mmap_filebuf(void) { close(); }
+
+mmap_filebuf *mmap_filebuf::open(const char *path) {
+    if (is_open()) {
+        return nullptr;
+    }
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    size_ = static_cast<std::size_t>(info.st_size);
+    if (size_ > 0) {
+        void *data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            ::close(fd);
+            return nullptr;
+        }
+        // Aggressive read-ahead, and the pages behind may go early
+        ::madvise(data, size_, MADV_SEQUENTIAL);
+        data_ = data;
+    }
+    // The mapping holds the file on its own
+    ::close(fd);
+
+    // The get area is never written to, `std::streambuf` just wants `char *`
+    char *begin = static_cast<char *>(data_);
+    setg(begin, begin, begin + size_);
+    is_open_ = true;
+    return this;
+}
+
+mmap_filebuf *mmap_filebuf::close(void) {
+    if (!is_open()) {
+        return nullptr;
+    }
+    if (data_ != nullptr) {
+        ::munmap(data_, size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    is_open_ = false;
+    setg(nullptr, nullptr, nullptr);
+    return this;
+}
+
+std::streamsize mmap_filebuf::showmanyc(void) {
+    // -1: `underflow` would fail, the whole file is in the get area already
+    return gptr() == egptr() ? -1 : egptr() - gptr();
+}
+
+mmap_filebuf::pos_type mmap_filebuf::seekoff(off_type off,
+                                             std::ios_base::seekdir dir,
+                                             std::ios_base::openmode which) {
+    if (!is_open() || !(which & std::ios_base::in)) {
+        return pos_type(off_type(-1));
+    }
+    off_type base{0};
+    if (dir == std::ios_base::cur) {
+        base = gptr() - eback();
+    } else if (dir == std::ios_base::end) {
+        base = static_cast<off_type>(size_);
+    }
+    return seekpos(pos_type(base + off), which);
+}
+
+mmap_filebuf::pos_type mmap_filebuf::seekpos(pos_type pos,
+                                             std::ios_base::openmode which) {
+    const auto offset = static_cast<off_type>(pos);
+    if (!is_open() || !(which & std::ios_base::in) || offset < 0 ||
+        offset > static_cast<off_type>(size_)) {
+        return pos_type(off_type(-1));
+    }
+    setg(eback(), eback() + offset, egptr());
+    return pos;
+}
+
+} // namespace cpp_core_sandbox
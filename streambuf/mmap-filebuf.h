@@ -0,0 +1,137 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <streambuf>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+namespace cpp_core_sandbox {
+
+// An input file buffer over a read-only mapping of the whole file.
+//
+// The get area is the mapping itself: `underflow` is never needed, nothing is
+// copied, and the kernel reads the file ahead as the pages are touched.
+// `std::istream` works on top of it as usual. For parsing without the
+// stream and its locale, `view()` gives the unread bytes to `number_reader`.
+//
+//   mmap_filebuf buf;
+//   buf.open("numbers.txt");
+//   number_reader reader{buf.view()};
+//   for (long value; reader >> value;) { ... }
+class mmap_filebuf : public std::streambuf {
+  public:
+    mmap_filebuf(void) = default;
+    ~mmap_filebuf(void) override;
+
+    mmap_filebuf(const mmap_filebuf &) = delete;
+    mmap_filebuf &operator=(const mmap_filebuf &) = delete;
+
+    // Returns nullptr if the file can't be opened or mapped. An empty file
+    // is fine, there is just nothing to read
+    mmap_filebuf *open(const char *path);
+    mmap_filebuf *close(void);
+
+    bool is_open(void) const noexcept { return is_open_; }
+
+    // From the current read position to the end of the file
+    std::string_view view(void) const noexcept {
+        return {gptr(), static_cast<std::size_t>(egptr() - gptr())};
+    }
+
+    // The whole file
+    std::size_t size(void) const noexcept { return size_; }
+
+  protected:
+    std::streamsize showmanyc(void) override;
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                     std::ios_base::openmode which) override;
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+
+  private:
+    void *data_{nullptr};
+    std::size_t size_{0};
+    bool is_open_{false};
+};
+
+// Whitespace separated numbers parsed with `std::from_chars`: no locale, no
+// copies, no virtual calls per character. Reads like an istream:
+//
+//   number_reader reader{text};
+//   int a;
+//   double b;
+//   reader >> a >> b;
+//   if (!reader) { ... }
+//
+// Stricter than `operator>>` of a stream: a token must be a number up to the
+// next whitespace, so "12abc" is a failure rather than 12 followed by "abc".
+// Like `std::from_chars` it doesn't accept a leading '+'. After a failure
+// nothing more is read, the value is left as it was and the position stays
+// at the offending token.
+class number_reader {
+  public:
+    explicit number_reader(std::string_view text) noexcept
+        : next_{text.data()}, end_{text.data() + text.size()} {}
+
+    template <class T>
+        requires std::is_arithmetic_v<T> && (!std::is_same_v<T, bool>)
+    number_reader &operator>>(T &value) noexcept {
+        if (failed_) {
+            return *this;
+        }
+        _skip_spaces();
+        if (next_ == end_) {
+            failed_ = true;
+            at_end_ = true;
+            return *this;
+        }
+        T parsed;
+        const auto [ptr, ec] = std::from_chars(next_, end_, parsed);
+        if (ec != std::errc{} || (ptr != end_ && !_is_space(*ptr))) {
+            failed_ = true;
+            return *this;
+        }
+        value = parsed;
+        next_ = ptr;
+        return *this;
+    }
+
+    // The next whitespace separated token, empty at the end
+    std::string_view token(void) noexcept {
+        _skip_spaces();
+        const char *start = next_;
+        while (next_ != end_ && !_is_space(*next_)) {
+            ++next_;
+        }
+        return {start, static_cast<std::size_t>(next_ - start)};
+    }
+
+    explicit operator bool(void) const noexcept { return !failed_; }
+
+    // Failed because there was nothing but whitespace left
+    bool eof(void) const noexcept { return at_end_; }
+
+    // The unread text
+    std::string_view rest(void) const noexcept {
+        return {next_, static_cast<std::size_t>(end_ - next_)};
+    }
+
+  private:
+    static bool _is_space(char ch) noexcept {
+        return ch == ' ' || (ch >= '\t' && ch <= '\r');
+    }
+
+    void _skip_spaces(void) noexcept {
+        while (next_ != end_ && _is_space(*next_)) {
+            ++next_;
+        }
+    }
+
+    const char *next_;
+    const char *end_;
+    bool failed_{false};
+    bool at_end_{false};
+};
+
+} // namespace cpp_core_sandbox
@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+#include <unistd.h>
+
+#include "async-filebuf.h"
+#include "mmap-filebuf.h"
+
+using namespace cpp_core_sandbox;
+
+namespace cpp_core_sandbox {
+
+// Test names and failure messages
+void PrintTo(async_filebuf::backend backend, std::ostream *os) {
+    switch (backend) {
+    case async_filebuf::backend::automatic:
+        *os << "automatic";
+        return;
+    case async_filebuf::backend::io_uring:
+        *os << "io_uring";
+        return;
+    case async_filebuf::backend::writer_thread:
+        *os << "writer_thread";
+        return;
+    }
+    *os << static_cast<int>(backend);
+}
+
+} // namespace cpp_core_sandbox
+
+namespace {
+
+std::string read_file(const std::filesystem::path &path) {
+    std::ifstream in{path, std::ios::binary};
+    return {std::istreambuf_iterator<char>{in}, {}};
+}
+
+class AsyncFilebuf : public testing::TestWithParam<async_filebuf::backend> {
+  protected:
+    void TearDown(void) override { std::filesystem::remove(path_); }
+
+    // Tiny buffers, so that every test rotates them many times
+    async_filebuf::options small_buffers(void) const {
+        return {.buffer_size = 64, .buffers = 3, .kind = GetParam()};
+    }
+
+    const std::filesystem::path path_{
+        std::filesystem::temp_directory_path() /
+        ("async-filebuf.g." + std::to_string(::getpid()) + ".txt")};
+};
+
+} // namespace
+
+TEST_P(AsyncFilebuf, WritesEverythingInOrder) {
+    async_filebuf buf{small_buffers()};
+    ASSERT_NE(buf.open(path_.c_str()), nullptr);
+    EXPECT_NE(buf.active_backend(), async_filebuf::backend::automatic);
+
+    std::ostream out{&buf};
+    std::ostringstream expected;
+    for (int k = 0; k < 10'000; ++k) {
+        out << "line " << k << ": " << k * 0.5 << '\n';
+        expected << "line " << k << ": " << k * 0.5 << '\n';
+    }
+    EXPECT_TRUE(out.good());
+    EXPECT_NE(buf.close(), nullptr);
+    EXPECT_EQ(read_file(path_), expected.str());
+}
+
+TEST_P(AsyncFilebuf, FlushWaitsForTheFile) {
+    async_filebuf buf{small_buffers()};
+    ASSERT_NE(buf.open(path_.c_str()), nullptr);
+    std::ostream out{&buf};
+
+    const std::string first(1000, 'x');
+    out << first << std::flush;
+    EXPECT_EQ(read_file(path_), first);
+
+    // Smaller than a buffer
+    out << "tail" << std::flush;
+    EXPECT_EQ(read_file(path_), first + "tail");
+}
+
+TEST_P(AsyncFilebuf, ReopenTruncates) {
+    async_filebuf buf{small_buffers()};
+    ASSERT_NE(buf.open(path_.c_str()), nullptr);
+    EXPECT_EQ(buf.open(path_.c_str()), nullptr); // Already open
+    std::ostream out{&buf};
+    out << std::string(500, 'a');
+    ASSERT_NE(buf.close(), nullptr);
+    EXPECT_EQ(buf.close(), nullptr); // Already closed
+
+    ASSERT_NE(buf.open(path_.c_str()), nullptr);
+    out << "b";
+    ASSERT_NE(buf.close(), nullptr);
+    EXPECT_EQ(read_file(path_), "b");
+}
+
+TEST_P(AsyncFilebuf, WriteErrorSetsBadbit) {
+    async_filebuf buf{small_buffers()};
+    // Every write fails with ENOSPC
+    if (buf.open("/dev/full") == nullptr) {
+        GTEST_SKIP() << "no /dev/full";
+    }
+    std::ostream out{&buf};
+    out << std::string(1000, 'x') << std::flush;
+    EXPECT_TRUE(out.bad());
+    EXPECT_EQ(buf.error(), ENOSPC);
+    EXPECT_EQ(buf.close(), nullptr);
+}
+
+// `automatic` is io_uring where the kernel allows it
+INSTANTIATE_TEST_SUITE_P(
+    Backends, AsyncFilebuf,
+    testing::Values(async_filebuf::backend::automatic,
+                    async_filebuf::backend::writer_thread),
+    [](const testing::TestParamInfo<async_filebuf::backend> &info) {
+        return testing::PrintToString(info.param);
+    });
+
+TEST(AsyncFilebufOpen, FailsForMissingDirectory) {
+    async_filebuf buf;
+    EXPECT_EQ(buf.open("/nonexistent-directory/file.txt"), nullptr);
+    EXPECT_FALSE(buf.is_open());
+}
+
+namespace {
+
+class MmapFilebuf : public testing::Test {
+  protected:
+    void TearDown(void) override { std::filesystem::remove(path_); }
+
+    void write_file(std::string_view text) {
+        std::ofstream{path_, std::ios::binary} << text;
+    }
+
+    const std::filesystem::path path_{
+        std::filesystem::temp_directory_path() /
+        ("mmap-filebuf.g." + std::to_string(::getpid()) + ".txt")};
+};
+
+} // namespace
+
+TEST_F(MmapFilebuf, WorksUnderIstream) {
+    write_file("10 -20\n30 text");
+    mmap_filebuf buf;
+    ASSERT_NE(buf.open(path_.c_str()), nullptr);
+    EXPECT_EQ(buf.size(), 14u);
+
+    std::istream in{&buf};
+    int a{0}, b{0}, c{0};
+    std::string word;
+    in >> a >> b >> c >> word;
+    EXPECT_EQ(a + b + c, 20);
+    EXPECT_EQ(word, "text");
+    EXPECT_TRUE(in.eof());
+
+    in.clear();
+    in.seekg(3);
+    in >> b;
+    EXPECT_EQ(b, -20);
+    EXPECT_EQ(buf.view(), "\n30 text");
+}
+
+TEST_F(MmapFilebuf, EmptyAndMissingFiles) {
+    write_file("");
+    mmap_filebuf buf;
+    ASSERT_NE(buf.open(path_.c_str()), nullptr);
+    EXPECT_TRUE(buf.view().empty());
+    EXPECT_NE(buf.close(), nullptr);
+
+    EXPECT_EQ(buf.open("/nonexistent-directory/file.txt"), nullptr);
+    EXPECT_FALSE(buf.is_open());
+}
+
+TEST(NumberReader, ParsesIntegersAndFloats) {
+    number_reader reader{"  42\t-7\n3.5 1e3 18446744073709551615\n"};
+    int a{0}, b{0};
+    double c{0}, d{0};
+    uint64_t e{0};
+    EXPECT_TRUE(reader >> a >> b >> c >> d >> e);
+    EXPECT_EQ(a, 42);
+    EXPECT_EQ(b, -7);
+    EXPECT_EQ(c, 3.5);
+    EXPECT_EQ(d, 1000.0);
+    EXPECT_EQ(e, UINT64_MAX);
+
+    EXPECT_FALSE(reader >> a);
+    EXPECT_TRUE(reader.eof());
+}
+
+TEST(NumberReader, StopsAtABadToken) {
+    number_reader reader{"1 2x 3"};
+    int value{0};
+    EXPECT_TRUE(reader >> value);
+    EXPECT_FALSE(reader >> value);
+    EXPECT_FALSE(reader.eof());
+    EXPECT_EQ(value, 1);
+    EXPECT_EQ(reader.rest(), "2x 3");
+
+    number_reader overflow{"300"};
+    int8_t small{0};
+    EXPECT_FALSE(overflow >> small);
+
+    number_reader tokens{" a bc  "};
+    EXPECT_EQ(tokens.token(), "a");
+    EXPECT_EQ(tokens.token(), "bc");
+    EXPECT_EQ(tokens.token(), "");
+}
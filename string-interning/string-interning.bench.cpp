@@ -0,0 +1,138 @@
+// Interned strings versus per-instance copies
+//
+// 1. Memory and construction time of N instances of A (three string copies
+//    each) and of InternedA (three 4-byte handles each).
+// 2. Throughput of `StringPool::Intern` for a few thousand distinct strings
+//    looked up concurrently from 1..N threads.
+//
+// Usage: string-interning.bench [instances = 1e7] [max threads = cores]
+
+#include <bench-utils.h>
+#include <class-a-interned.h>
+#include <class-a.h>
+#include <string-pool.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+using namespace cpp_core_sandbox;
+using namespace cpp_core_sandbox::bench;
+
+namespace {
+
+// Bytes allocated from the heap and not freed yet
+size_t heap_in_use(void)
+{
+#if defined(__GLIBC__)
+    const auto info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+size_t resident_bytes(void)
+{
+    std::ifstream statm{"/proc/self/statm"};
+    size_t total_pages{0};
+    size_t resident_pages{0};
+    statm >> total_pages >> resident_pages;
+    return resident_pages * 4096;
+}
+
+template <class T> void run_instances(const char *name, size_t count)
+{
+    const auto heap_before = heap_in_use();
+    const auto rss_before = resident_bytes();
+
+    Stopwatch sw;
+    {
+        std::vector<T> instances;
+        instances.reserve(count);
+        for (size_t k = 0; k < count; ++k) {
+            instances.emplace_back();
+        }
+        const double ms = sw.elapsed_ms();
+
+        const auto heap = heap_in_use() - heap_before;
+        // RSS may shrink when the previous run released its memory
+        const auto rss = static_cast<double>(resident_bytes()) -
+                         static_cast<double>(rss_before);
+        std::printf("%-10s sizeof %3zu; construct %8.1f ms (%5.1f ns each); "
+                    "heap %8.1f MB (%5.1f B each); rss %+8.1f MB\n",
+                    name, sizeof(T), ms, ms * 1e6 / static_cast<double>(count),
+                    static_cast<double>(heap) / 1e6,
+                    static_cast<double>(heap) / static_cast<double>(count),
+                    rss / 1e6);
+    }
+}
+
+void run_concurrent_lookups(unsigned max_threads)
+{
+    constexpr size_t distinct{4000};
+    constexpr size_t lookups_per_thread{2'000'000};
+
+    std::vector<std::string> strings;
+    for (size_t k = 0; k < distinct; ++k) {
+        strings.push_back("payload string #" + std::to_string(k * 7919));
+    }
+
+    std::printf("\nIntern() of %zu distinct strings, %zu lookups per thread\n",
+                distinct, lookups_per_thread);
+    std::printf("%8s %16s %12s\n", "threads", "Mlookups/s", "ns/lookup");
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        StringPool pool;
+        std::vector<std::thread> workers;
+        Stopwatch sw;
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&pool, &strings, t] {
+                uint64_t sum{0};
+                for (size_t k = 0; k < lookups_per_thread; ++k) {
+                    const auto &str = strings[(k * 31 + t * 17) % distinct];
+                    sum += pool.View(pool.Intern(str)).size();
+                }
+                do_not_optimize(sum);
+            });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        const double ns = sw.elapsed_ns();
+        const double total = static_cast<double>(lookups_per_thread * threads);
+        std::printf("%8u %16.2f %12.1f\n", threads, total / ns * 1e3,
+                    ns / static_cast<double>(lookups_per_thread));
+        if (pool.Size() != distinct) {
+            std::printf("UNEXPECTED pool size %zu\n", pool.Size());
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const auto count = static_cast<size_t>(size_arg(argc, argv, 1, 10'000'000));
+    const auto max_threads = static_cast<unsigned>(size_arg(
+        argc, argv, 2, std::max(1u, std::thread::hardware_concurrency())));
+
+    A::SetTraceEnabled(false);
+
+    std::printf("%zu instances\n", count);
+    run_instances<A>("A", count);
+    run_instances<InternedA>("InternedA", count);
+    std::printf("string pool: %zu strings, %zu bytes\n",
+                StringPool::Global().Size(), StringPool::Global().BytesUsed());
+
+    run_concurrent_lookups(max_threads);
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+// `std::vector< poly_value< Base1 > >` versus `std::vector< std::unique_ptr< Base1 > >`
+//
+// The hierarchy mirrors Base1/Derived1/Derived2 from sfinae.cpp, but `_do()`
+// returns a value instead of printing. Objects of the three types are mixed
+// in random order, then the container is built and iterated.
+//
+// Usage: poly-value.bench [objects = 1e7]
+
+#include <bench-utils.h>
+#include <poly-value.h>
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace cpp_core_sandbox;
+using namespace cpp_core_sandbox::bench;
+
+namespace {
+
+struct Base1 {
+    virtual ~Base1() = default; // Required by unique_ptr< Base1 > only
+    virtual int _do() { return 1; }
+};
+struct Derived1 : public Base1 {
+    int _do() override { return payload_; }
+    int payload_{2};
+};
+struct Derived2 : Derived1 {
+    int _do() override { return payload_ + extra_; }
+    int extra_{3};
+};
+
+template <class Container, class Make>
+void run(const char *name, const std::vector<int> &kinds, Make &&make) {
+    Stopwatch sw;
+    Container objects;
+    objects.reserve(kinds.size());
+    for (const int kind : kinds) {
+        objects.push_back(make(kind));
+    }
+    const double build_ms = sw.elapsed_ms();
+
+    // A couple of passes, the first one warms up caches
+    long long sum{0};
+    double iterate_ms{0};
+    for (int pass = 0; pass < 3; ++pass) {
+        sw.restart();
+        for (auto &obj : objects) {
+            sum += obj->_do();
+        }
+        do_not_optimize(sum);
+        iterate_ms = sw.elapsed_ms();
+    }
+
+    std::printf("%-32s build %9.1f ms; iterate %8.1f ms (%.2f ns/object); "
+                "checksum %lld\n",
+                name, build_ms, iterate_ms,
+                iterate_ms * 1e6 / static_cast<double>(kinds.size()), sum);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const auto count = static_cast<size_t>(size_arg(argc, argv, 1, 10'000'000));
+
+    std::vector<int> kinds(count);
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<int> dist{0, 2};
+    for (auto &kind : kinds) {
+        kind = dist(rng);
+    }
+
+    using value_type = poly_value<Base1>;
+    std::printf("%zu objects; sizeof( poly_value< Base1 > ) = %zu; "
+                "sizeof( Derived2 ) = %zu\n",
+                count, sizeof(value_type), sizeof(Derived2));
+
+    run<std::vector<std::unique_ptr<Base1>>>(
+        "vector< unique_ptr< Base1 > >", kinds,
+        [](int kind) -> std::unique_ptr<Base1> {
+            switch (kind) {
+            case 0:
+                return std::make_unique<Base1>();
+            case 1:
+                return std::make_unique<Derived1>();
+            default:
+                return std::make_unique<Derived2>();
+            }
+        });
+
+    run<std::vector<value_type>>("vector< poly_value< Base1 > >", kinds,
+                                 [](int kind) -> value_type {
+                                     switch (kind) {
+                                     case 0:
+                                         return Base1{};
+                                     case 1:
+                                         return Derived1{};
+                                     default:
+                                         return Derived2{};
+                                     }
+                                 });
+
+    return 0;
+}
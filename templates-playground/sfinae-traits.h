@@ -0,0 +1,98 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+#if defined(__cpp_concepts)
+#include <concepts>
+#endif
+
+// The traits of sfinae.cpp, shared with the generated translation units of
+// trait-compile.bench.cpp
+
+// Check that two pointers are convertible from Dptr to Bptr
+template <class Bptr, class Dptr> struct _is_convertible_to_base_ptr {
+    // Technical types `yes` and `no`. They have different size
+    typedef char yes;
+    typedef struct {
+        char _hide_[2];
+    } no;
+
+    static auto check(Bptr) -> yes; // Note that no one method is implemented,
+                                    // all we need is just their signatures
+    static auto check(...) -> no;   // Ellipsis has the least priority
+
+    static auto get_derived()
+        -> Dptr; // Note. Instead of defining this meta-function, we can use
+                 // std::declval<Dptr>()
+
+    enum {
+        value =
+            sizeof(yes) ==
+                sizeof(check(
+                    get_derived())) // Check that check( Bptr ) is instantiated
+            && !std::is_same<Bptr, void*>::value
+    };
+
+    // The same could be done via constexpr
+    static constexpr bool value_alt =
+        sizeof(yes) ==
+            sizeof(check(
+                get_derived())) // Check that check( Bptr ) is instantiated
+        && !std::is_same<Bptr, void*>::value;
+};
+
+// Wrapper struct
+template <class Base, class Derived> struct is_convertible_to_base {
+    enum { value = _is_convertible_to_base_ptr<Base*, Derived*>::value_alt };
+};
+
+// Primary template with a static assertion
+// for a meaningful error message
+// if it ever gets instantiated.
+// We could leave it undefined if we didn't care.
+
+template <typename, typename T, typename... Args> struct has_serialize {
+    static_assert(std::integral_constant<T, false>::value,
+                  "Second template parameter needs to be of function type.");
+};
+
+// Specialization that does the checking
+template <typename C, typename Ret, typename... Args>
+struct has_serialize<C, Ret(Args...)> {
+  private:
+    template <typename T>
+    static constexpr auto check(T*) -> typename std::is_same<
+        decltype(std::declval<T>().serialize(std::declval<Args>()...)),
+        Ret      // ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
+        >::type; // attempt to call it and see if the return type is correct
+
+    template <typename> static constexpr std::false_type check(...);
+
+    typedef decltype(check<C>(nullptr)) type;
+
+  public:
+    static constexpr bool value = type::value;
+};
+
+#if defined(__cpp_concepts)
+
+// C++20 counterparts: a `requires` expression does what the overload
+// resolution tricks above do
+
+template <class Base, class Derived>
+concept convertible_to_base = requires(Derived* derived) {
+    { derived } -> std::convertible_to<Base*>;
+} && !std::is_same<Base, void>::value;
+
+template <typename C, typename Signature> struct has_serialize_requires;
+
+template <typename C, typename Ret, typename... Args>
+struct has_serialize_requires<C, Ret(Args...)> {
+    static constexpr bool value = requires {
+        { std::declval<C>().serialize(std::declval<Args>()...) }
+            -> std::same_as<Ret>;
+    };
+};
+
+#endif
@@ -5,47 +5,13 @@
 #include <type_traits>
 #include <vector>
 
+#include "sfinae-traits.h"
+
 //    E x a m p l e   # 1
 //
 // Compile time check to determine if the first class is open derived from the
-// second class (note: private derivation doesn't work here and breaks the code)
-
-// Check that two pointers are convertible from Dptr to Bptr
-template <class Bptr, class Dptr> struct _is_convertible_to_base_ptr {
-    // Technical types `yes` and `no`. They have different size
-    typedef char yes;
-    typedef struct {
-        char _hide_[2];
-    } no;
-
-    static auto check(Bptr) -> yes; // Note that no one method is implemented,
-                                    // all we need is just their signatures
-    static auto check(...) -> no;   // Ellipsis has the least priority
-
-    static auto get_derived()
-        -> Dptr; // Note. Instead of defining this meta-function, we can use
-                 // std::declval<Dptr>()
-
-    enum {
-        value =
-            sizeof(yes) ==
-                sizeof(check(
-                    get_derived())) // Check that check( Bptr ) is instantiated
-            && !std::is_same<Bptr, void*>::value
-    };
-
-    // The same could be done via constexpr
-    static constexpr bool value_alt =
-        sizeof(yes) ==
-            sizeof(check(
-                get_derived())) // Check that check( Bptr ) is instantiated
-        && !std::is_same<Bptr, void*>::value;
-};
-
-// Wrapper struct
-template <class Base, class Derived> struct is_convertible_to_base {
-    enum { value = _is_convertible_to_base_ptr<Base*, Derived*>::value_alt };
-};
+// second class (note: private derivation doesn't work here and breaks the code).
+// See `is_convertible_to_base` in sfinae-traits.h
 
 struct Base1 {
     virtual void _do() { return; }
@@ -94,35 +60,8 @@ void _do_sfinae_example1()
 
 //    E x a m p l e   # 2
 //
-// Check if the class has method with certain signature
-
-// Primary template with a static assertion
-// for a meaningful error message
-// if it ever gets instantiated.
-// We could leave it undefined if we didn't care.
-
-template <typename, typename T, typename... Args> struct has_serialize {
-    static_assert(std::integral_constant<T, false>::value,
-                  "Second template parameter needs to be of function type.");
-};
-
-// Specialization that does the checking
-template <typename C, typename Ret, typename... Args>
-struct has_serialize<C, Ret(Args...)> {
-  private:
-    template <typename T>
-    static constexpr auto check(T*) -> typename std::is_same<
-        decltype(std::declval<T>().serialize(std::declval<Args>()...)),
-        Ret      // ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
-        >::type; // attempt to call it and see if the return type is correct
-
-    template <typename> static constexpr std::false_type check(...);
-
-    typedef decltype(check<C>(nullptr)) type;
-
-  public:
-    static constexpr bool value = type::value;
-};
+// Check if the class has method with certain signature: `has_serialize` in
+// sfinae-traits.h
 
 void _do_sfinae_example2()
 {
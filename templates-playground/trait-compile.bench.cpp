@@ -0,0 +1,232 @@
+// Compile-time cost of the traits of sfinae-traits.h
+//
+// For N synthetic types a translation unit checks with static_assert that
+// every type is convertible to its base and not to another one, and whether
+// it has `int serialize(const std::string &)` (half of them do): three traits
+// per type in every variant:
+//
+//   types only  the type definitions, the baseline
+//   sfinae      is_convertible_to_base and has_serialize: sizeof and decltype
+//   std         std::is_convertible, serialize_returns_int
+//   std base_of std::is_base_of, serialize_returns_int
+//   requires    C++20 convertible_to_base and has_serialize_requires
+//
+// serialize_returns_int is written with std::invoke_result in the unit itself:
+// std::is_invocable_r would accept any return type convertible to int.
+//
+// Each unit is compiled with -fsyntax-only by the compiler the sandbox is
+// built with; CPU time and peak memory of the compiler come from wait4().
+//
+// Usage: trait-compile.bench [max N = 10000] [runs = 1]
+
+#include <bench-utils.h>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace cpp_core_sandbox::bench;
+
+namespace {
+
+enum class Variant { kTypesOnly, kSfinae, kStd, kStdBaseOf, kRequires };
+
+constexpr Variant variants[]{Variant::kTypesOnly, Variant::kSfinae,
+                             Variant::kStd, Variant::kStdBaseOf,
+                             Variant::kRequires};
+
+const char *variant_name(Variant variant)
+{
+    switch (variant) {
+    case Variant::kTypesOnly:
+        return "types only";
+    case Variant::kSfinae:
+        return "sfinae";
+    case Variant::kStd:
+        return "std";
+    case Variant::kStdBaseOf:
+        return "std base_of";
+    case Variant::kRequires:
+        return "requires";
+    }
+    return "";
+}
+
+std::string check(Variant variant, size_t k, size_t n)
+{
+    const auto type = "type_" + std::to_string(k);
+    const auto base = "base_" + std::to_string(k);
+    const auto other = "base_" + std::to_string((k + 1) % n);
+    const char *serializable = k % 2 == 0 ? "" : "!";
+    const std::string signature = "int(const std::string &)";
+
+    switch (variant) {
+    case Variant::kTypesOnly:
+        return {};
+    case Variant::kSfinae:
+        return "static_assert(is_convertible_to_base<" + base + ", " + type +
+               ">::value && !is_convertible_to_base<" + other + ", " + type +
+               ">::value && " + serializable + "has_serialize<" + type + ", " +
+               signature + ">::value, \"\");\n";
+    case Variant::kStd:
+        return "static_assert(std::is_convertible<" + type + " *, " + base +
+               " *>::value && !std::is_convertible<" + type + " *, " + other +
+               " *>::value && " + serializable + "serialize_returns_int<" +
+               type + ">::value, \"\");\n";
+    case Variant::kStdBaseOf:
+        return "static_assert(std::is_base_of<" + base + ", " + type +
+               ">::value && !std::is_base_of<" + other + ", " + type +
+               ">::value && " + serializable + "serialize_returns_int<" +
+               type + ">::value, \"\");\n";
+    case Variant::kRequires:
+        return "static_assert(convertible_to_base<" + base + ", " + type +
+               "> && !convertible_to_base<" + other + ", " + type + "> && " +
+               serializable + "has_serialize_requires<" + type + ", " +
+               signature + ">::value);\n";
+    }
+    return {};
+}
+
+void generate(const std::filesystem::path &path, Variant variant, size_t n)
+{
+    std::ofstream out{path};
+    out << "#include \"sfinae-traits.h\"\n"
+           "#include <string>\n"
+           "#include <type_traits>\n\n"
+           // Calls `serialize` of whatever it's given, for std::invoke_result
+           "struct serialize_fn {\n"
+           "    template <class T>\n"
+           "    auto operator()(T &t, const std::string &s) const\n"
+           "        -> decltype(t.serialize(s)) { return t.serialize(s); }\n"
+           "};\n\n"
+           // invoke_result has no `type` if serialize_fn can't be called
+           "template <class T, class = void>\n"
+           "struct serialize_returns_int : std::false_type {};\n"
+           "template <class T>\n"
+           "struct serialize_returns_int<\n"
+           "    T, std::void_t<std::invoke_result_t<serialize_fn, T &,\n"
+           "                                        const std::string &>>>\n"
+           "    : std::is_same<std::invoke_result_t<serialize_fn, T &,\n"
+           "                                        const std::string &>,\n"
+           "                   int> {};\n\n";
+    for (size_t k = 0; k < n; ++k) {
+        out << "struct base_" << k << " {};\n";
+        out << "struct type_" << k << " : base_" << k << " {";
+        if (k % 2 == 0) {
+            out << " int serialize(const std::string &);";
+        }
+        out << " };\n";
+    }
+    out << '\n';
+    for (size_t k = 0; k < n; ++k) {
+        out << check(variant, k, n);
+    }
+}
+
+struct CompileCost {
+    double cpu_ms;
+    double peak_mb;
+};
+
+// Compiles `source` in a child process. False if the compiler has failed
+bool compile(const std::filesystem::path &source, CompileCost &cost)
+{
+    const std::string include = "-I" SANDBOX_TRAITS_DIR;
+    const std::string file = source.string();
+    std::vector<const char *> args{SANDBOX_CXX_COMPILER, "-std=c++20",
+                                   "-fsyntax-only",      include.c_str(),
+                                   file.c_str(),         nullptr};
+
+    const pid_t pid = fork();
+    if (pid < 0) {
+        std::perror("fork");
+        return false;
+    }
+    if (pid == 0) {
+        execv(args[0], const_cast<char *const *>(args.data()));
+        std::perror(args[0]);
+        _exit(127);
+    }
+
+    int status{0};
+    rusage usage{};
+    if (wait4(pid, &status, 0, &usage) != pid) {
+        std::perror("wait4");
+        return false;
+    }
+    auto ms = [](const timeval &tv) {
+        return static_cast<double>(tv.tv_sec) * 1e3 +
+               static_cast<double>(tv.tv_usec) / 1e3;
+    };
+    cost.cpu_ms = ms(usage.ru_utime) + ms(usage.ru_stime);
+    cost.peak_mb = static_cast<double>(usage.ru_maxrss) / 1024.0; // KB
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const auto max_n = static_cast<size_t>(size_arg(argc, argv, 1, 10'000));
+    const auto runs = std::max<size_t>(1, size_arg(argc, argv, 2, 1));
+
+    const auto dir = std::filesystem::temp_directory_path() /
+                     ("trait-compile.bench." + std::to_string(getpid()));
+    std::filesystem::create_directories(dir);
+
+    std::printf("%s -std=c++20 -fsyntax-only, the best of %zu\n",
+                SANDBOX_CXX_COMPILER, runs);
+    std::printf("%8s %-12s %10s %10s %14s %10s\n", "N", "variant", "cpu ms",
+                "peak MB", "traits ms", "per type");
+
+    int result{0};
+    for (size_t n = 100; n <= max_n && result == 0; n *= 10) {
+        for (const size_t count : {n, n * 3}) {
+            if (count > max_n || result != 0) {
+                continue;
+            }
+            double baseline_ms{0};
+            for (const auto variant : variants) {
+                const auto source =
+                    dir / (std::string{variant_name(variant)} + "-" +
+                           std::to_string(count) + ".cpp");
+                generate(source, variant, count);
+
+                CompileCost best{1e300, 1e300};
+                for (size_t run = 0; run < runs; ++run) {
+                    CompileCost cost{};
+                    if (!compile(source, cost)) {
+                        std::printf("failed to compile %s\n", source.c_str());
+                        result = 1;
+                        break;
+                    }
+                    best.cpu_ms = std::min(best.cpu_ms, cost.cpu_ms);
+                    best.peak_mb = std::min(best.peak_mb, cost.peak_mb);
+                }
+                if (result != 0) {
+                    break;
+                }
+
+                if (variant == Variant::kTypesOnly) {
+                    baseline_ms = best.cpu_ms;
+                }
+                // What the traits add to the type definitions
+                const double traits_ms = best.cpu_ms - baseline_ms;
+                std::printf("%8zu %-12s %10.0f %10.1f %14.0f %8.1f us\n", count,
+                            variant_name(variant), best.cpu_ms, best.peak_mb,
+                            traits_ms,
+                            traits_ms * 1e3 / static_cast<double>(count));
+            }
+        }
+    }
+
+    std::filesystem::remove_all(dir);
+    return result;
+}